@@ -0,0 +1,488 @@
+#include "AppBenchmarks.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "LightManager.h"
+#include "PBRMaterial.h"
+#include "Texture.h"
+#include "DDSFile.h"
+#include "OBJFile.h"
+#include "ModelImporter.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "SceneGraph.h"
+#include "JobSystem.h"
+#include "DrawList.h"
+
+namespace {
+	//camera uniforms of every shader, like the render loop sets them
+	void setCameraUniforms(std::vector<std::shared_ptr<Shader>>& shaders, Camera& camera)
+	{
+		for (std::shared_ptr<Shader> shader : shaders)
+		{
+			shader->use();
+			shader->setUniform("viewProjectionMatrix", camera.getViewProjectionMatrix());
+			shader->setUniform("cameraPosition", camera.getPosition());
+		}
+	}
+
+	//layers of overlapping spheres with random PBR materials, lots of overdraw
+	void createBenchmarkScene(std::shared_ptr<Shader>& shader, std::vector<std::unique_ptr<Geometry>>& spheres, std::vector<Geometry*>& geometries)
+	{
+		GeometryData sphereData = Geometry::createSphereGeometry(0.8f, 32, 16);
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+		for (int layer = 0; layer < 4; ++layer)
+		{
+			for (int x = -3; x <= 3; ++x)
+			{
+				for (int y = -3; y <= 3; ++y)
+				{
+					glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(x * 1.2f + layer * 0.3f, y * 1.2f + layer * 0.3f, -layer * 1.5f));
+					std::shared_ptr<Material> material = std::make_shared<PBRMaterial>(shader, glm::vec3(dist(rng), dist(rng), dist(rng)), dist(rng), dist(rng));
+					spheres.push_back(std::make_unique<Geometry>(modelMatrix, sphereData, material));
+					geometries.push_back(spheres.back().get());
+				}
+			}
+		}
+	}
+
+	//average time of a frame in ms after some warm up frames, waits for the GPU with vsync turned off
+	double measureFrameTime(GLFWwindow* window, int frames, const std::function<void()>& renderFrame)
+	{
+		const int warmupFrames = 10;
+		glfwSwapInterval(0);
+		double start = 0;
+		for (int frame = -warmupFrames; frame < frames; ++frame)
+		{
+			if (frame == 0)
+			{
+				glFinish();
+				start = glfwGetTime();
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderFrame();
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		glFinish();
+		return 1000.0 * (glfwGetTime() - start) / frames;
+	}
+
+	//peak resident set size of the process in bytes
+	size_t peakResidentSetSize()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return size_t(usage.ru_maxrss) * 1024;
+#endif
+	}
+
+	//writes a torus with about the given number of triangles as '.obj'
+	void writeTorusOBJ(const std::string& file, unsigned int triangles)
+	{
+		unsigned int tubeSections = 1000, circleSections = std::max(3u, triangles / (2 * tubeSections));
+		GeometryData torus = Geometry::createTorusGeometry(1.0f, 0.3f, tubeSections, circleSections);
+		std::ofstream out(file);
+		for (const glm::vec3& position : torus.positions) out << "v " << position.x << " " << position.y << " " << position.z << "\n";
+		for (const glm::vec3& normal : torus.normals) out << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+		for (size_t i = 0; i + 2 < torus.indices.size(); i += 3)
+		{
+			out << "f " << torus.indices[i] + 1 << "//" << torus.indices[i] + 1 << " " << torus.indices[i + 1] + 1 << "//" << torus.indices[i + 1] + 1
+				<< " " << torus.indices[i + 2] + 1 << "//" << torus.indices[i + 2] + 1 << "\n";
+		}
+	}
+}
+
+/*
+ Renders a scene with heavy overdraw with a growing number of point lights,
+ forward and deferred, and prints the frame times to find the crossover point
+*/
+void lightCountBenchmark(GLFWwindow* window, std::shared_ptr<Shader>& phongPBR, DeferredRenderer& deferredRenderer, Camera& camera, const ForwardPass& renderForward, bool depthPrepass, int frames)
+{
+	std::vector<std::shared_ptr<Shader>> shaders = { phongPBR };
+	std::vector<std::unique_ptr<Geometry>> spheres;
+	std::vector<Geometry*> geometries;
+	createBenchmarkScene(phongPBR, spheres, geometries);
+	camera.update(0, 0, 12.0f, false, false);
+
+	std::cout << "Light count benchmark, " << geometries.size() << " spheres, " << frames << " frames"
+		<< (depthPrepass ? ", forward with depth pre-pass" : "") << std::endl;
+	std::cout << "lights\tforward ms\tdeferred ms" << std::endl;
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+	LightManager lights;
+	int crossover = -1;
+	for (int lightCount = 1; lightCount <= LightManager::maxPointLights; lightCount *= 2)
+	{
+		lights.clear();
+		for (int i = 0; i < lightCount; ++i)
+		{
+			glm::vec3 position = glm::vec3(dist(rng) * 10.0f - 5.0f, dist(rng) * 10.0f - 5.0f, dist(rng) * 4.0f);
+			lights.createPointLight(glm::vec3(dist(rng), dist(rng), dist(rng)), position, glm::vec3(0.1f, 0.2f, 1.0f));
+		}
+
+		double forwardTime = measureFrameTime(window, frames, [&]() {
+			lights.setUniforms(shaders);
+			setCameraUniforms(shaders, camera);
+			renderForward(geometries);
+		});
+		double deferredTime = measureFrameTime(window, frames, [&]() {
+			deferredRenderer.render(geometries, lights, camera);
+		});
+		std::cout << lightCount << "\t" << forwardTime << "\t\t" << deferredTime << std::endl;
+		if (crossover < 0 && deferredTime < forwardTime)
+		{
+			crossover = lightCount;
+		}
+	}
+	if (crossover > 0)
+	{
+		std::cout << "Deferred is faster from " << crossover << " point lights on." << std::endl;
+	}
+	else
+	{
+		std::cout << "Forward was faster for all light counts." << std::endl;
+	}
+}
+
+/*
+ Compares the forward PBR shader with hardware sRGB conversion against a variant
+ that encodes its output with pow(1/2.2) per fragment (SOFTWARE_SRGB)
+*/
+void srgbBenchmark(GLFWwindow* window, std::shared_ptr<Shader>& phongPBR, ImageBasedLighting& imageBasedLighting, Camera& camera, int frames)
+{
+	std::shared_ptr<Shader> softwareSrgb = std::make_shared<Shader>("PBR_shader_phong.vert", "PBR_shader_phong.frag", std::vector<std::string>{ "SOFTWARE_SRGB" });
+	std::vector<std::shared_ptr<Shader>> variants = { phongPBR, softwareSrgb };
+	imageBasedLighting.setUniforms(variants);
+	camera.update(0, 0, 12.0f, false, false);
+
+	LightManager lights;
+	lights.createPointLight(glm::vec3(1.0f), glm::vec3(0.0f, 3.0f, 4.0f), glm::vec3(0.1f, 0.2f, 1.0f));
+	lights.createDirectionalLight(glm::vec3(0.8f), glm::vec3(0.0f, -1.0f, -1.0f));
+
+	double frameTimes[2];
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		std::vector<std::shared_ptr<Shader>> shaders = { variants[variant] };
+		std::vector<std::unique_ptr<Geometry>> spheres;
+		std::vector<Geometry*> geometries;
+		createBenchmarkScene(variants[variant], spheres, geometries);
+		if (variant == 1) glDisable(GL_FRAMEBUFFER_SRGB);
+		frameTimes[variant] = measureFrameTime(window, frames, [&]() {
+			lights.setUniforms(shaders);
+			setCameraUniforms(shaders, camera);
+			for (Geometry* geometry : geometries)
+			{
+				geometry->draw();
+			}
+		});
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	}
+	std::cout << "sRGB benchmark, " << frames << " frames" << std::endl;
+	std::cout << "hardware sRGB: " << frameTimes[0] << "ms, per fragment pow: " << frameTimes[1] << "ms" << std::endl;
+}
+
+/*
+ Uploads every '.dds' in assets/textures repeat times, from a file mapping or from
+ a heap copy of the file like the framework's loadDDS, and prints time and peak memory
+*/
+void textureLoadBenchmark(bool mapped, int repeat)
+{
+	const std::vector<std::string> files = {
+		"bricks_diffuse", "bricks_specular", "metal_texture", "wood_texture",
+		"cubemap/posx", "cubemap/negx", "cubemap/posy", "cubemap/negy", "cubemap/posz", "cubemap/negz"
+	};
+	size_t peakBefore = peakResidentSetSize();
+	size_t bytes = 0;
+	int textures = 0;
+	glFinish();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < repeat; ++i)
+	{
+		for (const std::string& file : files)
+		{
+			std::string path = "./assets/textures/" + file + ".dds";
+			DDSTexture img;
+			std::vector<unsigned char> copy;
+			if (mapped)
+			{
+				if (!loadDDSFile(path, img)) continue;
+				bytes += img.file->getSize();
+			}
+			else
+			{
+				std::ifstream in(path, std::ios::binary | std::ios::ate);
+				if (!in) continue;
+				copy.resize(size_t(in.tellg()));
+				in.seekg(0);
+				in.read(reinterpret_cast<char*>(copy.data()), copy.size());
+				if (!parseDDS(copy.data(), copy.size(), img)) continue;
+				bytes += copy.size();
+			}
+			Texture texture(img);
+			++textures;
+		}
+	}
+	glFinish();
+	std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Texture load benchmark (" << (mapped ? "mapped" : "copy") << "), " << textures << " textures, "
+		<< bytes / (1024 * 1024) << " MB: " << loadTime.count() << "ms, " << bytes / (1024.0 * 1024.0) / (loadTime.count() / 1000.0) << " MB/s, peak RSS "
+		<< peakResidentSetSize() / (1024 * 1024) << " MB (" << peakBefore / (1024 * 1024) << " MB before)" << std::endl;
+}
+
+/*
+ Cooks a generated '.obj' into a '.mesh', then compares parsing the text against
+ mapping the binary file, both uploaded into a Geometry
+*/
+void meshLoadBenchmark(unsigned int triangles)
+{
+	const std::string objFile = "./mesh_benchmark.obj", meshFile = "./mesh_benchmark.mesh";
+	writeTorusOBJ(objFile, triangles);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	GeometryData cooked;
+	loadOBJ(objFile, cooked);
+	cooked.indices = MeshOptimizer::optimizeVertexCache(cooked.indices, cooked.positions.size());
+	MeshOptimizer::optimizeVertexFetch(cooked);
+	MeshFile::save(meshFile, cooked);
+	std::chrono::duration<double, std::milli> cookTime = std::chrono::high_resolution_clock::now() - start;
+
+	std::shared_ptr<Material> material = std::make_shared<Material>(std::shared_ptr<Shader>());
+	glFinish();
+	start = std::chrono::high_resolution_clock::now();
+	GeometryData parsed;
+	loadOBJ(objFile, parsed);
+	std::chrono::duration<double, std::milli> parseTime = std::chrono::high_resolution_clock::now() - start;
+	{
+		Geometry geometry(glm::mat4(1.0f), parsed, material);
+		glFinish();
+	}
+	std::chrono::duration<double, std::milli> objTime = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	MeshFile::Mesh mesh;
+	bool mapped = MeshFile::load(meshFile, mesh);
+	std::chrono::duration<double, std::milli> mapTime = std::chrono::high_resolution_clock::now() - start;
+	if (mapped)
+	{
+		Geometry geometry(glm::mat4(1.0f), mesh, material);
+		glFinish();
+	}
+	std::chrono::duration<double, std::milli> meshTime = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "Mesh load benchmark, " << parsed.indices.size() / 3 << " triangles, " << parsed.positions.size() << " vertices (cooking took " << cookTime.count() << "ms)" << std::endl;
+	std::cout << "  .obj:  " << parseTime.count() << "ms parse, " << objTime.count() << "ms with upload" << std::endl;
+	if (mapped)
+	{
+		std::cout << "  .mesh: " << mapTime.count() << "ms map, " << meshTime.count() << "ms with upload, " << mesh.header.lodCount << " levels of detail, "
+			<< mesh.header.meshletCount << " meshlets, " << objTime.count() / meshTime.count() << "x faster" << std::endl;
+	}
+	else
+	{
+		std::cout << "  .mesh: failed to write " << meshFile << std::endl;
+	}
+	std::remove(objFile.c_str());
+	std::remove(meshFile.c_str());
+}
+
+void modelImportBenchmark(const std::string& file, unsigned int triangles)
+{
+	bool generated = file == "generated";
+	std::string source = generated ? "./import_benchmark.obj" : file;
+	if (generated) writeTorusOBJ(source, triangles);
+
+	struct Run {
+		const char* name;
+		ImportSettings settings;
+	};
+	ImportSettings single, parallel, streaming;
+	single.threadCount = 1;
+	streaming.streaming = true;
+	std::vector<Run> runs = { { "mapped, 1 thread", single }, { "mapped, parallel", parallel }, { "streaming, parallel", streaming } };
+
+	std::cout << "Model import benchmark, " << source << " (" << importThreadCount(parallel) << " hardware threads)" << std::endl;
+	for (const Run& run : runs)
+	{
+		ImportedModel model;
+		auto start = std::chrono::high_resolution_clock::now();
+		bool imported = importModel(source, model, run.settings);
+		std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+		if (!imported)
+		{
+			std::cout << "  " << run.name << ": failed" << std::endl;
+			break;
+		}
+		size_t triangleCount = 0;
+		for (const GeometryData& mesh : model.meshes) triangleCount += mesh.indices.size() / 3;
+		std::cout << "  " << run.name << ": " << time.count() * 1000.0 << "ms, " << model.sourceSize / (1024.0 * 1024.0) / time.count() << "MB/s, "
+			<< triangleCount << " triangles, " << model.meshes.size() << " meshes, " << model.materials.size() << " materials" << std::endl;
+	}
+	if (generated) std::remove(source.c_str());
+}
+
+void sceneGraphBenchmark(int nodeCount, int frames)
+{
+	//a forest of small trees: roots with 4 children each, which have 4 children each
+	SceneGraph graph;
+	std::vector<SceneGraph::Node> roots;
+	std::vector<glm::mat4> localMatrices;
+	glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.5f, 0.0f));
+	while (int(graph.size()) < nodeCount)
+	{
+		SceneGraph::Node root = graph.addNode(glm::translate(glm::mat4(1.0f), glm::vec3(float(roots.size()), 0.0f, 0.0f)));
+		roots.push_back(root);
+		for (int child = 0; child < 4 && int(graph.size()) < nodeCount; ++child)
+		{
+			SceneGraph::Node node = graph.addNode(glm::rotate(offset, float(child), glm::vec3(0.0f, 1.0f, 0.0f)), root);
+			for (int grandchild = 0; grandchild < 4 && int(graph.size()) < nodeCount; ++grandchild)
+			{
+				graph.addNode(glm::scale(offset, glm::vec3(0.5f)), node);
+			}
+		}
+	}
+	for (size_t node = 0; node < graph.size(); ++node)
+	{
+		localMatrices.push_back(graph.getLocalMatrix(SceneGraph::Node(node)));
+	}
+	graph.update();
+
+	std::cout << "Scene graph benchmark, " << graph.size() << " nodes, " << frames << " frames" << std::endl;
+	std::vector<glm::mat4> worldMatrices(graph.size());
+	std::vector<glm::mat3> normalMatrices(graph.size());
+	for (int percent : { 0, 1, 10, 100 })
+	{
+		//recomputing every transform the way Geometry::draw used to
+		size_t moved = roots.size() * percent / 100;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (size_t node = 0; node < graph.size(); ++node)
+			{
+				SceneGraph::Node parent = graph.getParent(SceneGraph::Node(node));
+				worldMatrices[node] = parent == SceneGraph::none ? localMatrices[node] : worldMatrices[parent] * localMatrices[node];
+				normalMatrices[node] = glm::mat3(glm::inverse(glm::transpose(worldMatrices[node])));
+			}
+		}
+		std::chrono::duration<double, std::milli> naiveTime = std::chrono::high_resolution_clock::now() - start;
+
+		start = std::chrono::high_resolution_clock::now();
+		size_t updated = 0;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (size_t root = 0; root < moved; ++root)
+			{
+				//a different subset every frame
+				SceneGraph::Node node = roots[(root + size_t(frame) * moved) % roots.size()];
+				graph.setLocalMatrix(node, glm::rotate(localMatrices[node], 0.01f * frame, glm::vec3(0.0f, 1.0f, 0.0f)));
+			}
+			graph.update();
+			updated += graph.getCounters().updated;
+		}
+		std::chrono::duration<double, std::milli> graphTime = std::chrono::high_resolution_clock::now() - start;
+		std::cout << "  " << percent << "% of the trees moving: " << double(updated) / frames << " of " << graph.size() << " transforms updated per frame, "
+			<< graphTime.count() / frames << "ms per frame, every transform every draw " << naiveTime.count() / frames << "ms per frame" << std::endl;
+	}
+}
+
+/*
+ Scene graph update, culling and sort keys of a large synthetic scene on 1 to N threads.
+ Every tree moves every frame, so all transforms are recomputed.
+*/
+void jobScalingBenchmark(int nodeCount, int frames)
+{
+	//the forest of the scene graph benchmark, a unit sphere per node
+	SceneGraph graph;
+	std::vector<SceneGraph::Node> roots;
+	glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.5f, 0.0f));
+	while (int(graph.size()) < nodeCount)
+	{
+		SceneGraph::Node root = graph.addNode(glm::translate(glm::mat4(1.0f), glm::vec3(float(roots.size() % 100) * 4.0f, 0.0f, float(roots.size() / 100) * 4.0f)));
+		roots.push_back(root);
+		for (int child = 0; child < 4 && int(graph.size()) < nodeCount; ++child)
+		{
+			SceneGraph::Node node = graph.addNode(glm::rotate(offset, float(child), glm::vec3(0.0f, 1.0f, 0.0f)), root);
+			for (int grandchild = 0; grandchild < 4 && int(graph.size()) < nodeCount; ++grandchild)
+			{
+				graph.addNode(glm::scale(offset, glm::vec3(0.5f)), node);
+			}
+		}
+	}
+	std::vector<glm::mat4> rootMatrices;
+	for (SceneGraph::Node root : roots)
+	{
+		rootMatrices.push_back(graph.getLocalMatrix(root));
+	}
+	//looking over the forest from one side, the far plane cuts off the rest
+	Camera camera(60.0f, 1.0f, 0.1f, 200.0f);
+	glm::vec3 cameraPosition(200.0f, 50.0f, -20.0f);
+	camera.setPose(cameraPosition, glm::vec3(200.0f, 0.0f, float(roots.size() / 100) * 2.0f) - cameraPosition);
+	DrawList::Frustum frustum = DrawList::getFrustum(camera.getViewProjectionMatrix());
+	std::vector<uint64_t> keys(graph.size());
+
+	std::cout << "Job scaling benchmark, " << graph.size() << " nodes, " << frames << " frames" << std::endl;
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+	double singleThreadTime = 0.0;
+	for (unsigned int threads : threadCounts)
+	{
+		JobSystem jobs(threads);
+		size_t visible = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (size_t root = 0; root < roots.size(); ++root)
+			{
+				graph.setLocalMatrix(roots[root], glm::rotate(rootMatrices[root], 0.01f * frame, glm::vec3(0.0f, 1.0f, 0.0f)));
+			}
+			graph.update(&jobs);
+			std::atomic<size_t> frameVisible(0);
+			jobs.parallelFor(graph.size(), 1024, [&](size_t begin, size_t end) {
+				size_t rangeVisible = 0;
+				for (size_t node = begin; node < end; ++node)
+				{
+					glm::vec3 center = glm::vec3(graph.getWorldMatrix(SceneGraph::Node(node))[3]);
+					if (!DrawList::intersects(frustum, glm::vec4(center, 1.0f)))
+					{
+						keys[node] = ~uint64_t(0);
+						continue;
+					}
+					glm::vec3 offset = center - cameraPosition;
+					keys[node] = DrawList::getSortKey(uint32_t(node % 16), glm::dot(offset, offset));
+					++rangeVisible;
+				}
+				frameVisible += rangeVisible;
+			});
+			//culled keys sort last
+			std::sort(keys.begin(), keys.end());
+			visible += frameVisible;
+		}
+		double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+		if (threads == 1) singleThreadTime = time;
+		std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ") << time << "ms per frame, " << singleThreadTime / time << "x, "
+			<< visible / frames << " visible, " << jobs.getStatistics().stolen << " jobs stolen" << std::endl;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Shader.h"
+#include "Camera.h"
+#include "Geometry.h"
+#include "DeferredRenderer.h"
+#include "ImageBasedLighting.h"
+
+/*
+ Benchmarks of the windowed application, started by the [benchmark] settings. Each one prints
+ its results to the console, the application closes after them instead of entering the render loop.
+*/
+
+//forward shading of geometries whose lights and camera uniforms are already set
+typedef std::function<void(const std::vector<Geometry*>&)> ForwardPass;
+
+//forward (renderForward) against deferred shading of a scene with heavy overdraw and 1 to 64 point lights
+void lightCountBenchmark(GLFWwindow* window, std::shared_ptr<Shader>& phongPBR, DeferredRenderer& deferredRenderer, Camera& camera, const ForwardPass& renderForward, bool depthPrepass, int frames);
+//hardware sRGB encoding against the SOFTWARE_SRGB variant of the forward PBR shader
+void srgbBenchmark(GLFWwindow* window, std::shared_ptr<Shader>& phongPBR, ImageBasedLighting& imageBasedLighting, Camera& camera, int frames);
+//uploads the bundled '.dds' files repeat times, mapped or from a heap copy
+void textureLoadBenchmark(bool mapped, int repeat);
+//a generated '.obj' against its cooked '.mesh'
+void meshLoadBenchmark(unsigned int triangles);
+//imports a model file, or a generated '.obj' for "generated", on one thread, in parallel and streaming
+void modelImportBenchmark(const std::string& file, unsigned int triangles);
+//scene graph updates with 0 to 100% of the trees moving against recomputing every transform
+void sceneGraphBenchmark(int nodeCount, int frames);
+//scene graph update, culling and sort keys on 1 to N job threads
+void jobScalingBenchmark(int nodeCount, int frames);
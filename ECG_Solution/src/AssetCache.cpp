@@ -0,0 +1,54 @@
+#include "AssetCache.h"
+#include <fstream>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+AssetCache::AssetCache(const std::string& directory) : directory(directory)
+{
+	createDirectory(directory);
+}
+
+uint64_t AssetCache::hash(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t value = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		value ^= bytes[i];
+		value *= 1099511628211ull;
+	}
+	return value;
+}
+
+bool AssetCache::createDirectory(const std::string& path)
+{
+#ifdef _WIN32
+	return _mkdir(path.c_str()) == 0;
+#else
+	return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
+
+std::string AssetCache::getPath(uint64_t key, const std::string& extension) const
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+	return directory + "/" + name + extension;
+}
+
+bool AssetCache::contains(uint64_t key, const std::string& extension) const
+{
+	return std::ifstream(getPath(key, extension)).good();
+}
+
+bool AssetCache::store(const std::string& file, uint64_t key, const std::string& extension) const
+{
+	std::string path = getPath(key, extension);
+	//another cooker may have stored the same content meanwhile
+	std::remove(path.c_str());
+	return std::rename(file.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/*
+ Content addressed store of cooked files. The key is a hash of the source bytes and the
+ cook settings, so unchanged sources are found again and changed ones get a new entry.
+*/
+class AssetCache
+{
+private:
+	std::string directory;
+public:
+	AssetCache(const std::string& directory);
+
+	//64 bit FNV-1a, chain calls through seed
+	static uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+	static bool createDirectory(const std::string& path);
+
+	std::string getPath(uint64_t key, const std::string& extension) const;
+	bool contains(uint64_t key, const std::string& extension) const;
+	//moves a completely written file into the cache
+	bool store(const std::string& file, uint64_t key, const std::string& extension) const;
+};
@@ -0,0 +1,292 @@
+/*
+ Offline asset cooker, converts source assets into what the renderer loads:
+  .tga/.ppm -> .dds, BC1 (BC3 if the image has alpha) with a full mip chain
+  .obj/.gltf/.glb -> .mesh, vertex cache optimized with levels of detail and meshlets
+ Cooked files are kept in a content addressed cache, unchanged sources are only copied.
+ Subdirectories of a source directory are kept in the output directory.
+
+ Usage: AssetCooker <output directory> <files or directories...> [-cache <directory>] [-threads <count>] [-linear]
+*/
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "AssetCache.h"
+#include "JobSystem.h"
+#include "BlockCompressor.h"
+#include "ImageFile.h"
+#include "DDSFile.h"
+#include "OBJFile.h"
+#include "GLTFFile.h"
+#include "JsonValue.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+//changes whenever cooked output changes, invalidates the cache
+static const char* cookerVersion = "AssetCooker 2";
+
+enum class AssetType { TEXTURE, MESH, UNKNOWN };
+
+struct CookJob {
+	std::string source;
+	AssetType type;
+	//relative to the output directory, without extension
+	std::string target;
+};
+
+struct CookSettings {
+	std::string outputDirectory;
+	unsigned int threadCount;
+	//threads of the block compressor per texture
+	unsigned int compressThreads;
+	bool srgb;
+};
+
+static std::string extension(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos) return "";
+	std::string result = path.substr(dot);
+	std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+	return result;
+}
+
+static std::string stem(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	return name.substr(0, name.find_last_of('.'));
+}
+
+static AssetType assetType(const std::string& path)
+{
+	std::string type = extension(path);
+	if (type == ".tga" || type == ".ppm") return AssetType::TEXTURE;
+	if (type == ".obj" || type == ".gltf" || type == ".glb") return AssetType::MESH;
+	return AssetType::UNKNOWN;
+}
+
+static bool isDirectory(const std::string& path)
+{
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+#endif
+}
+
+//cookable files of a directory and its subdirectories, subdirectory is the relative output path ending in '/'
+static void collectSources(const std::string& path, const std::string& subdirectory, std::vector<CookJob>& jobs)
+{
+	if (!isDirectory(path))
+	{
+		AssetType type = assetType(path);
+		if (type != AssetType::UNKNOWN) jobs.push_back({ path, type, subdirectory + stem(path) });
+		else std::cout << "Skipping " << path << ", unknown type" << std::endl;
+		return;
+	}
+	std::vector<std::string> entries;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE) return;
+	do entries.push_back(data.cFileName); while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* directory = opendir(path.c_str());
+	if (directory == nullptr) return;
+	while (dirent* entry = readdir(directory)) entries.push_back(entry->d_name);
+	closedir(directory);
+#endif
+	std::sort(entries.begin(), entries.end());
+	for (const std::string& entry : entries)
+	{
+		if (entry == "." || entry == "..") continue;
+		std::string child = path + "/" + entry;
+		if (isDirectory(child)) collectSources(child, subdirectory + entry + "/", jobs);
+		else if (assetType(child) != AssetType::UNKNOWN) collectSources(child, subdirectory, jobs);
+	}
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& data)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static bool copyFile(const std::string& source, const std::string& target)
+{
+	std::ifstream in(source, std::ios::binary);
+	std::ofstream out(target, std::ios::binary);
+	out << in.rdbuf();
+	return bool(in) && bool(out);
+}
+
+//a '.gltf' may keep its buffers in other files, those are part of the cache key
+static uint64_t hashExternalBuffers(const std::string& source, const std::vector<unsigned char>& data, uint64_t key, std::atomic<size_t>& bytesRead)
+{
+	JsonValue json;
+	std::string error;
+	if (!JsonValue::parse(reinterpret_cast<const char*>(data.data()), reinterpret_cast<const char*>(data.data()) + data.size(), json, error)) return key;
+	std::string directory = source.substr(0, source.find_last_of("/\\") + 1);
+	const JsonValue& buffers = json["buffers"];
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		const std::string& uri = buffers[i]["uri"].asString();
+		std::vector<unsigned char> buffer;
+		if (uri.empty() || uri.compare(0, 5, "data:") == 0 || !readFile(directory + uri, buffer)) continue;
+		bytesRead += buffer.size();
+		key = AssetCache::hash(buffer.data(), buffer.size(), key);
+	}
+	return key;
+}
+
+static bool cookTexture(const std::string& source, const std::string& target, const CookSettings& settings, std::string& info)
+{
+	Image image;
+	if (!loadImage(source, image)) return false;
+	bool alpha = image.hasAlpha();
+	std::vector<std::vector<unsigned char>> levels;
+	Image level = image;
+	while (true)
+	{
+		levels.push_back(BlockCompressor::compressImage(level, alpha, settings.compressThreads));
+		if (level.width == 1 && level.height == 1) break;
+		level = BlockCompressor::downsample(level, settings.srgb);
+	}
+	info = std::to_string(image.width) + "x" + std::to_string(image.height) + (alpha ? " BC3, " : " BC1, ") + std::to_string(levels.size()) + " levels";
+	return saveDDS(target, alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, image.width, image.height, levels);
+}
+
+static bool cookMesh(const std::string& source, const std::string& target, std::string& info)
+{
+	GeometryData geometry;
+	if (!(extension(source) == ".obj" ? loadOBJ(source, geometry) : loadGLTF(source, geometry))) return false;
+	float before = MeshOptimizer::averageCacheMissRatio(geometry.indices, geometry.positions.size());
+	geometry.indices = MeshOptimizer::optimizeVertexCache(geometry.indices, geometry.positions.size());
+	MeshOptimizer::optimizeVertexFetch(geometry);
+	float after = MeshOptimizer::averageCacheMissRatio(geometry.indices, geometry.positions.size());
+	info = std::to_string(geometry.positions.size()) + " vertices, " + std::to_string(geometry.indices.size() / 3) + " triangles, ACMR "
+		+ std::to_string(before).substr(0, 4) + " -> " + std::to_string(after).substr(0, 4);
+	return MeshFile::save(target, geometry);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: AssetCooker <output directory> <files or directories...> [-cache <directory>] [-threads <count>] [-linear]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	CookSettings settings;
+	settings.outputDirectory = argv[1];
+	settings.threadCount = std::max(1u, std::thread::hardware_concurrency());
+	settings.srgb = true;
+	std::string cacheDirectory = settings.outputDirectory + "/.cache";
+	std::vector<CookJob> jobs;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "-cache" && i + 1 < argc) cacheDirectory = argv[++i];
+		else if (argument == "-threads" && i + 1 < argc) settings.threadCount = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "-linear") settings.srgb = false;
+		else collectSources(argument, "", jobs);
+	}
+	//e.g. a.tga and a.ppm in one directory would overwrite each other's .dds
+	std::vector<std::string> targets;
+	for (const CookJob& job : jobs)
+	{
+		targets.push_back(job.target + (job.type == AssetType::TEXTURE ? ".dds" : ".mesh"));
+	}
+	std::sort(targets.begin(), targets.end());
+	auto duplicate = std::adjacent_find(targets.begin(), targets.end());
+	if (duplicate != targets.end())
+	{
+		std::cout << "More than one source is cooked to " << settings.outputDirectory << "/" << *duplicate << std::endl;
+		return EXIT_FAILURE;
+	}
+	AssetCache::createDirectory(settings.outputDirectory);
+	for (const CookJob& job : jobs)
+	{
+		for (size_t slash = job.target.find('/'); slash != std::string::npos; slash = job.target.find('/', slash + 1))
+		{
+			AssetCache::createDirectory(settings.outputDirectory + "/" + job.target.substr(0, slash));
+		}
+	}
+	AssetCache cache(cacheDirectory);
+
+	//files in parallel, the remaining threads compress blocks of a texture
+	unsigned int workerCount = std::max(1u, std::min(settings.threadCount, (unsigned int)jobs.size()));
+	settings.compressThreads = std::max(1u, settings.threadCount / workerCount);
+
+	std::atomic<size_t> bytesRead(0);
+	std::atomic<unsigned int> hits(0), failures(0);
+	std::mutex outputMutex;
+	auto start = std::chrono::high_resolution_clock::now();
+	parallelFor(jobs.size(), workerCount, [&](size_t index) {
+		const CookJob& job = jobs[index];
+		auto jobStart = std::chrono::high_resolution_clock::now();
+		std::vector<unsigned char> data;
+		if (!readFile(job.source, data))
+		{
+			++failures;
+			return;
+		}
+		bytesRead += data.size();
+
+		std::string cookedExtension = job.type == AssetType::TEXTURE ? ".dds" : ".mesh";
+		std::string settingsKey = std::string(cookerVersion) + (job.type == AssetType::TEXTURE && settings.srgb ? " srgb" : "");
+		uint64_t key = AssetCache::hash(data.data(), data.size(), AssetCache::hash(settingsKey.data(), settingsKey.size()));
+		if (extension(job.source) == ".gltf") key = hashExternalBuffers(job.source, data, key, bytesRead);
+		bool hit = cache.contains(key, cookedExtension);
+		bool success = true;
+		std::string info;
+		if (hit)
+		{
+			++hits;
+		}
+		else
+		{
+			std::string temporary = cache.getPath(key, cookedExtension) + ".tmp" + std::to_string(index);
+			success = job.type == AssetType::TEXTURE ? cookTexture(job.source, temporary, settings, info) : cookMesh(job.source, temporary, info);
+			success = success && cache.store(temporary, key, cookedExtension);
+		}
+		std::string target = settings.outputDirectory + "/" + job.target + cookedExtension;
+		success = success && copyFile(cache.getPath(key, cookedExtension), target);
+		if (!success) ++failures;
+
+		std::chrono::duration<double, std::milli> jobTime = std::chrono::high_resolution_clock::now() - jobStart;
+		std::lock_guard<std::mutex> lock(outputMutex);
+		std::cout << (success ? (hit ? "cached " : "cooked ") : "FAILED ") << job.source << " -> " << target
+			<< (info.empty() ? "" : " (" + info + ")") << ", " << jobTime.count() << "ms" << std::endl;
+	});
+
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+	double megabytes = bytesRead / (1024.0 * 1024.0);
+	std::cout << jobs.size() << " assets, " << megabytes << " MB in " << time.count() << "s: " << megabytes / std::max(time.count(), 1e-9)
+		<< " MB/s, cache hits " << hits << "/" << jobs.size() << " (" << (jobs.empty() ? 0.0 : 100.0 * hits / jobs.size()) << "%)"
+		<< ", " << workerCount << " workers x " << settings.compressThreads << " compression threads" << std::endl;
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,419 @@
+/*
+ Microbenchmarks of geometry generation, camera and normal matrix math, uniform uploads and DDS loading.
+
+	ECG_Benchmarks [--output file] [--baseline file] [--threshold percent] [--update-baseline]
+	               [--benchmark_filter=regex] [--benchmark_repetitions=n] [other Google Benchmark flags]
+
+ The GL cases run on a headless context, a software implementation like llvmpipe is enough. Results are
+ written as JSON with one entry per benchmark in registration order and without run specific context,
+ so two runs can be diffed. With repetitions the median is written. Compared with a baseline file, a
+ benchmark regresses if its real time grew by more than the threshold, the program returns 1 then.
+*/
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Utils.h"
+#include "HeadlessContext.h"
+#include "Geometry.h"
+#include "Camera.h"
+#include "Shader.h"
+#include "LightManager.h"
+#include "DDSFile.h"
+#include "MappedFile.h"
+#include "JsonValue.h"
+
+namespace {
+	//GL cases are skipped without a context
+	HeadlessContext* context = nullptr;
+	const char* ddsFile = "./assets/textures/bricks_diffuse.dds";
+
+	bool requireContext(benchmark::State& state)
+	{
+		if (context != nullptr && context->isValid()) return true;
+		state.SkipWithError("no OpenGL context");
+		return false;
+	}
+
+	/* --------------------------------------------- */
+	// Geometry generators, the argument is the resolution
+	/* --------------------------------------------- */
+
+	void createCube(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			GeometryData data = Geometry::createCubeGeometry(1.0f, 1.0f, 1.0f);
+			benchmark::DoNotOptimize(data.positions.data());
+		}
+	}
+
+	void createSphere(benchmark::State& state)
+	{
+		unsigned int segments = (unsigned int)state.range(0);
+		for (auto _ : state)
+		{
+			GeometryData data = Geometry::createSphereGeometry(1.0f, segments, segments / 2);
+			benchmark::DoNotOptimize(data.positions.data());
+		}
+		state.SetItemsProcessed(state.iterations() * segments * (segments / 2));
+	}
+
+	void createCylinder(benchmark::State& state)
+	{
+		unsigned int segments = (unsigned int)state.range(0);
+		for (auto _ : state)
+		{
+			GeometryData data = Geometry::createCylinderGeometry(1.0f, 2.0f, segments);
+			benchmark::DoNotOptimize(data.positions.data());
+		}
+		state.SetItemsProcessed(state.iterations() * segments);
+	}
+
+	void createTorus(benchmark::State& state)
+	{
+		unsigned int sections = (unsigned int)state.range(0);
+		for (auto _ : state)
+		{
+			GeometryData data = Geometry::createTorusGeometry(1.0f, 0.3f, sections, sections / 2);
+			benchmark::DoNotOptimize(data.positions.data());
+		}
+		state.SetItemsProcessed(state.iterations() * sections * (sections / 2));
+	}
+
+	/* --------------------------------------------- */
+	// Math
+	/* --------------------------------------------- */
+
+	void cameraUpdate(benchmark::State& state)
+	{
+		Camera camera(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+		int x = 0;
+		for (auto _ : state)
+		{
+			//dragging by one pixel, so the orbit changes every time
+			camera.update(x, x / 2, 0.0f, true, false);
+			x = (x + 1) % 1000;
+			benchmark::DoNotOptimize(camera.getViewProjectionMatrix());
+		}
+	}
+
+	//as Geometry computes it from the model matrix
+	void normalMatrix(benchmark::State& state)
+	{
+		glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(model);
+			glm::mat3 normal = glm::mat3(glm::inverse(glm::transpose(model)));
+			benchmark::DoNotOptimize(normal);
+		}
+	}
+
+	//the upper 3x3 is enough for the normal matrix
+	void normalMatrix3x3(benchmark::State& state)
+	{
+		glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(model);
+			glm::mat3 normal = glm::inverse(glm::transpose(glm::mat3(model)));
+			benchmark::DoNotOptimize(normal);
+		}
+	}
+
+	/* --------------------------------------------- */
+	// Uniforms, values alternate so every call is uploaded
+	/* --------------------------------------------- */
+
+	void setUniformByName(benchmark::State& state)
+	{
+		if (!requireContext(state)) return;
+		Shader shader("PBR_shader_phong.vert", "PBR_shader_phong.frag");
+		glm::mat4 matrices[2] = { glm::mat4(1.0f), glm::mat4(2.0f) };
+		int i = 0;
+		for (auto _ : state)
+		{
+			shader.setUniform("modelMatrix", matrices[i ^= 1]);
+		}
+		glFinish();
+	}
+
+	void setUniformByLocation(benchmark::State& state)
+	{
+		if (!requireContext(state)) return;
+		Shader shader("PBR_shader_phong.vert", "PBR_shader_phong.frag");
+		GLint location = shader.getUniformLocation("modelMatrix");
+		glm::mat4 matrices[2] = { glm::mat4(1.0f), glm::mat4(2.0f) };
+		int i = 0;
+		for (auto _ : state)
+		{
+			shader.setUniform(location, matrices[i ^= 1]);
+		}
+		glFinish();
+	}
+
+	//the lights don't move, so this is the per frame cost of finding out nothing changed
+	void lightManagerSetUniforms(benchmark::State& state)
+	{
+		if (!requireContext(state)) return;
+		std::vector<std::shared_ptr<Shader>> shaders = { std::make_shared<Shader>("PBR_shader_phong.vert", "PBR_shader_phong.frag") };
+		LightManager lightManager;
+		for (int64_t i = 0; i < state.range(0); ++i)
+		{
+			lightManager.createPointLight(glm::vec3(1.0f), glm::vec3(float(i), 1.0f, 0.0f), glm::vec3(1.0f, 0.4f, 0.1f));
+		}
+		for (auto _ : state)
+		{
+			lightManager.setUniforms(shaders);
+		}
+		glFinish();
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	/* --------------------------------------------- */
+	// DDS loading
+	/* --------------------------------------------- */
+
+	//mapping and parsing, the pixels are read when uploaded
+	void loadDDS(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			DDSTexture texture;
+			if (!loadDDSFile(ddsFile, texture))
+			{
+				state.SkipWithError("missing DDS file");
+				break;
+			}
+			benchmark::DoNotOptimize(texture.levels.data());
+		}
+	}
+
+	void parseDDSFromMemory(benchmark::State& state)
+	{
+		MappedFile file(ddsFile);
+		if (!file.isOpen())
+		{
+			state.SkipWithError("missing DDS file");
+			return;
+		}
+		for (auto _ : state)
+		{
+			DDSTexture texture;
+			parseDDS(file.data(), file.getSize(), texture);
+			benchmark::DoNotOptimize(texture.levels.data());
+		}
+	}
+
+	/* --------------------------------------------- */
+	// Results
+	/* --------------------------------------------- */
+
+	struct Result {
+		std::string name;
+		int64_t iterations = 0;
+		std::vector<double> realTimes;
+		std::vector<double> cpuTimes;
+	};
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	//prints to the console and keeps the time of every run in ns
+	class CollectingReporter : public benchmark::ConsoleReporter
+	{
+	public:
+		std::vector<Result> results;
+
+		void ReportRuns(const std::vector<Run>& runs) override
+		{
+			ConsoleReporter::ReportRuns(runs);
+			for (const Run& run : runs)
+			{
+				if (run.run_type != Run::RT_Iteration || run.error_occurred) continue;
+				std::string name = run.benchmark_name();
+				auto result = std::find_if(results.begin(), results.end(), [&](const Result& r) { return r.name == name; });
+				if (result == results.end())
+				{
+					results.emplace_back();
+					result = results.end() - 1;
+					result->name = name;
+				}
+				double toNanoseconds = 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+				result->iterations = run.iterations;
+				result->realTimes.push_back(run.GetAdjustedRealTime() * toNanoseconds);
+				result->cpuTimes.push_back(run.GetAdjustedCPUTime() * toNanoseconds);
+			}
+		}
+	};
+
+	bool writeResults(const std::string& file, const std::vector<Result>& results)
+	{
+		std::ofstream out(file);
+		if (!out) return false;
+		out << std::fixed << std::setprecision(3);
+		out << "{\n\t\"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			out << "\t\t{ \"name\": \"" << results[i].name << "\", \"iterations\": " << results[i].iterations
+				<< ", \"real_time_ns\": " << median(results[i].realTimes) << ", \"cpu_time_ns\": " << median(results[i].cpuTimes) << " }"
+				<< (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "\t]\n}\n";
+		return bool(out);
+	}
+
+	/*!
+	 * Prints the change of every benchmark against the baseline
+	 * @return the number of regressions, -1 if the baseline can't be read
+	 */
+	int compareResults(const std::string& file, const std::vector<Result>& results, double threshold)
+	{
+		std::ifstream in(file, std::ios::binary);
+		if (!in) return -1;
+		std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		JsonValue baseline;
+		std::string error;
+		if (!JsonValue::parse(text.data(), text.data() + text.size(), baseline, error))
+		{
+			std::cout << "Baseline " << file << ": " << error << std::endl;
+			return -1;
+		}
+		const JsonValue& entries = baseline["benchmarks"];
+
+		size_t nameWidth = 9;
+		for (const Result& result : results) nameWidth = std::max(nameWidth, result.name.size());
+		std::cout << "Comparison with " << file << ", regression threshold " << threshold << "%:" << std::endl;
+		std::cout << std::left << std::setw(int(nameWidth)) << "benchmark" << std::right << std::setw(16) << "baseline ns" << std::setw(16) << "current ns"
+			<< std::setw(10) << "change" << std::endl;
+		int regressions = 0;
+		for (const Result& result : results)
+		{
+			double current = median(result.realTimes);
+			double previous = -1.0;
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				if (entries[i]["name"].asString() == result.name) previous = entries[i]["real_time_ns"].asNumber(-1.0);
+			}
+			std::cout << std::left << std::setw(int(nameWidth)) << result.name << std::right << std::fixed << std::setprecision(1);
+			if (previous <= 0.0)
+			{
+				std::cout << std::setw(16) << "-" << std::setw(16) << current << std::setw(10) << "new" << std::endl;
+				continue;
+			}
+			double change = (current - previous) / previous * 100.0;
+			std::cout << std::setw(16) << previous << std::setw(16) << current << std::setw(9) << std::showpos << change << std::noshowpos << "%";
+			if (change > threshold)
+			{
+				std::cout << "  REGRESSION";
+				++regressions;
+			}
+			else if (change < -threshold)
+			{
+				std::cout << "  improved";
+			}
+			std::cout << std::endl;
+		}
+		return regressions;
+	}
+}
+
+BENCHMARK(createCube);
+BENCHMARK(createSphere)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(createCylinder)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(createTorus)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(cameraUpdate);
+BENCHMARK(normalMatrix);
+BENCHMARK(normalMatrix3x3);
+BENCHMARK(setUniformByName);
+BENCHMARK(setUniformByLocation);
+BENCHMARK(lightManagerSetUniforms)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(loadDDS);
+BENCHMARK(parseDDSFromMemory);
+
+int main(int argc, char** argv)
+{
+	/* --------------------------------------------- */
+	// Load settings.ini, arguments override them
+	/* --------------------------------------------- */
+
+	INIReader reader("assets/settings.ini");
+
+	std::string outputFile = reader.Get("microbenchmarks", "output", "./benchmarks.json");
+	std::string baselineFile = reader.Get("microbenchmarks", "baseline", "./benchmarks_baseline.json");
+	double threshold = reader.GetReal("microbenchmarks", "threshold", 10.0);
+	bool updateBaseline = false;
+
+	//the --benchmark_* flags are left for Google Benchmark
+	std::vector<char*> benchmarkArguments = { argv[0] };
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+		if (argument == "--output" && hasValue) outputFile = argv[++i];
+		else if (argument == "--baseline" && hasValue) baselineFile = argv[++i];
+		else if (argument == "--threshold" && hasValue) threshold = std::atof(argv[++i]);
+		else if (argument == "--update-baseline") updateBaseline = true;
+		else benchmarkArguments.push_back(argv[i]);
+	}
+	int benchmarkArgumentCount = int(benchmarkArguments.size());
+	benchmark::Initialize(&benchmarkArgumentCount, benchmarkArguments.data());
+	if (benchmark::ReportUnrecognizedArguments(benchmarkArgumentCount, benchmarkArguments.data()))
+	{
+		return EXIT_FAILURE;
+	}
+
+	HeadlessContext headlessContext(4, 3);
+	if (headlessContext.isValid())
+	{
+		context = &headlessContext;
+		std::cout << "OpenGL cases on " << headlessContext.getRenderer() << std::endl;
+	}
+	else
+	{
+		std::cout << "No headless OpenGL context, the OpenGL cases are skipped" << std::endl;
+	}
+
+	CollectingReporter reporter;
+	benchmark::RunSpecifiedBenchmarks(&reporter);
+	benchmark::Shutdown();
+
+	/* --------------------------------------------- */
+	// Write and compare results
+	/* --------------------------------------------- */
+
+	int result = EXIT_SUCCESS;
+	if (!outputFile.empty())
+	{
+		std::cout << (writeResults(outputFile, reporter.results) ? "Results written to " : "Could not write results to ") << outputFile << std::endl;
+	}
+	if (updateBaseline)
+	{
+		std::cout << (writeResults(baselineFile, reporter.results) ? "Baseline written to " : "Could not write baseline to ") << baselineFile << std::endl;
+	}
+	else if (!baselineFile.empty())
+	{
+		int regressions = compareResults(baselineFile, reporter.results, threshold);
+		if (regressions < 0)
+		{
+			std::cout << "No baseline in " << baselineFile << ", --update-baseline writes it" << std::endl;
+		}
+		else if (regressions > 0)
+		{
+			std::cout << regressions << " benchmarks regressed by more than " << threshold << "%." << std::endl;
+			result = EXIT_FAILURE;
+		}
+		else
+		{
+			std::cout << "No regressions." << std::endl;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,280 @@
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	uint16_t to565(const unsigned char* color)
+	{
+		return uint16_t((color[0] >> 3) << 11 | (color[1] >> 2) << 5 | (color[2] >> 3));
+	}
+
+	//the color the decoder will see for an endpoint
+	void from565(uint16_t value, unsigned char* color)
+	{
+		unsigned char r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+		color[3] = 0;
+	}
+
+	//index of the nearest palette entry for each texel, 2 bits each
+	uint32_t colorIndices(const unsigned char* texels, const unsigned char palette[4][4])
+	{
+		uint32_t indices = 0;
+#ifdef BLOCK_COMPRESSOR_SSE2
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i colors[4];
+		for (int entry = 0; entry < 4; ++entry)
+		{
+			int32_t value;
+			std::memcpy(&value, palette[entry], 4);
+			colors[entry] = _mm_set1_epi32(value);
+		}
+		for (int row = 0; row < 4; ++row)
+		{
+			__m128i pixels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + row * 16)), colorMask);
+			__m128i best = _mm_set1_epi32(0x7FFFFFFF);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int entry = 0; entry < 4; ++entry)
+			{
+				//sum of absolute channel differences per texel
+				__m128i difference = _mm_or_si128(_mm_subs_epu8(pixels, colors[entry]), _mm_subs_epu8(colors[entry], pixels));
+				__m128i pairs = _mm_add_epi16(_mm_and_si128(difference, lowBytes), _mm_srli_epi16(difference, 8));
+				__m128i distance = _mm_madd_epi16(pairs, ones);
+				__m128i closer = _mm_cmplt_epi32(distance, best);
+				best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(entry)), _mm_andnot_si128(closer, bestIndex));
+			}
+			alignas(16) int32_t rowIndices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(rowIndices), bestIndex);
+			for (int column = 0; column < 4; ++column)
+			{
+				indices |= uint32_t(rowIndices[column]) << ((row * 4 + column) * 2);
+			}
+		}
+#else
+		for (int texel = 0; texel < 16; ++texel)
+		{
+			int best = 0x7FFFFFFF, bestIndex = 0;
+			for (int entry = 0; entry < 4; ++entry)
+			{
+				int distance = std::abs(texels[texel * 4] - palette[entry][0]) + std::abs(texels[texel * 4 + 1] - palette[entry][1])
+					+ std::abs(texels[texel * 4 + 2] - palette[entry][2]);
+				if (distance < best)
+				{
+					best = distance;
+					bestIndex = entry;
+				}
+			}
+			indices |= uint32_t(bestIndex) << (texel * 2);
+		}
+#endif
+		return indices;
+	}
+
+	void colorBounds(const unsigned char* texels, unsigned char* minColor, unsigned char* maxColor)
+	{
+#ifdef BLOCK_COMPRESSOR_SSE2
+		__m128i minimum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels));
+		__m128i maximum = minimum;
+		for (int row = 1; row < 4; ++row)
+		{
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + row * 16));
+			minimum = _mm_min_epu8(minimum, pixels);
+			maximum = _mm_max_epu8(maximum, pixels);
+		}
+		//reduce the four texels of a register
+		minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+		minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+		maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+		maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+		int32_t minValue = _mm_cvtsi128_si32(minimum), maxValue = _mm_cvtsi128_si32(maximum);
+		std::memcpy(minColor, &minValue, 4);
+		std::memcpy(maxColor, &maxValue, 4);
+#else
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			minColor[channel] = 255;
+			maxColor[channel] = 0;
+		}
+		for (int texel = 0; texel < 16; ++texel)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				minColor[channel] = std::min(minColor[channel], texels[texel * 4 + channel]);
+				maxColor[channel] = std::max(maxColor[channel], texels[texel * 4 + channel]);
+			}
+		}
+#endif
+	}
+
+	void writeColorBlock(const unsigned char* texels, unsigned char* block)
+	{
+		unsigned char minColor[4], maxColor[4];
+		colorBounds(texels, minColor, maxColor);
+		//inset the bounding box, the extremes are rarely worth an endpoint
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			int inset = (maxColor[channel] - minColor[channel]) >> 4;
+			minColor[channel] = (unsigned char)std::min(255, minColor[channel] + inset);
+			maxColor[channel] = (unsigned char)std::max(0, maxColor[channel] - inset);
+		}
+
+		uint16_t color0 = to565(maxColor), color1 = to565(minColor);
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			if (color0 < color1) std::swap(color0, color1);
+			//four color mode needs color0 > color1
+			unsigned char palette[4][4];
+			from565(color0, palette[0]);
+			from565(color1, palette[1]);
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				palette[2][channel] = (unsigned char)((2 * palette[0][channel] + palette[1][channel]) / 3);
+				palette[3][channel] = (unsigned char)((palette[0][channel] + 2 * palette[1][channel]) / 3);
+			}
+			indices = colorIndices(texels, palette);
+		}
+		block[0] = color0 & 0xFF;
+		block[1] = color0 >> 8;
+		block[2] = color1 & 0xFF;
+		block[3] = color1 >> 8;
+		std::memcpy(block + 4, &indices, 4);
+	}
+
+	void writeAlphaBlock(const unsigned char* texels, unsigned char* block)
+	{
+		unsigned char minAlpha = 255, maxAlpha = 0;
+		for (int texel = 0; texel < 16; ++texel)
+		{
+			minAlpha = std::min(minAlpha, texels[texel * 4 + 3]);
+			maxAlpha = std::max(maxAlpha, texels[texel * 4 + 3]);
+		}
+		block[0] = maxAlpha;
+		block[1] = minAlpha;
+		//eight level mode, index 0 is alpha0, 1 is alpha1, 2..7 interpolate from alpha0 to alpha1
+		uint64_t indices = 0;
+		int range = maxAlpha - minAlpha;
+		for (int texel = 0; range > 0 && texel < 16; ++texel)
+		{
+			int step = ((maxAlpha - texels[texel * 4 + 3]) * 7 + range / 2) / range;
+			uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+			indices |= index << (texel * 3);
+		}
+		for (int i = 0; i < 6; ++i)
+		{
+			block[2 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	struct SrgbTable {
+		float linear[256];
+		SrgbTable()
+		{
+			for (int value = 0; value < 256; ++value)
+			{
+				float c = value / 255.0f;
+				linear[value] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+	};
+
+	float srgbToLinear(unsigned char value)
+	{
+		static const SrgbTable table;
+		return table.linear[value];
+	}
+
+	unsigned char linearToSrgb(float value)
+	{
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return (unsigned char)std::min(255.0f, std::max(0.0f, c * 255.0f + 0.5f));
+	}
+}
+
+void BlockCompressor::compressBC1Block(const unsigned char* texels, unsigned char* block)
+{
+	writeColorBlock(texels, block);
+}
+
+void BlockCompressor::compressBC3Block(const unsigned char* texels, unsigned char* block)
+{
+	writeAlphaBlock(texels, block);
+	writeColorBlock(texels, block + 8);
+}
+
+std::vector<unsigned char> BlockCompressor::compressImage(const Image& image, bool alpha, unsigned int threadCount)
+{
+	unsigned int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+	size_t blockSize = alpha ? 16 : 8;
+	std::vector<unsigned char> output(size_t(blocksX) * blocksY * blockSize);
+
+	//one block row per call
+	parallelFor(blocksY, threadCount, [&](size_t row) {
+		unsigned int blockY = (unsigned int)row;
+		unsigned char texels[64];
+		for (unsigned int blockX = 0; blockX < blocksX; ++blockX)
+		{
+			for (unsigned int y = 0; y < 4; ++y)
+			{
+				unsigned int sourceY = std::min(blockY * 4 + y, image.height - 1);
+				for (unsigned int x = 0; x < 4; ++x)
+				{
+					unsigned int sourceX = std::min(blockX * 4 + x, image.width - 1);
+					std::memcpy(texels + (y * 4 + x) * 4, &image.pixels[(size_t(sourceY) * image.width + sourceX) * 4], 4);
+				}
+			}
+			unsigned char* block = &output[(size_t(blockY) * blocksX + blockX) * blockSize];
+			if (alpha) compressBC3Block(texels, block);
+			else compressBC1Block(texels, block);
+		}
+	});
+	return output;
+}
+
+Image BlockCompressor::downsample(const Image& image, bool srgb)
+{
+	Image result;
+	result.width = std::max(1u, image.width / 2);
+	result.height = std::max(1u, image.height / 2);
+	result.pixels.resize(size_t(result.width) * result.height * 4);
+	for (unsigned int y = 0; y < result.height; ++y)
+	{
+		for (unsigned int x = 0; x < result.width; ++x)
+		{
+			unsigned int x0 = std::min(x * 2, image.width - 1), x1 = std::min(x * 2 + 1, image.width - 1);
+			unsigned int y0 = std::min(y * 2, image.height - 1), y1 = std::min(y * 2 + 1, image.height - 1);
+			const unsigned char* source[4] = {
+				&image.pixels[(size_t(y0) * image.width + x0) * 4], &image.pixels[(size_t(y0) * image.width + x1) * 4],
+				&image.pixels[(size_t(y1) * image.width + x0) * 4], &image.pixels[(size_t(y1) * image.width + x1) * 4]
+			};
+			unsigned char* target = &result.pixels[(size_t(y) * result.width + x) * 4];
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				if (srgb && channel < 3)
+				{
+					float sum = 0.0f;
+					for (int i = 0; i < 4; ++i) sum += srgbToLinear(source[i][channel]);
+					target[channel] = linearToSrgb(sum / 4.0f);
+				}
+				else
+				{
+					target[channel] = (unsigned char)((source[0][channel] + source[1][channel] + source[2][channel] + source[3][channel] + 2) / 4);
+				}
+			}
+		}
+	}
+	return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "ImageFile.h"
+
+/*
+ Real-time BC1/BC3 (DXT1/DXT5) compression: bounding box endpoints inset by 1/16 of
+ the range, nearest palette entry per texel. The index search runs four texels at
+ a time with SSE2 where available, images are split into rows of blocks over threads.
+*/
+namespace BlockCompressor
+{
+	//64 bytes of RGBA texels in, 8 bytes out
+	void compressBC1Block(const unsigned char* texels, unsigned char* block);
+	//64 bytes of RGBA texels in, 16 bytes out (alpha block followed by a BC1 color block)
+	void compressBC3Block(const unsigned char* texels, unsigned char* block);
+
+	//compresses a whole image, edges are padded by repeating the last texel
+	std::vector<unsigned char> compressImage(const Image& image, bool alpha, unsigned int threadCount);
+
+	//halves an image with a box filter, averaging in linear space for sRGB images
+	Image downsample(const Image& image, bool srgb);
+}
@@ -9,6 +9,8 @@ Camera::Camera(float fov, float aspect, float near, float far)
 	pitch = 0.0f;
 	yaw = 0.0f;
 	radius = 20.0f;
+	lastX = 0;
+	lastY = 0;
 	position = vec3(0.0f, 0.0f, 20.0f);
 	strafe = vec3(0.0f, 0.0f, 0.0f);
 	vec3 up = vec3(0.0f, 1.0f, 0.0f);
@@ -33,6 +35,12 @@ glm::vec3 Camera::getPosition()
 	return position;
 }
 
+glm::vec3 Camera::getDirection() const
+{
+	//the view matrix maps the direction to -z, it is the negated third row of its rotation
+	return -glm::vec3(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2]);
+}
+
 void Camera::update(int x, int y, float zoom, bool dragging, bool strafing)
 {
 	mat4 rotation = mat4(1.0f);
@@ -76,4 +84,15 @@ void Camera::update(int x, int y, float zoom, bool dragging, bool strafing)
 
 	lastX = x;
 	lastY = y;
-}
\ No newline at end of file
+}
+
+void Camera::setPose(const glm::vec3& position, const glm::vec3& direction)
+{
+	this->position = position;
+	vec3 up = vec3(0.0f, 1.0f, 0.0f);
+	vec3 front = normalize(direction);
+	vec3 right = normalize(cross(front, up));
+	vec3 zAxis = cross(right, front);
+	mat4 rotation = mat4(vec4(right, 0.0f), vec4(zAxis, 0.0f), vec4(-front, 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	viewMatrix = transpose(rotation)*translate(mat4(1.0f), -position);
+}
@@ -1,6 +1,6 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <glm\gtc\matrix_transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 class Camera
 {
@@ -17,6 +17,10 @@ public:
 
 	glm::mat4 getViewProjectionMatrix();
 	glm::vec3 getPosition();
+	//normalized looking direction
+	glm::vec3 getDirection() const;
 	void update(int x, int y, float zoom, bool dragging, bool strafing);
+	//looks from position in direction, replaces the orbit until the next update
+	void setPose(const glm::vec3& position, const glm::vec3& direction);
 };
 
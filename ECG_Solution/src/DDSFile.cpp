@@ -0,0 +1,165 @@
+#include "DDSFile.h"
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+	const uint32_t magic = 0x20534444; // "DDS "
+	const uint32_t flagCaps = 0x1;
+	const uint32_t flagHeight = 0x2;
+	const uint32_t flagWidth = 0x4;
+	const uint32_t flagPixelFormat = 0x1000;
+	const uint32_t flagMipMapCount = 0x20000;
+	const uint32_t flagLinearSize = 0x80000;
+	const uint32_t capsComplex = 0x8;
+	const uint32_t capsTexture = 0x1000;
+	const uint32_t capsMipMap = 0x400000;
+	const uint32_t pixelFormatFourCC = 0x4;
+
+	uint32_t fourCC(char a, char b, char c, char d)
+	{
+		return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+	}
+
+	struct DDSPixelFormat {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t rBitMask;
+		uint32_t gBitMask;
+		uint32_t bBitMask;
+		uint32_t aBitMask;
+	};
+
+	struct DDSHeader {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		DDSPixelFormat pixelFormat;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	GLenum dxgiFormat(uint32_t format)
+	{
+		switch (format)
+		{
+		case 71: case 72: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; // BC1_UNORM(_SRGB)
+		case 74: case 75: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; // BC2_UNORM(_SRGB)
+		case 77: case 78: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; // BC3_UNORM(_SRGB)
+		default: return GL_NONE;
+		}
+	}
+}
+
+unsigned int fullMipCount(unsigned int width, unsigned int height)
+{
+	unsigned int levels = 1;
+	for (unsigned int size = std::max(width, height); size > 1; size /= 2)
+	{
+		++levels;
+	}
+	return levels;
+}
+
+bool parseDDS(const unsigned char* data, size_t size, DDSTexture& texture)
+{
+	if (data == nullptr || size < sizeof(uint32_t) + sizeof(DDSHeader)) return false;
+
+	uint32_t fileMagic;
+	DDSHeader header;
+	std::memcpy(&fileMagic, data, sizeof(fileMagic));
+	std::memcpy(&header, data + sizeof(fileMagic), sizeof(header));
+	if (fileMagic != magic || header.size != sizeof(DDSHeader) || !(header.pixelFormat.flags & pixelFormatFourCC))
+	{
+		return false;
+	}
+
+	size_t offset = sizeof(fileMagic) + sizeof(header);
+	const uint32_t format = header.pixelFormat.fourCC;
+	if (format == fourCC('D', 'X', 'T', '1')) texture.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	else if (format == fourCC('D', 'X', 'T', '3')) texture.format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	else if (format == fourCC('D', 'X', 'T', '5')) texture.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	else if (format == fourCC('D', 'X', '1', '0') && size >= offset + sizeof(DDSHeaderDX10))
+	{
+		DDSHeaderDX10 headerDX10;
+		std::memcpy(&headerDX10, data + offset, sizeof(headerDX10));
+		texture.format = dxgiFormat(headerDX10.dxgiFormat);
+		offset += sizeof(headerDX10);
+	}
+	else texture.format = GL_NONE;
+	if (texture.format == GL_NONE || header.width == 0 || header.height == 0) return false;
+
+	texture.width = header.width;
+	texture.height = header.height;
+	unsigned int blockSize = texture.format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+	unsigned int levelCount = (header.flags & flagMipMapCount) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+	levelCount = std::min(levelCount, fullMipCount(texture.width, texture.height));
+
+	texture.levels.clear();
+	unsigned int width = texture.width, height = texture.height;
+	for (unsigned int level = 0; level < levelCount; ++level)
+	{
+		size_t levelSize = size_t((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+		if (offset + levelSize > size) return false;
+		texture.levels.push_back({ width, height, data + offset, levelSize });
+		offset += levelSize;
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+	return true;
+}
+
+bool loadDDSFile(const std::string& file, DDSTexture& texture)
+{
+	std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(file);
+	if (!mapping->isOpen() || !parseDDS(mapping->data(), mapping->getSize(), texture)) return false;
+	texture.file = mapping;
+	return true;
+}
+
+bool saveDDS(const std::string& file, GLenum format, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels)
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out || levels.empty()) return false;
+
+	DDSHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDSHeader);
+	header.flags = flagCaps | flagHeight | flagWidth | flagPixelFormat | flagLinearSize | (levels.size() > 1 ? flagMipMapCount : 0);
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = uint32_t(levels[0].size());
+	header.mipMapCount = uint32_t(levels.size());
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = pixelFormatFourCC;
+	header.pixelFormat.fourCC = format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? fourCC('D', 'X', 'T', '1')
+		: format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ? fourCC('D', 'X', 'T', '3') : fourCC('D', 'X', 'T', '5');
+	header.caps = capsTexture | (levels.size() > 1 ? capsComplex | capsMipMap : 0);
+
+	out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const std::vector<unsigned char>& level : levels)
+	{
+		out.write(reinterpret_cast<const char*>(level.data()), level.size());
+	}
+	return bool(out);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "MappedFile.h"
+
+/*!
+ * A block compressed (DXT1/3/5) '.dds' image with every mip level stored in the file
+ */
+struct DDSTexture {
+	//payload of one level, points into the file data
+	struct Level {
+		unsigned int width;
+		unsigned int height;
+		const unsigned char* data;
+		size_t size;
+	};
+
+	GLenum format = GL_NONE;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	//levels present in the file, a single level if the file has no mip chain
+	std::vector<Level> levels;
+	//keeps the mapping alive as long as the levels are used, null if parsed from memory
+	std::shared_ptr<MappedFile> file;
+};
+
+/*!
+ * Validates a '.dds' file in memory and points the levels into it, plain DXT1/3/5 and DX10 BC1/2/3 headers are supported
+ * @return false if the data is truncated or in an unsupported format
+ */
+bool parseDDS(const unsigned char* data, size_t size, DDSTexture& texture);
+
+/*!
+ * Memory maps a '.dds' file and parses it without copying the payload
+ * @return false if the file is missing, truncated or in an unsupported format
+ */
+bool loadDDSFile(const std::string& file, DDSTexture& texture);
+
+/*!
+ * Writes a DXT1/3/5 '.dds' file with the given levels, largest first
+ * @return false if the file could not be written
+ */
+bool saveDDS(const std::string& file, GLenum format, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned char>>& levels);
+
+/*!
+ * Number of levels of a full mip chain down to 1x1
+ */
+unsigned int fullMipCount(unsigned int width, unsigned int height);
@@ -0,0 +1,75 @@
+#include "DeferredRenderer.h"
+#include "RenderStatistics.h"
+#include "GLTrace.h"
+
+//first texture unit of the G-buffer in the lighting pass
+static const int gBufferUnit = 0;
+
+DeferredRenderer::DeferredRenderer(int width, int height) : gBuffer(width, height)
+{
+	gBufferShader = std::make_shared<Shader>("PBR_shader_phong.vert", "PBR_gbuffer.frag");
+	lightingShader = std::make_shared<Shader>("PBR_deferred.vert", "PBR_deferred.frag");
+	lightingShaders.push_back(lightingShader);
+
+	lightingShader->setUniform("gNormal", gBufferUnit + GBuffer::NORMAL);
+	lightingShader->setUniform("gBaseColor", gBufferUnit + GBuffer::BASE_COLOR);
+	lightingShader->setUniform("gMaterial", gBufferUnit + GBuffer::MATERIAL);
+	lightingShader->setUniform("gSheenClearcoat", gBufferUnit + GBuffer::SHEEN_CLEARCOAT);
+	lightingShader->setUniform("gDepth", gBufferUnit + GBuffer::TARGET_COUNT);
+
+	//attributeless full screen triangle still needs a bound VAO in core profile
+	glGenVertexArrays(1, &emptyVao);
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+	glDeleteVertexArrays(1, &emptyVao);
+}
+
+const std::vector<std::shared_ptr<Shader>>& DeferredRenderer::getLightingShaders()
+{
+	return lightingShaders;
+}
+
+void DeferredRenderer::render(const std::vector<Geometry*>& geometries, LightManager& lightManager, Camera& camera, GLuint targetFramebuffer)
+{
+	glm::mat4 viewProjectionMatrix = camera.getViewProjectionMatrix();
+
+	//Geometry pass
+	gBuffer.bind();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	gBufferShader->setUniform("viewProjectionMatrix", viewProjectionMatrix);
+	forwardGeometries.clear();
+	for (Geometry* geometry : geometries)
+	{
+		if (!geometry->drawGBuffer(gBufferShader))
+		{
+			forwardGeometries.push_back(geometry);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+
+	//Lighting pass, one full screen triangle
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	lightManager.setUniforms(lightingShaders);
+	lightingShader->setUniform("cameraPosition", camera.getPosition());
+	lightingShader->setUniform("inverseViewProjectionMatrix", glm::inverse(viewProjectionMatrix));
+	gBuffer.bindTextures(gBufferUnit);
+	glDisable(GL_DEPTH_TEST);
+	lightingShader->use();
+	glBindVertexArray(emptyVao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	RenderStatistics::add(RenderStatistics::VERTEX_ARRAY_BINDS);
+	RenderStatistics::add(RenderStatistics::DRAW_CALLS);
+	RenderStatistics::add(RenderStatistics::TRIANGLES);
+	RenderStatistics::add(RenderStatistics::VERTICES, 3);
+	glEnable(GL_DEPTH_TEST);
+
+	//Forward pass for the rest and whatever the caller draws afterwards, depth tested against the G-buffer
+	gBuffer.blitDepth(targetFramebuffer);
+	for (Geometry* geometry : forwardGeometries)
+	{
+		geometry->draw();
+	}
+}
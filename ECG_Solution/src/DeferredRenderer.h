@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "GBuffer.h"
+#include "Shader.h"
+#include "Geometry.h"
+#include "Camera.h"
+#include "LightManager.h"
+
+/*
+ Deferred shading: geometry pass into a compact G-buffer, then one full screen
+ lighting pass with the same BRDF as PBR_shader_phong.frag. Geometry whose
+ material has no G-buffer support is drawn forward afterwards.
+*/
+class DeferredRenderer
+{
+private:
+	GBuffer gBuffer;
+	std::shared_ptr<Shader> gBufferShader;
+	std::shared_ptr<Shader> lightingShader;
+	std::vector<std::shared_ptr<Shader>> lightingShaders;
+	GLuint emptyVao;
+	std::vector<Geometry*> forwardGeometries;
+public:
+	DeferredRenderer(int width, int height);
+	~DeferredRenderer();
+
+	const std::vector<std::shared_ptr<Shader>>& getLightingShaders();
+
+	/*!
+	 * Renders into the target framebuffer, forward shaders need their frame uniforms already set.
+	 * The target gets the G-buffer depth, so later forward draws like a TexturedBatch are occluded.
+	 */
+	void render(const std::vector<Geometry*>& geometries, LightManager& lightManager, Camera& camera, GLuint targetFramebuffer = 0);
+};
@@ -0,0 +1,87 @@
+#include "DrawList.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	//geometries per job, culling one is a matrix transform and six dot products
+	const size_t grainSize = 128;
+}
+
+DrawList::DrawList() : culled(0)
+{
+}
+
+void DrawList::build(const std::vector<Geometry*>& geometries, const glm::mat4& viewProjectionMatrix, const glm::vec3& cameraPosition, JobSystem& jobs, bool culling)
+{
+	Frustum frustum = getFrustum(viewProjectionMatrix);
+	entries.resize(geometries.size());
+	jobs.parallelFor(geometries.size(), grainSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			glm::vec4 sphere = geometries[i]->getBoundingSphere();
+			if (culling && !intersects(frustum, sphere))
+			{
+				entries[i] = { 0, nullptr };
+				continue;
+			}
+			glm::vec3 offset = glm::vec3(sphere) - cameraPosition;
+			entries[i] = { getSortKey(geometries[i]->getStateKey(), glm::dot(offset, offset)), geometries[i] };
+		}
+	});
+
+	visible.clear();
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) { return entry.geometry == nullptr; }), entries.end());
+	culled = geometries.size() - entries.size();
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+	for (const Entry& entry : entries)
+	{
+		visible.push_back(entry.geometry);
+	}
+}
+
+const std::vector<Geometry*>& DrawList::getVisible() const
+{
+	return visible;
+}
+
+size_t DrawList::getCulledCount() const
+{
+	return culled;
+}
+
+DrawList::Frustum DrawList::getFrustum(const glm::mat4& viewProjectionMatrix)
+{
+	//rows of the matrix, the planes are sums and differences of the last row with the others
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; ++row)
+	{
+		rows[row] = glm::vec4(viewProjectionMatrix[0][row], viewProjectionMatrix[1][row], viewProjectionMatrix[2][row], viewProjectionMatrix[3][row]);
+	}
+	Frustum frustum;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		frustum.planes[axis * 2] = rows[3] + rows[axis];
+		frustum.planes[axis * 2 + 1] = rows[3] - rows[axis];
+	}
+	for (glm::vec4& plane : frustum.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+bool DrawList::intersects(const Frustum& frustum, const glm::vec4& sphere)
+{
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w) return false;
+	}
+	return true;
+}
+
+uint64_t DrawList::getSortKey(uint32_t stateKey, float squaredDistance)
+{
+	uint32_t distanceBits;
+	std::memcpy(&distanceBits, &squaredDistance, sizeof(distanceBits));
+	return (uint64_t(stateKey) << 32) | distanceBits;
+}
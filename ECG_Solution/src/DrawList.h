@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Geometry.h"
+#include "JobSystem.h"
+
+/*
+ Geometries of a frame in draw order. Geometries whose bounding sphere is outside the view frustum
+ are culled, the others are sorted by program and material, then front to back within a material so
+ the depth test rejects hidden fragments early. Culling and sort keys are computed by jobs over
+ ranges of geometries, the sort and the draws stay on the GL thread.
+*/
+class DrawList
+{
+public:
+	//planes (normal, distance) facing inwards: a point p is inside if dot(normal, p) + distance >= 0 for all six
+	struct Frustum {
+		glm::vec4 planes[6];
+	};
+private:
+	struct Entry {
+		uint64_t key;
+		Geometry* geometry;
+	};
+	//one entry per geometry, culled ones have no geometry
+	std::vector<Entry> entries;
+	std::vector<Geometry*> visible;
+	size_t culled;
+public:
+	DrawList();
+
+	//culls and sorts geometries for the camera, culling off only sorts
+	void build(const std::vector<Geometry*>& geometries, const glm::mat4& viewProjectionMatrix, const glm::vec3& cameraPosition, JobSystem& jobs, bool culling = true);
+	//valid until the next build
+	const std::vector<Geometry*>& getVisible() const;
+	size_t getCulledCount() const;
+
+	static Frustum getFrustum(const glm::mat4& viewProjectionMatrix);
+	//sphere as center and radius
+	static bool intersects(const Frustum& frustum, const glm::vec4& sphere);
+	//state key in the upper 32 bits, the squared distance in the lower ones, positive floats sort like their bits
+	static uint64_t getSortKey(uint32_t stateKey, float squaredDistance);
+};
@@ -0,0 +1,86 @@
+#include "FlyThrough.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+namespace {
+	bool readVector(const std::string& line, const std::string& key, glm::vec3& result)
+	{
+		if (line.compare(0, key.size(), key) != 0) return false;
+		std::string numbers = line.substr(key.size());
+		std::replace(numbers.begin(), numbers.end(), ',', ' ');
+		std::replace(numbers.begin(), numbers.end(), '/', ' ');
+		std::istringstream stream(numbers);
+		return bool(stream >> result.x >> result.y >> result.z);
+	}
+
+	glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+FlyThrough::FlyThrough(const std::string& file)
+{
+	std::ifstream in(file);
+	if (!in)
+	{
+		std::cout << "Could not open waypoint file " << file << std::endl;
+		return;
+	}
+	std::string line;
+	Pose pose;
+	bool hasPosition = false;
+	while (std::getline(in, line))
+	{
+		line.erase(0, line.find_first_not_of(" \t"));
+		if (readVector(line, "Position:", pose.position))
+		{
+			hasPosition = true;
+		}
+		else if (hasPosition && readVector(line, "Direction:", pose.direction) && glm::length(pose.direction) > 0.0f)
+		{
+			pose.direction = glm::normalize(pose.direction);
+			waypoints.push_back(pose);
+			hasPosition = false;
+		}
+	}
+	if (!isLoaded())
+	{
+		std::cout << "Waypoint file " << file << " needs at least two waypoints" << std::endl;
+	}
+}
+
+bool FlyThrough::isLoaded() const
+{
+	return waypoints.size() >= 2;
+}
+
+size_t FlyThrough::getWaypointCount() const
+{
+	return waypoints.size();
+}
+
+size_t FlyThrough::getSegmentCount() const
+{
+	return isLoaded() ? waypoints.size() - 1 : 0;
+}
+
+FlyThrough::Pose FlyThrough::getPose(size_t segment, float t) const
+{
+	//the end points are repeated, so the path starts and ends at the first and last waypoint
+	const Pose& p0 = waypoints[segment > 0 ? segment - 1 : 0];
+	const Pose& p1 = waypoints[segment];
+	const Pose& p2 = waypoints[segment + 1];
+	const Pose& p3 = waypoints[std::min(segment + 2, waypoints.size() - 1)];
+	Pose pose;
+	pose.position = catmullRom(p0.position, p1.position, p2.position, p3.position, t);
+	pose.direction = catmullRom(p0.direction, p1.direction, p2.direction, p3.direction, t);
+	//opposite directions can cancel out
+	float length = glm::length(pose.direction);
+	pose.direction = length > 1e-4f ? pose.direction / length : glm::normalize(glm::mix(p1.direction, p2.direction, t < 0.5f ? 0.0f : 1.0f));
+	return pose;
+}
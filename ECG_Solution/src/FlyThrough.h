@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+ Camera path through recorded waypoints, read from a file of "Position: x,y,z" and
+ "Direction: x,y,z" lines like assets/lights.txt (',' or '/' between the numbers, other lines are skipped).
+ Positions and directions are interpolated with a Catmull-Rom spline, one segment between two waypoints.
+*/
+class FlyThrough
+{
+public:
+	struct Pose {
+		glm::vec3 position;
+		glm::vec3 direction;
+	};
+private:
+	std::vector<Pose> waypoints;
+public:
+	FlyThrough(const std::string& file);
+
+	//at least two waypoints were read
+	bool isLoaded() const;
+	size_t getWaypointCount() const;
+	size_t getSegmentCount() const;
+	//t from 0 at the start to 1 at the end of the segment
+	Pose getPose(size_t segment, float t) const;
+};
@@ -0,0 +1,81 @@
+#include "FrameReadback.h"
+#include "MemoryTracker.h"
+#include <cstring>
+
+FrameReadback::FrameReadback(int width, int height, Callback callback) : next(0), width(width), height(height), callback(callback)
+{
+	for (Buffer& buffer : buffers)
+	{
+		glGenBuffers(1, &buffer.pixels);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pixels);
+		glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(width) * height * 4, nullptr, GL_STREAM_READ);
+		MemoryTracker::allocate(MemoryTracker::STAGING_BUFFERS, buffer.pixels, size_t(width) * height * 4, "Frame read back");
+		buffer.fence = nullptr;
+		buffer.frame = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameReadback::~FrameReadback()
+{
+	for (Buffer& buffer : buffers)
+	{
+		if (buffer.fence != nullptr) glDeleteSync(buffer.fence);
+		glDeleteBuffers(1, &buffer.pixels);
+		MemoryTracker::release(MemoryTracker::STAGING_BUFFERS, buffer.pixels);
+	}
+}
+
+void FrameReadback::read(unsigned long frame)
+{
+	Buffer& buffer = buffers[next];
+	if (buffer.fence != nullptr)
+	{
+		finish(buffer);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pixels);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	buffer.frame = frame;
+	next = (next + 1) % bufferCount;
+}
+
+void FrameReadback::poll(bool wait)
+{
+	//the oldest read is the next buffer to be reused
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		Buffer& buffer = buffers[(next + i) % bufferCount];
+		if (buffer.fence == nullptr) continue;
+		if (!wait && glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+		finish(buffer);
+	}
+}
+
+void FrameReadback::finish(Buffer& buffer)
+{
+	glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+	glDeleteSync(buffer.fence);
+	buffer.fence = nullptr;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pixels);
+	const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(width) * height * 4, GL_MAP_READ_BIT);
+	if (pixels != nullptr)
+	{
+		//GL rows go from bottom to top
+		Image image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(size_t(width) * height * 4);
+		size_t rowSize = size_t(width) * 4;
+		for (int y = 0; y < height; ++y)
+		{
+			std::memcpy(&image.pixels[y * rowSize], pixels + (height - 1 - y) * rowSize, rowSize);
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		callback(buffer.frame, image);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
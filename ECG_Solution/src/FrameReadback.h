@@ -0,0 +1,38 @@
+#pragma once
+#include <GL/glew.h>
+#include <functional>
+#include "ImageFile.h"
+
+/*
+ Reads frames back without stalling the pipeline: glReadPixels copies into a pixel buffer object
+ and the buffer is only mapped once its fence has signaled, bufferCount - 1 frames later at the latest.
+*/
+class FrameReadback
+{
+public:
+	static const int bufferCount = 3;
+	typedef std::function<void(unsigned long frame, const Image& image)> Callback;
+private:
+	struct Buffer {
+		GLuint pixels;
+		GLsync fence;
+		unsigned long frame;
+	};
+	Buffer buffers[bufferCount];
+	int next;
+	int width;
+	int height;
+	Callback callback;
+
+	void finish(Buffer& buffer);
+public:
+	FrameReadback(int width, int height, Callback callback);
+	~FrameReadback();
+	FrameReadback(const FrameReadback&) = delete;
+	FrameReadback& operator=(const FrameReadback&) = delete;
+
+	//queues a read of the bound read framebuffer, waits for the oldest read if all buffers are in use
+	void read(unsigned long frame);
+	//hands finished reads to the callback in frame order, waits for all outstanding reads if wait is set
+	void poll(bool wait = false);
+};
@@ -0,0 +1,126 @@
+#include "FrameTimes.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+}
+
+FrameTimes::FrameTimes()
+{
+	reset();
+}
+
+int FrameTimes::bucketIndex(uint64_t microseconds)
+{
+	if (microseconds < subBuckets) return int(microseconds);
+	microseconds = std::min(microseconds, (uint64_t(1) << (maxShift + 7)) - 1);
+	//shift the value into [subBuckets / 2, subBuckets)
+	int shift = 0;
+	while ((microseconds >> shift) >= subBuckets) ++shift;
+	return subBuckets + (shift - 1) * subBuckets / 2 + int(microseconds >> shift) - subBuckets / 2;
+}
+
+double FrameTimes::bucketValue(int index)
+{
+	if (index < subBuckets) return double(index);
+	int shift = (index - subBuckets) / (subBuckets / 2) + 1;
+	uint64_t lower = uint64_t((index - subBuckets) % (subBuckets / 2) + subBuckets / 2) << shift;
+	return double(lower) + double((uint64_t(1) << shift) - 1) * 0.5;
+}
+
+void FrameTimes::add(double seconds)
+{
+	uint64_t microseconds = uint64_t(std::max(0.0, seconds) * 1e6 + 0.5);
+	++buckets[bucketIndex(microseconds)];
+	minimum = count == 0 ? microseconds : std::min(minimum, microseconds);
+	maximum = std::max(maximum, microseconds);
+	total += double(microseconds);
+	++count;
+}
+
+void FrameTimes::reset()
+{
+	std::fill(buckets, buckets + bucketCount, uint64_t(0));
+	count = 0;
+	minimum = 0;
+	maximum = 0;
+	total = 0.0;
+}
+
+uint64_t FrameTimes::getCount() const
+{
+	return count;
+}
+
+double FrameTimes::getMinimum() const
+{
+	return double(minimum) * 1e-3;
+}
+
+double FrameTimes::getMaximum() const
+{
+	return double(maximum) * 1e-3;
+}
+
+double FrameTimes::getMean() const
+{
+	return count > 0 ? total / double(count) * 1e-3 : 0.0;
+}
+
+double FrameTimes::getPercentile(double percent) const
+{
+	if (count == 0) return 0.0;
+	uint64_t rank = std::max(uint64_t(1), uint64_t(std::ceil(percent * 0.01 * double(count))));
+	uint64_t seen = 0;
+	for (int i = 0; i < bucketCount; ++i)
+	{
+		seen += buckets[i];
+		if (seen >= rank)
+		{
+			//the exact extremes are better than a bucket middle
+			return std::min(std::max(bucketValue(i), double(minimum)), double(maximum)) * 1e-3;
+		}
+	}
+	return getMaximum();
+}
+
+std::string FrameTimes::getReport() const
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(3);
+	out << "Frame times of " << count << " frames in ms: min " << getMinimum() << ", mean " << getMean();
+	for (double percent : percentiles)
+	{
+		out << ", p" << std::defaultfloat << percent << std::fixed << " " << getPercentile(percent);
+	}
+	out << ", max " << getMaximum() << "." << std::endl;
+	return out.str();
+}
+
+bool FrameTimes::appendCSV(const std::string& file, const std::string& label, const std::string& extraHeader, const std::string& extraValues) const
+{
+	bool exists = std::ifstream(file).good();
+	std::ofstream out(file, std::ios::app);
+	if (!out) return false;
+	if (!exists)
+	{
+		out << "label,frames,min_ms,mean_ms";
+		for (double percent : percentiles)
+		{
+			out << ",p" << percent << "_ms";
+		}
+		out << ",max_ms" << (extraHeader.empty() ? "" : ",") << extraHeader << "\n";
+	}
+	out << std::fixed << std::setprecision(3);
+	out << label << "," << count << "," << getMinimum() << "," << getMean();
+	for (double percent : percentiles)
+	{
+		out << "," << getPercentile(percent);
+	}
+	out << "," << getMaximum() << (extraValues.empty() ? "" : ",") << extraValues << "\n";
+	return bool(out);
+}
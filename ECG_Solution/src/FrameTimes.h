@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/*
+ Streaming histogram of frame times. Times are counted in microseconds in log-linear buckets
+ (like HdrHistogram): below 128us every microsecond has its own bucket, above that every power
+ of two is split into 64 buckets, so percentiles are within 1.6% of the exact value.
+ Memory is constant however long the program runs, minimum, maximum and mean are exact.
+*/
+class FrameTimes
+{
+public:
+	static const int subBuckets = 128;
+	//up to 2^36us, about 19 hours
+	static const int maxShift = 30;
+	static const int bucketCount = subBuckets + maxShift * subBuckets / 2;
+private:
+	uint64_t buckets[bucketCount];
+	uint64_t count;
+	uint64_t minimum;
+	uint64_t maximum;
+	double total;
+
+	static int bucketIndex(uint64_t microseconds);
+	//middle of the range of values counted by a bucket
+	static double bucketValue(int index);
+public:
+	FrameTimes();
+
+	//frame time in seconds
+	void add(double seconds);
+	void reset();
+
+	uint64_t getCount() const;
+	//in ms, 0 without frames
+	double getMinimum() const;
+	double getMaximum() const;
+	double getMean() const;
+	//in ms, the time percent percent of all frames were at most as long as
+	double getPercentile(double percent) const;
+
+	//min, mean, p50, p90, p99, p99.9 and max
+	std::string getReport() const;
+	/*!
+	 * Appends the report as one row to a CSV file, a header is written if the file is new
+	 * @param label first column, e.g. the scene
+	 * @param extraHeader, extraValues comma separated columns appended to the header and the row
+	 * @return false if the file could not be written
+	 */
+	bool appendCSV(const std::string& file, const std::string& label, const std::string& extraHeader = "", const std::string& extraValues = "") const;
+};
@@ -0,0 +1,101 @@
+#include "GBuffer.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "GLTrace.h"
+
+GBuffer::GBuffer(int width, int height) : width(width), height(height)
+{
+	//base color is linear, sRGB storage keeps 8 bit precision where it is visible
+	const GLenum formats[TARGET_COUNT] = { GL_RG16, GL_SRGB8_ALPHA8, GL_RGBA8, GL_RGBA8 };
+
+	//the previous binding is restored afterwards, the headless renderer draws into an offscreen framebuffer
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+	glGenTextures(TARGET_COUNT, textures);
+	GLenum drawBuffers[TARGET_COUNT];
+	for (int i = 0; i < TARGET_COUNT; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
+		MemoryTracker::allocate(MemoryTracker::FRAMEBUFFERS, textures[i], MemoryTracker::getTextureSize(formats[i], width, height, 1), "G-buffer target");
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	glDrawBuffers(TARGET_COUNT, drawBuffers);
+
+	//Same format as the usual default framebuffer, otherwise the depth blit fails
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+	MemoryTracker::allocate(MemoryTracker::FRAMEBUFFERS, depthTexture, MemoryTracker::getTextureSize(GL_DEPTH24_STENCIL8, width, height, 1), "G-buffer depth");
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "G-buffer framebuffer incomplete" << std::endl;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previousFramebuffer));
+}
+
+GBuffer::~GBuffer()
+{
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(TARGET_COUNT, textures);
+	glDeleteTextures(1, &depthTexture);
+	for (int i = 0; i < TARGET_COUNT; ++i)
+	{
+		MemoryTracker::release(MemoryTracker::FRAMEBUFFERS, textures[i]);
+	}
+	MemoryTracker::release(MemoryTracker::FRAMEBUFFERS, depthTexture);
+}
+
+void GBuffer::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+}
+
+void GBuffer::unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::bindTextures(int firstUnit)
+{
+	for (int i = 0; i < TARGET_COUNT; ++i)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0 + firstUnit + TARGET_COUNT);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+	RenderStatistics::add(RenderStatistics::TEXTURE_BINDS, TARGET_COUNT + 1);
+}
+
+void GBuffer::blitDepth(GLuint targetFramebuffer)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+}
+
+int GBuffer::getWidth()
+{
+	return width;
+}
+
+int GBuffer::getHeight()
+{
+	return height;
+}
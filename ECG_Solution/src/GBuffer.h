@@ -0,0 +1,41 @@
+#pragma once
+#include <GL/glew.h>
+#include <iostream>
+
+/*
+ Compact G-buffer for deferred shading:
+ NORMAL          RG16     octahedral encoded world space normal
+ BASE_COLOR      SRGB8_A8 linear base color, metallic
+ MATERIAL        RGBA8    roughness, specular, specular tint, ambient
+ SHEEN_CLEARCOAT RGBA8    sheen, sheen tint, clearcoat, clearcoat gloss
+ plus a depth texture, world positions are reconstructed from depth.
+*/
+class GBuffer
+{
+public:
+	enum Target {
+		NORMAL = 0,
+		BASE_COLOR,
+		MATERIAL,
+		SHEEN_CLEARCOAT,
+		TARGET_COUNT
+	};
+private:
+	GLuint fbo;
+	GLuint textures[TARGET_COUNT];
+	GLuint depthTexture;
+	int width, height;
+public:
+	GBuffer(int width, int height);
+	~GBuffer();
+
+	void bind();
+	void unbind();
+	//Binds the targets to the texture units firstUnit ... firstUnit + TARGET_COUNT, depth is last
+	void bindTextures(int firstUnit);
+	//Copies the depth buffer into the given framebuffer, so forward passes can depth test against it
+	void blitDepth(GLuint targetFramebuffer);
+
+	int getWidth();
+	int getHeight();
+};
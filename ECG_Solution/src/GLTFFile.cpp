@@ -0,0 +1,392 @@
+#include "GLTFFile.h"
+#include "JsonValue.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "ModelImporter.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+	const uint32_t glbMagic = 0x46546C67; // "glTF"
+	const uint32_t glbChunkJSON = 0x4E4F534A;
+	const uint32_t glbChunkBIN = 0x004E4942;
+	const int modeTriangles = 4;
+
+	struct Buffer {
+		const unsigned char* data;
+		size_t size;
+	};
+
+	//everything the accessors may point into, kept alive until the mesh is copied out
+	struct Document {
+		JsonValue json;
+		std::vector<Buffer> buffers;
+		std::vector<std::shared_ptr<MappedFile>> files;
+		std::vector<std::vector<unsigned char>> decoded;
+	};
+
+	bool decodeBase64(const std::string& text, size_t begin, std::vector<unsigned char>& data)
+	{
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (size_t i = begin; i < text.size() && text[i] != '='; ++i)
+		{
+			char c = text[i];
+			int value = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52
+				: c == '+' ? 62 : c == '/' ? 63 : -1;
+			if (value < 0) return false;
+			bits = bits << 6 | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				data.push_back((unsigned char)(bits >> bitCount));
+			}
+		}
+		return true;
+	}
+
+	bool loadBuffers(const std::string& file, Document& document, const Buffer& glbChunk)
+	{
+		std::string directory = file.substr(0, file.find_last_of("/\\") + 1);
+		const JsonValue& buffers = document.json["buffers"];
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			const JsonValue& buffer = buffers[i];
+			size_t length = size_t(buffer["byteLength"].asNumber());
+			const std::string& uri = buffer["uri"].asString();
+			Buffer data = { nullptr, 0 };
+			if (uri.empty())
+			{
+				//the binary chunk of a '.glb'
+				data = glbChunk;
+			}
+			else if (uri.compare(0, 5, "data:") == 0)
+			{
+				size_t comma = uri.find(',');
+				document.decoded.emplace_back();
+				if (comma == std::string::npos || uri.find(";base64") > comma || !decodeBase64(uri, comma + 1, document.decoded.back())) return false;
+				data = { document.decoded.back().data(), document.decoded.back().size() };
+			}
+			else
+			{
+				std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(directory + uri);
+				if (!mapping->isOpen())
+				{
+					std::cout << "Missing glTF buffer " << directory + uri << std::endl;
+					return false;
+				}
+				document.files.push_back(mapping);
+				data = { mapping->data(), mapping->getSize() };
+			}
+			if (data.size < length) return false;
+			document.buffers.push_back(data);
+		}
+		return true;
+	}
+
+	float readComponent(const unsigned char* data, int componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case GL_FLOAT: { float value; std::memcpy(&value, data, 4); return value; }
+		case GL_UNSIGNED_BYTE: return normalized ? data[0] / 255.0f : float(data[0]);
+		case GL_BYTE: return normalized ? std::max(int8_t(data[0]) / 127.0f, -1.0f) : float(int8_t(data[0]));
+		case GL_UNSIGNED_SHORT: { uint16_t value; std::memcpy(&value, data, 2); return normalized ? value / 65535.0f : float(value); }
+		case GL_SHORT: { int16_t value; std::memcpy(&value, data, 2); return normalized ? std::max(value / 32767.0f, -1.0f) : float(value); }
+		case GL_UNSIGNED_INT: { uint32_t value; std::memcpy(&value, data, 4); return float(value); }
+		default: return 0.0f;
+		}
+	}
+
+	size_t componentSize(int componentType)
+	{
+		return componentType == GL_BYTE || componentType == GL_UNSIGNED_BYTE ? 1 : componentType == GL_SHORT || componentType == GL_UNSIGNED_SHORT ? 2 : 4;
+	}
+
+	//start, element stride and count of an accessor, checked against the buffer size
+	bool locateAccessor(const Document& document, int index, int components, const unsigned char*& data, size_t& stride, size_t& count, int& componentType)
+	{
+		const JsonValue& accessor = document.json["accessors"][size_t(index)];
+		const JsonValue& view = document.json["bufferViews"][size_t(accessor["bufferView"].asInt(-1))];
+		size_t buffer = size_t(view["buffer"].asInt(-1));
+		if (!accessor.isObject() || !view.isObject() || buffer >= document.buffers.size() || accessor.has("sparse")) return false;
+
+		static const char* types[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+		if (accessor["type"].asString() != types[components - 1]) return false;
+		componentType = accessor["componentType"].asInt();
+		count = size_t(accessor["count"].asNumber());
+		size_t elementSize = componentSize(componentType) * components;
+		stride = view.has("byteStride") ? size_t(view["byteStride"].asNumber()) : elementSize;
+		size_t offset = size_t(view["byteOffset"].asNumber()) + size_t(accessor["byteOffset"].asNumber());
+		size_t viewEnd = size_t(view["byteOffset"].asNumber()) + size_t(view["byteLength"].asNumber());
+		if (count > 0 && (offset + (count - 1) * stride + elementSize > viewEnd || viewEnd > document.buffers[buffer].size)) return false;
+		data = document.buffers[buffer].data + offset;
+		return true;
+	}
+
+	bool readFloats(const Document& document, int index, int components, std::vector<float>& values)
+	{
+		const unsigned char* data;
+		size_t stride, count;
+		int componentType;
+		if (!locateAccessor(document, index, components, data, stride, count, componentType)) return false;
+		bool normalized = document.json["accessors"][size_t(index)]["normalized"].asBool();
+		size_t size = componentSize(componentType);
+		values.resize(count * components);
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int component = 0; component < components; ++component)
+			{
+				values[i * components + component] = readComponent(data + i * stride + component * size, componentType, normalized);
+			}
+		}
+		return true;
+	}
+
+	bool readIndices(const Document& document, int index, std::vector<unsigned int>& indices)
+	{
+		const unsigned char* data;
+		size_t stride, count;
+		int componentType;
+		if (!locateAccessor(document, index, 1, data, stride, count, componentType)) return false;
+		indices.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const unsigned char* element = data + i * stride;
+			if (componentType == GL_UNSIGNED_BYTE) indices[i] = element[0];
+			else if (componentType == GL_UNSIGNED_SHORT) { uint16_t value; std::memcpy(&value, element, 2); indices[i] = value; }
+			else if (componentType == GL_UNSIGNED_INT) std::memcpy(&indices[i], element, 4);
+			else return false;
+		}
+		return true;
+	}
+
+	glm::mat4 nodeTransform(const JsonValue& node)
+	{
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.size() == 16)
+		{
+			glm::mat4 result;
+			for (int i = 0; i < 16; ++i) glm::value_ptr(result)[i] = float(matrix[size_t(i)].asNumber());
+			return result;
+		}
+		const JsonValue& t = node["translation"], & r = node["rotation"], & s = node["scale"];
+		glm::vec3 translation(t[0].asNumber(), t[1].asNumber(), t[2].asNumber());
+		glm::quat rotation(float(r[3].asNumber(1.0)), float(r[0].asNumber()), float(r[1].asNumber()), float(r[2].asNumber()));
+		glm::vec3 scale(s[0].asNumber(1.0), s[1].asNumber(1.0), s[2].asNumber(1.0));
+		glm::mat4 result = glm::mat4_cast(rotation);
+		result[0] *= scale.x;
+		result[1] *= scale.y;
+		result[2] *= scale.z;
+		result[3] = glm::vec4(translation, 1.0f);
+		return result;
+	}
+
+	//a triangle primitive and the transform of the node drawing it
+	struct PrimitiveInstance {
+		const JsonValue* primitive;
+		glm::mat4 transform;
+	};
+
+	void collectMesh(const JsonValue& mesh, const glm::mat4& transform, std::vector<PrimitiveInstance>& instances)
+	{
+		const JsonValue& primitives = mesh["primitives"];
+		for (size_t p = 0; p < primitives.size(); ++p)
+		{
+			const JsonValue& primitive = primitives[p];
+			if (primitive["mode"].asInt(modeTriangles) != modeTriangles || !primitive["attributes"].has("POSITION")) continue;
+			instances.push_back({ &primitive, transform });
+		}
+	}
+
+	bool collectNode(const Document& document, int index, const glm::mat4& parent, std::vector<PrimitiveInstance>& instances, int depth)
+	{
+		const JsonValue& node = document.json["nodes"][size_t(index)];
+		//a node graph is a forest, the depth limit only guards against malformed cycles
+		if (!node.isObject() || depth > 64) return false;
+		glm::mat4 transform = parent * nodeTransform(node);
+		if (node.has("mesh")) collectMesh(document.json["meshes"][size_t(node["mesh"].asInt())], transform, instances);
+		const JsonValue& children = node["children"];
+		for (size_t i = 0; i < children.size(); ++i)
+		{
+			if (!collectNode(document, children[i].asInt(), transform, instances, depth + 1)) return false;
+		}
+		return true;
+	}
+
+	bool decodePrimitive(const Document& document, const PrimitiveInstance& instance, GeometryData& part)
+	{
+		const JsonValue& primitive = *instance.primitive;
+		const JsonValue& attributes = primitive["attributes"];
+		glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(instance.transform)));
+		std::vector<float> values;
+		if (!readFloats(document, attributes["POSITION"].asInt(), 3, values)) return false;
+		for (size_t i = 0; i + 2 < values.size(); i += 3)
+		{
+			part.positions.push_back(glm::vec3(instance.transform * glm::vec4(values[i], values[i + 1], values[i + 2], 1.0f)));
+		}
+		if (primitive.has("indices"))
+		{
+			if (!readIndices(document, primitive["indices"].asInt(), part.indices)) return false;
+		}
+		else
+		{
+			for (unsigned int i = 0; i < part.positions.size(); ++i) part.indices.push_back(i);
+		}
+		part.indices.resize(part.indices.size() / 3 * 3);
+		for (unsigned int index : part.indices)
+		{
+			if (index >= part.positions.size()) return false;
+		}
+
+		if (attributes.has("NORMAL") && readFloats(document, attributes["NORMAL"].asInt(), 3, values) && values.size() == part.positions.size() * 3)
+		{
+			for (size_t i = 0; i + 2 < values.size(); i += 3)
+			{
+				part.normals.push_back(glm::normalize(normalMatrix * glm::vec3(values[i], values[i + 1], values[i + 2])));
+			}
+		}
+		else
+		{
+			MeshOptimizer::computeNormals(part);
+		}
+		if (attributes.has("TEXCOORD_0") && readFloats(document, attributes["TEXCOORD_0"].asInt(), 2, values) && values.size() == part.positions.size() * 2)
+		{
+			//glTF has the uv origin at the top left
+			for (size_t i = 0; i + 1 < values.size(); i += 2) part.uv.push_back(glm::vec2(values[i], 1.0f - values[i + 1]));
+		}
+		else
+		{
+			part.uv.assign(part.positions.size(), glm::vec2(0.0f));
+		}
+		return true;
+	}
+
+	ImportedMaterial readMaterial(const Document& document, const JsonValue& material, const std::string& directory)
+	{
+		ImportedMaterial result;
+		const JsonValue& pbr = material["pbrMetallicRoughness"];
+		const JsonValue& color = pbr["baseColorFactor"];
+		result.name = material["name"].asString();
+		result.baseColor = glm::vec3(color[0].asNumber(1.0), color[1].asNumber(1.0), color[2].asNumber(1.0));
+		result.metallic = float(pbr["metallicFactor"].asNumber(1.0));
+		result.roughness = float(pbr["roughnessFactor"].asNumber(1.0));
+		const JsonValue& texture = document.json["textures"][size_t(pbr["baseColorTexture"]["index"].asInt(-1))];
+		const std::string& uri = document.json["images"][size_t(texture["source"].asInt(-1))]["uri"].asString();
+		if (!uri.empty() && uri.compare(0, 5, "data:") != 0) result.baseColorTexture = directory + uri;
+		return result;
+	}
+}
+
+bool importGLTF(const std::string& file, ImportedModel& model, const ImportSettings& settings)
+{
+	model = ImportedModel();
+	MappedFile mapping(file);
+	if (!mapping.isOpen()) return false;
+	const unsigned char* data = mapping.data();
+	size_t size = mapping.getSize();
+
+	//a '.glb' is a JSON chunk followed by an optional binary chunk
+	Buffer json = { data, size }, binary = { nullptr, 0 };
+	uint32_t magic = 0;
+	if (size >= 4) std::memcpy(&magic, data, 4);
+	if (magic == glbMagic)
+	{
+		uint32_t chunk[2];
+		if (size < 20) return false;
+		std::memcpy(chunk, data + 12, 8);
+		if (chunk[1] != glbChunkJSON || 20 + size_t(chunk[0]) > size) return false;
+		json = { data + 20, chunk[0] };
+		size_t next = 20 + ((size_t(chunk[0]) + 3) & ~size_t(3));
+		if (next + 8 <= size)
+		{
+			std::memcpy(chunk, data + next, 8);
+			if (chunk[1] == glbChunkBIN && next + 8 + chunk[0] <= size) binary = { data + next + 8, chunk[0] };
+		}
+	}
+
+	Document document;
+	std::string error;
+	if (!JsonValue::parse(reinterpret_cast<const char*>(json.data), reinterpret_cast<const char*>(json.data) + json.size, document.json, error))
+	{
+		std::cout << "Invalid glTF " << file << ": " << error << std::endl;
+		return false;
+	}
+	if (!loadBuffers(file, document, binary)) return false;
+	model.sourceSize = size;
+	for (const Buffer& buffer : document.buffers)
+	{
+		if (buffer.data != binary.data) model.sourceSize += buffer.size;
+	}
+
+	std::vector<PrimitiveInstance> instances;
+	const JsonValue& scenes = document.json["scenes"];
+	if (scenes.size() > 0)
+	{
+		const JsonValue& nodes = scenes[size_t(document.json["scene"].asInt(0))]["nodes"];
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			if (!collectNode(document, nodes[i].asInt(), glm::mat4(1.0f), instances, 0)) return false;
+		}
+	}
+	else
+	{
+		//no scene, the meshes are used untransformed
+		const JsonValue& meshes = document.json["meshes"];
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			collectMesh(meshes[i], glm::mat4(1.0f), instances);
+		}
+	}
+
+	//primitives are decoded in parallel, then appended to the mesh of their material in order
+	std::vector<GeometryData> parts(instances.size());
+	std::vector<char> decoded(instances.size(), 0);
+	parallelFor(instances.size(), importThreadCount(settings), [&](size_t i) {
+		decoded[i] = decodePrimitive(document, instances[i], parts[i]);
+		parts[i].track();
+	});
+	if (std::find(decoded.begin(), decoded.end(), 0) != decoded.end()) return false;
+
+	std::string directory = file.substr(0, file.find_last_of("/\\") + 1);
+	const JsonValue& materials = document.json["materials"];
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		model.materials.push_back(readMaterial(document, materials[i], directory));
+	}
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		int material = (*instances[i].primitive)["material"].asInt(-1);
+		if (material >= int(model.materials.size())) material = -1;
+		size_t mesh = std::find(model.meshMaterials.begin(), model.meshMaterials.end(), material) - model.meshMaterials.begin();
+		if (mesh == model.meshMaterials.size())
+		{
+			model.meshes.emplace_back();
+			model.meshMaterials.push_back(material);
+		}
+		GeometryData& geometry = model.meshes[mesh];
+		unsigned int base = (unsigned int)geometry.positions.size();
+		geometry.positions.insert(geometry.positions.end(), parts[i].positions.begin(), parts[i].positions.end());
+		geometry.normals.insert(geometry.normals.end(), parts[i].normals.begin(), parts[i].normals.end());
+		geometry.uv.insert(geometry.uv.end(), parts[i].uv.begin(), parts[i].uv.end());
+		for (unsigned int index : parts[i].indices) geometry.indices.push_back(base + index);
+	}
+	for (GeometryData& geometry : model.meshes)
+	{
+		geometry.track();
+	}
+	return !model.meshes.empty();
+}
+
+bool loadGLTF(const std::string& file, GeometryData& geometry)
+{
+	ImportedModel model;
+	if (!importGLTF(file, model)) return false;
+	geometry = mergeMeshes(model);
+	return !geometry.indices.empty();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include "Geometry.h"
+#include "ModelImporter.h"
+
+/*!
+ * Loads the triangle primitives of a glTF 2.0 '.gltf' (external or base64 embedded buffers) or '.glb' file,
+ * transformed by their nodes in the default scene and merged into one mesh. Missing normals are computed.
+ * @return false if the file is missing, malformed or has no triangles
+ */
+bool loadGLTF(const std::string& file, GeometryData& geometry);
+
+/*!
+ * Imports a glTF 2.0 file split by material, with the metallic roughness parameters and base color texture
+ * of each material. Primitives are decoded on settings.threadCount threads, files are always mapped.
+ * @return false if the file is missing, malformed or has no triangles
+ */
+bool importGLTF(const std::string& file, ImportedModel& model, const ImportSettings& settings = ImportSettings());
@@ -0,0 +1,455 @@
+#define GL_TRACE_NO_WRAPPERS
+#include "GLTrace.h"
+#include <map>
+#include <tuple>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	const char* names[GLTrace::COMMAND_COUNT] = {
+		"glUseProgram", "glProgramUniform1i", "glProgramUniform1f", "glProgramUniform3f",
+		"glProgramUniformMatrix3fv", "glProgramUniformMatrix4fv", "glBindVertexArray", "glBindBuffer",
+		"glBindBufferBase", "glBufferData", "glActiveTexture", "glBindTexture", "glBindFramebuffer",
+		"glBlitFramebuffer", "glDrawBuffers", "glViewport", "glClear", "glClearColor", "glEnable",
+		"glDisable", "glDepthFunc", "glDepthMask", "glColorMask", "glCullFace", "glPolygonMode",
+		"glDrawArrays", "glDrawElements", "glMultiDrawElementsIndirect"
+	};
+
+	const char magic[4] = { 'G', 'L', 'T', 'R' };
+	const uint32_t version = 1;
+
+	class Reader
+	{
+		const unsigned char* begin;
+		const unsigned char* position;
+	public:
+		Reader(const unsigned char* data) : begin(data), position(data) {}
+		const unsigned char* get() const { return position; }
+
+		template<typename T> T read()
+		{
+			T value;
+			std::memcpy(&value, position, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+		const void* readData()
+		{
+			position = begin + ((position - begin + 3) & ~ptrdiff_t(3));
+			uint32_t size = read<uint32_t>();
+			const unsigned char* data = position;
+			position += (size + 3) & ~3u;
+			return data;
+		}
+	};
+
+	/* Last value set for each piece of state the stream changes, a command is redundant if it sets
+	 the tracked value again. State nobody set yet is unknown, so the first command always goes through */
+	struct StateCache {
+		GLuint program = GLuint(-1);
+		GLuint vertexArray = GLuint(-1);
+		GLenum activeTexture = 0;
+		GLuint readFramebuffer = GLuint(-1);
+		GLuint drawFramebuffer = GLuint(-1);
+		std::map<GLenum, GLuint> buffers;
+		std::map<std::pair<GLenum, GLuint>, GLuint> bufferBases;
+		std::map<std::pair<GLenum, GLenum>, GLuint> textures;
+		std::map<GLenum, bool> capabilities;
+		std::map<std::pair<GLuint, GLint>, std::tuple<GLint, GLfloat, GLfloat, GLfloat>> uniforms;
+		std::map<int, std::tuple<GLint, GLint, GLsizei, GLsizei>> viewport;
+		std::map<int, std::tuple<GLfloat, GLfloat, GLfloat, GLfloat>> clearColor;
+		std::map<int, std::tuple<GLboolean, GLboolean, GLboolean, GLboolean>> colorMask;
+		std::map<int, GLenum> depthFunc;
+		std::map<int, GLboolean> depthMask;
+		std::map<int, GLenum> cullFace;
+		std::map<GLenum, GLenum> polygonMode;
+
+		//true if key was already set to value, otherwise remembers it
+		template<typename K, typename V> static bool same(std::map<K, V>& values, const K& key, const V& value)
+		{
+			auto inserted = values.insert({ key, value });
+			if (inserted.second) return false;
+			if (inserted.first->second == value) return true;
+			inserted.first->second = value;
+			return false;
+		}
+		template<typename V> static bool same(V& current, const V& value)
+		{
+			if (current == value) return true;
+			current = value;
+			return false;
+		}
+	};
+}
+
+bool GLTrace::recording = false;
+std::vector<unsigned char> GLTrace::stream;
+size_t GLTrace::commandCount = 0;
+
+void GLTrace::begin()
+{
+	stream.clear();
+	commandCount = 0;
+	recording = true;
+}
+
+void GLTrace::end()
+{
+	recording = false;
+}
+
+size_t GLTrace::getCommandCount()
+{
+	return commandCount;
+}
+
+size_t GLTrace::getByteSize()
+{
+	return stream.size();
+}
+
+const char* GLTrace::getName(Command command)
+{
+	return names[command];
+}
+
+void GLTrace::recordData(const void* data, size_t size)
+{
+	stream.resize((stream.size() + 3) & ~size_t(3), 0);
+	put(uint32_t(size));
+	size_t offset = stream.size();
+	stream.resize(offset + ((size + 3) & ~size_t(3)), 0);
+	if (size > 0) std::memcpy(stream.data() + offset, data, size);
+}
+
+bool GLTrace::save(const std::string& file)
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out) return false;
+	uint64_t commands = commandCount, bytes = stream.size();
+	out.write(magic, sizeof(magic));
+	out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	out.write(reinterpret_cast<const char*>(&commands), sizeof(commands));
+	out.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+	out.write(reinterpret_cast<const char*>(stream.data()), stream.size());
+	return bool(out);
+}
+
+bool GLTrace::load(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	char fileMagic[4];
+	uint32_t fileVersion = 0;
+	uint64_t commands = 0, bytes = 0;
+	in.read(fileMagic, sizeof(fileMagic));
+	in.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+	in.read(reinterpret_cast<char*>(&commands), sizeof(commands));
+	in.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+	if (!in || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version)
+	{
+		std::cout << "Not a GL trace: " << file << std::endl;
+		return false;
+	}
+	std::vector<unsigned char> data((size_t)bytes);
+	in.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!in)
+	{
+		std::cout << "GL trace is truncated: " << file << std::endl;
+		return false;
+	}
+	recording = false;
+	stream.swap(data);
+	commandCount = size_t(commands);
+	return true;
+}
+
+GLTrace::ReplayResult GLTrace::replay(unsigned int frames, bool skipRedundant)
+{
+	ReplayResult result;
+	if (recording || stream.empty() || frames == 0) return result;
+
+	StateCache cache;
+	size_t issued = 0, skipped = 0;
+	double submitTime = 0.0;
+	const unsigned char* streamEnd = stream.data() + stream.size();
+
+	//Shader::use() skips binding the program it bound last, so that one is bound again afterwards
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	glFinish();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int frame = 0; frame < frames; ++frame)
+	{
+		auto frameStart = std::chrono::high_resolution_clock::now();
+		Reader in(stream.data());
+		while (in.get() < streamEnd)
+		{
+			Command command = in.read<Command>();
+			bool redundant = false;
+			switch (command)
+			{
+			case USE_PROGRAM:
+			{
+				GLuint program = in.read<GLuint>();
+				redundant = skipRedundant && StateCache::same(cache.program, program);
+				if (!redundant) glUseProgram(program);
+				break;
+			}
+			case PROGRAM_UNIFORM_1I:
+			{
+				GLuint program = in.read<GLuint>();
+				GLint location = in.read<GLint>(), v0 = in.read<GLint>();
+				redundant = skipRedundant && StateCache::same(cache.uniforms, { program, location }, std::make_tuple(v0, 0.0f, 0.0f, 0.0f));
+				if (!redundant) glProgramUniform1i(program, location, v0);
+				break;
+			}
+			case PROGRAM_UNIFORM_1F:
+			{
+				GLuint program = in.read<GLuint>();
+				GLint location = in.read<GLint>();
+				GLfloat v0 = in.read<GLfloat>();
+				redundant = skipRedundant && StateCache::same(cache.uniforms, { program, location }, std::make_tuple(0, v0, 0.0f, 0.0f));
+				if (!redundant) glProgramUniform1f(program, location, v0);
+				break;
+			}
+			case PROGRAM_UNIFORM_3F:
+			{
+				GLuint program = in.read<GLuint>();
+				GLint location = in.read<GLint>();
+				GLfloat v0 = in.read<GLfloat>(), v1 = in.read<GLfloat>(), v2 = in.read<GLfloat>();
+				redundant = skipRedundant && StateCache::same(cache.uniforms, { program, location }, std::make_tuple(0, v0, v1, v2));
+				if (!redundant) glProgramUniform3f(program, location, v0, v1, v2);
+				break;
+			}
+			case PROGRAM_UNIFORM_MATRIX_3FV:
+			case PROGRAM_UNIFORM_MATRIX_4FV:
+			{
+				GLuint program = in.read<GLuint>();
+				GLint location = in.read<GLint>();
+				GLsizei count = in.read<GLsizei>();
+				GLboolean transpose = in.read<GLboolean>();
+				const GLfloat* value = static_cast<const GLfloat*>(in.readData());
+				//matrices change every frame, Shader already skips the ones that don't
+				if (command == PROGRAM_UNIFORM_MATRIX_3FV) glProgramUniformMatrix3fv(program, location, count, transpose, value);
+				else glProgramUniformMatrix4fv(program, location, count, transpose, value);
+				break;
+			}
+			case BIND_VERTEX_ARRAY:
+			{
+				GLuint array = in.read<GLuint>();
+				redundant = skipRedundant && StateCache::same(cache.vertexArray, array);
+				if (!redundant)
+				{
+					glBindVertexArray(array);
+					//the element array binding belongs to the vertex array
+					cache.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+				}
+				break;
+			}
+			case BIND_BUFFER:
+			{
+				GLenum target = in.read<GLenum>();
+				GLuint buffer = in.read<GLuint>();
+				redundant = skipRedundant && StateCache::same(cache.buffers, target, buffer);
+				if (!redundant) glBindBuffer(target, buffer);
+				break;
+			}
+			case BIND_BUFFER_BASE:
+			{
+				GLenum target = in.read<GLenum>();
+				GLuint index = in.read<GLuint>(), buffer = in.read<GLuint>();
+				redundant = skipRedundant && StateCache::same(cache.bufferBases, { target, index }, buffer);
+				if (!redundant)
+				{
+					glBindBufferBase(target, index, buffer);
+					cache.buffers[target] = buffer;
+				}
+				break;
+			}
+			case BUFFER_DATA:
+			{
+				GLenum target = in.read<GLenum>();
+				int64_t size = in.read<int64_t>();
+				GLenum usage = in.read<GLenum>();
+				bool hasData = in.read<uint8_t>() != 0;
+				const void* data = hasData ? in.readData() : nullptr;
+				glBufferData(target, GLsizeiptr(size), data, usage);
+				break;
+			}
+			case ACTIVE_TEXTURE:
+			{
+				GLenum texture = in.read<GLenum>();
+				redundant = skipRedundant && StateCache::same(cache.activeTexture, texture);
+				if (!redundant) glActiveTexture(texture);
+				break;
+			}
+			case BIND_TEXTURE:
+			{
+				GLenum target = in.read<GLenum>();
+				GLuint texture = in.read<GLuint>();
+				//the unit is unknown until the stream selects one
+				redundant = skipRedundant && cache.activeTexture != 0 && StateCache::same(cache.textures, { cache.activeTexture, target }, texture);
+				if (!redundant) glBindTexture(target, texture);
+				break;
+			}
+			case BIND_FRAMEBUFFER:
+			{
+				GLenum target = in.read<GLenum>();
+				GLuint framebuffer = in.read<GLuint>();
+				if (target == GL_FRAMEBUFFER)
+				{
+					redundant = skipRedundant && cache.readFramebuffer == framebuffer && cache.drawFramebuffer == framebuffer;
+					cache.readFramebuffer = cache.drawFramebuffer = framebuffer;
+				}
+				else
+				{
+					redundant = skipRedundant && StateCache::same(target == GL_READ_FRAMEBUFFER ? cache.readFramebuffer : cache.drawFramebuffer, framebuffer);
+				}
+				if (!redundant) glBindFramebuffer(target, framebuffer);
+				break;
+			}
+			case BLIT_FRAMEBUFFER:
+			{
+				GLint srcX0 = in.read<GLint>(), srcY0 = in.read<GLint>(), srcX1 = in.read<GLint>(), srcY1 = in.read<GLint>();
+				GLint dstX0 = in.read<GLint>(), dstY0 = in.read<GLint>(), dstX1 = in.read<GLint>(), dstY1 = in.read<GLint>();
+				GLbitfield mask = in.read<GLbitfield>();
+				GLenum filter = in.read<GLenum>();
+				glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+				break;
+			}
+			case DRAW_BUFFERS:
+			{
+				GLsizei n = in.read<GLsizei>();
+				glDrawBuffers(n, static_cast<const GLenum*>(in.readData()));
+				break;
+			}
+			case VIEWPORT:
+			{
+				GLint x = in.read<GLint>(), y = in.read<GLint>();
+				GLsizei width = in.read<GLsizei>(), height = in.read<GLsizei>();
+				redundant = skipRedundant && StateCache::same(cache.viewport, 0, std::make_tuple(x, y, width, height));
+				if (!redundant) glViewport(x, y, width, height);
+				break;
+			}
+			case CLEAR:
+				glClear(in.read<GLbitfield>());
+				break;
+			case CLEAR_COLOR:
+			{
+				GLfloat red = in.read<GLfloat>(), green = in.read<GLfloat>(), blue = in.read<GLfloat>(), alpha = in.read<GLfloat>();
+				redundant = skipRedundant && StateCache::same(cache.clearColor, 0, std::make_tuple(red, green, blue, alpha));
+				if (!redundant) glClearColor(red, green, blue, alpha);
+				break;
+			}
+			case ENABLE:
+			case DISABLE:
+			{
+				GLenum cap = in.read<GLenum>();
+				redundant = skipRedundant && StateCache::same(cache.capabilities, cap, command == ENABLE);
+				if (!redundant)
+				{
+					if (command == ENABLE) glEnable(cap);
+					else glDisable(cap);
+				}
+				break;
+			}
+			case DEPTH_FUNC:
+			{
+				GLenum func = in.read<GLenum>();
+				redundant = skipRedundant && StateCache::same(cache.depthFunc, 0, func);
+				if (!redundant) glDepthFunc(func);
+				break;
+			}
+			case DEPTH_MASK:
+			{
+				GLboolean flag = in.read<GLboolean>();
+				redundant = skipRedundant && StateCache::same(cache.depthMask, 0, flag);
+				if (!redundant) glDepthMask(flag);
+				break;
+			}
+			case COLOR_MASK:
+			{
+				GLboolean red = in.read<GLboolean>(), green = in.read<GLboolean>(), blue = in.read<GLboolean>(), alpha = in.read<GLboolean>();
+				redundant = skipRedundant && StateCache::same(cache.colorMask, 0, std::make_tuple(red, green, blue, alpha));
+				if (!redundant) glColorMask(red, green, blue, alpha);
+				break;
+			}
+			case CULL_FACE:
+			{
+				GLenum mode = in.read<GLenum>();
+				redundant = skipRedundant && StateCache::same(cache.cullFace, 0, mode);
+				if (!redundant) glCullFace(mode);
+				break;
+			}
+			case POLYGON_MODE:
+			{
+				GLenum face = in.read<GLenum>(), mode = in.read<GLenum>();
+				redundant = skipRedundant && StateCache::same(cache.polygonMode, face, mode);
+				if (!redundant) glPolygonMode(face, mode);
+				break;
+			}
+			case DRAW_ARRAYS:
+			{
+				GLenum mode = in.read<GLenum>();
+				GLint first = in.read<GLint>();
+				GLsizei count = in.read<GLsizei>();
+				glDrawArrays(mode, first, count);
+				break;
+			}
+			case DRAW_ELEMENTS:
+			{
+				GLenum mode = in.read<GLenum>();
+				GLsizei count = in.read<GLsizei>();
+				GLenum type = in.read<GLenum>();
+				uint64_t offset = in.read<uint64_t>();
+				glDrawElements(mode, count, type, reinterpret_cast<const void*>(uintptr_t(offset)));
+				break;
+			}
+			case MULTI_DRAW_ELEMENTS_INDIRECT:
+			{
+				GLenum mode = in.read<GLenum>(), type = in.read<GLenum>();
+				uint64_t offset = in.read<uint64_t>();
+				GLsizei drawcount = in.read<GLsizei>(), stride = in.read<GLsizei>();
+				glMultiDrawElementsIndirect(mode, type, reinterpret_cast<const void*>(uintptr_t(offset)), drawcount, stride);
+				break;
+			}
+			default:
+				std::cout << "Unknown command " << int(command) << " in GL trace, replay stopped" << std::endl;
+				glUseProgram(GLuint(currentProgram));
+				return result;
+			}
+			if (redundant) ++skipped;
+			else ++issued;
+		}
+		submitTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+	}
+	glFinish();
+	std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - start;
+	glUseProgram(GLuint(currentProgram));
+
+	result.frames = frames;
+	result.commands = issued / frames;
+	result.skipped = skipped / frames;
+	result.submitTime = submitTime / frames;
+	result.frameTime = total.count() / frames;
+	return result;
+}
+
+std::string GLTrace::getReplayReport(unsigned int frames)
+{
+	std::ostringstream out;
+	out << "GL trace: " << commandCount << " commands, " << stream.size() << " bytes, replayed " << frames << " times" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (bool skipRedundant : { false, true })
+	{
+		ReplayResult result = replay(frames, skipRedundant);
+		out << (skipRedundant ? "  without redundant: " : "  as recorded:       ") << result.commands << " commands, "
+			<< result.submitTime << "ms submit, " << result.frameTime << "ms per frame";
+		if (skipRedundant) out << ", " << result.skipped << " skipped";
+		out << std::endl;
+	}
+	return out.str();
+}
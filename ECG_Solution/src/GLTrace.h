@@ -0,0 +1,310 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+/*
+ Records the GL commands of a frame into a compact binary stream and replays them without the
+ application, so the driver's cost of a frame can be measured apart from ours.
+ Files that submit frame work include this header last, it replaces the GL entry points they use
+ with wrappers that append the command and its arguments to the stream while recording, including
+ the data of buffer uploads and uniforms, and then call GL. Not recording costs one branch per call.
+ The stream refers to GL objects by name, so it replays against the objects of the process that
+ recorded it, or of a run that created the same objects like the headless renderer with the same scene.
+ Client side index arrays and mapped buffers aren't recorded, offsets into bound buffers are.
+*/
+class GLTrace
+{
+public:
+	enum Command : uint8_t {
+		USE_PROGRAM,
+		PROGRAM_UNIFORM_1I,
+		PROGRAM_UNIFORM_1F,
+		PROGRAM_UNIFORM_3F,
+		PROGRAM_UNIFORM_MATRIX_3FV,
+		PROGRAM_UNIFORM_MATRIX_4FV,
+		BIND_VERTEX_ARRAY,
+		BIND_BUFFER,
+		BIND_BUFFER_BASE,
+		BUFFER_DATA,
+		ACTIVE_TEXTURE,
+		BIND_TEXTURE,
+		BIND_FRAMEBUFFER,
+		BLIT_FRAMEBUFFER,
+		DRAW_BUFFERS,
+		VIEWPORT,
+		CLEAR,
+		CLEAR_COLOR,
+		ENABLE,
+		DISABLE,
+		DEPTH_FUNC,
+		DEPTH_MASK,
+		COLOR_MASK,
+		CULL_FACE,
+		POLYGON_MODE,
+		DRAW_ARRAYS,
+		DRAW_ELEMENTS,
+		MULTI_DRAW_ELEMENTS_INDIRECT,
+		COMMAND_COUNT
+	};
+
+	struct ReplayResult {
+		unsigned int frames = 0;
+		//commands issued per frame, redundant ones that were skipped
+		size_t commands = 0;
+		size_t skipped = 0;
+		//CPU time to issue a frame, and per frame including glFinish after the last one
+		double submitTime = 0.0;
+		double frameTime = 0.0;
+	};
+private:
+	static bool recording;
+	static std::vector<unsigned char> stream;
+	static size_t commandCount;
+
+	template<typename T> static void put(const T& value)
+	{
+		size_t offset = stream.size();
+		stream.resize(offset + sizeof(T));
+		std::memcpy(stream.data() + offset, &value, sizeof(T));
+	}
+public:
+	static bool isRecording() { return recording; }
+	//clears the stream and records from now on
+	static void begin();
+	static void end();
+
+	static size_t getCommandCount();
+	static size_t getByteSize();
+	static const char* getName(Command command);
+
+	static bool save(const std::string& file);
+	static bool load(const std::string& file);
+
+	/*!
+	 * Issues the recorded commands frames times in a row
+	 * @param skipRedundant: leaves out binds and state changes that don't change the current value,
+	 * to compare the stream as submitted against the one a state cache would submit
+	 */
+	static ReplayResult replay(unsigned int frames, bool skipRedundant);
+	//replays as recorded and without redundant commands, one line each
+	static std::string getReplayReport(unsigned int frames);
+
+	//used by the wrappers
+	template<typename... Args> static void record(Command command, const Args&... args)
+	{
+		put(command);
+		int expand[] = { 0, (put(args), 0)... };
+		(void)expand;
+		++commandCount;
+	}
+	//size and contents, 4 byte aligned so arrays can be passed to GL from the stream
+	static void recordData(const void* data, size_t size);
+};
+
+#ifndef GL_TRACE_NO_WRAPPERS
+namespace GLTraced {
+	inline void UseProgram(GLuint program)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::USE_PROGRAM, program);
+		glUseProgram(program);
+	}
+	inline void ProgramUniform1i(GLuint program, GLint location, GLint v0)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::PROGRAM_UNIFORM_1I, program, location, v0);
+		glProgramUniform1i(program, location, v0);
+	}
+	inline void ProgramUniform1f(GLuint program, GLint location, GLfloat v0)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::PROGRAM_UNIFORM_1F, program, location, v0);
+		glProgramUniform1f(program, location, v0);
+	}
+	inline void ProgramUniform3f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::PROGRAM_UNIFORM_3F, program, location, v0, v1, v2);
+		glProgramUniform3f(program, location, v0, v1, v2);
+	}
+	inline void ProgramUniformMatrix3fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		if (GLTrace::isRecording())
+		{
+			GLTrace::record(GLTrace::PROGRAM_UNIFORM_MATRIX_3FV, program, location, count, transpose);
+			GLTrace::recordData(value, size_t(count) * 9 * sizeof(GLfloat));
+		}
+		glProgramUniformMatrix3fv(program, location, count, transpose, value);
+	}
+	inline void ProgramUniformMatrix4fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		if (GLTrace::isRecording())
+		{
+			GLTrace::record(GLTrace::PROGRAM_UNIFORM_MATRIX_4FV, program, location, count, transpose);
+			GLTrace::recordData(value, size_t(count) * 16 * sizeof(GLfloat));
+		}
+		glProgramUniformMatrix4fv(program, location, count, transpose, value);
+	}
+	inline void BindVertexArray(GLuint array)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BIND_VERTEX_ARRAY, array);
+		glBindVertexArray(array);
+	}
+	inline void BindBuffer(GLenum target, GLuint buffer)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BIND_BUFFER, target, buffer);
+		glBindBuffer(target, buffer);
+	}
+	inline void BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BIND_BUFFER_BASE, target, index, buffer);
+		glBindBufferBase(target, index, buffer);
+	}
+	inline void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (GLTrace::isRecording())
+		{
+			GLTrace::record(GLTrace::BUFFER_DATA, target, int64_t(size), usage, uint8_t(data != nullptr));
+			if (data != nullptr) GLTrace::recordData(data, size_t(size));
+		}
+		glBufferData(target, size, data, usage);
+	}
+	inline void ActiveTexture(GLenum texture)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::ACTIVE_TEXTURE, texture);
+		glActiveTexture(texture);
+	}
+	inline void BindTexture(GLenum target, GLuint texture)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BIND_TEXTURE, target, texture);
+		glBindTexture(target, texture);
+	}
+	inline void BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BIND_FRAMEBUFFER, target, framebuffer);
+		glBindFramebuffer(target, framebuffer);
+	}
+	inline void BlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::BLIT_FRAMEBUFFER, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+		glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+	}
+	inline void DrawBuffers(GLsizei n, const GLenum* bufs)
+	{
+		if (GLTrace::isRecording())
+		{
+			GLTrace::record(GLTrace::DRAW_BUFFERS, n);
+			GLTrace::recordData(bufs, size_t(n) * sizeof(GLenum));
+		}
+		glDrawBuffers(n, bufs);
+	}
+	inline void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::VIEWPORT, x, y, width, height);
+		glViewport(x, y, width, height);
+	}
+	inline void Clear(GLbitfield mask)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::CLEAR, mask);
+		glClear(mask);
+	}
+	inline void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::CLEAR_COLOR, red, green, blue, alpha);
+		glClearColor(red, green, blue, alpha);
+	}
+	inline void Enable(GLenum cap)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::ENABLE, cap);
+		glEnable(cap);
+	}
+	inline void Disable(GLenum cap)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::DISABLE, cap);
+		glDisable(cap);
+	}
+	inline void DepthFunc(GLenum func)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::DEPTH_FUNC, func);
+		glDepthFunc(func);
+	}
+	inline void DepthMask(GLboolean flag)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::DEPTH_MASK, flag);
+		glDepthMask(flag);
+	}
+	inline void ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::COLOR_MASK, red, green, blue, alpha);
+		glColorMask(red, green, blue, alpha);
+	}
+	inline void CullFace(GLenum mode)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::CULL_FACE, mode);
+		glCullFace(mode);
+	}
+	inline void PolygonMode(GLenum face, GLenum mode)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::POLYGON_MODE, face, mode);
+		glPolygonMode(face, mode);
+	}
+	inline void DrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::DRAW_ARRAYS, mode, first, count);
+		glDrawArrays(mode, first, count);
+	}
+	inline void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::DRAW_ELEMENTS, mode, count, type, uint64_t(uintptr_t(indices)));
+		glDrawElements(mode, count, type, indices);
+	}
+	inline void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride)
+	{
+		if (GLTrace::isRecording()) GLTrace::record(GLTrace::MULTI_DRAW_ELEMENTS_INDIRECT, mode, type, uint64_t(uintptr_t(indirect)), drawcount, stride);
+		glMultiDrawElementsIndirect(mode, type, indirect, drawcount, stride);
+	}
+}
+
+#undef glUseProgram
+#undef glProgramUniform1i
+#undef glProgramUniform1f
+#undef glProgramUniform3f
+#undef glProgramUniformMatrix3fv
+#undef glProgramUniformMatrix4fv
+#undef glBindVertexArray
+#undef glBindBuffer
+#undef glBindBufferBase
+#undef glBufferData
+#undef glActiveTexture
+#undef glBindFramebuffer
+#undef glBlitFramebuffer
+#undef glDrawBuffers
+#undef glMultiDrawElementsIndirect
+#define glUseProgram GLTraced::UseProgram
+#define glProgramUniform1i GLTraced::ProgramUniform1i
+#define glProgramUniform1f GLTraced::ProgramUniform1f
+#define glProgramUniform3f GLTraced::ProgramUniform3f
+#define glProgramUniformMatrix3fv GLTraced::ProgramUniformMatrix3fv
+#define glProgramUniformMatrix4fv GLTraced::ProgramUniformMatrix4fv
+#define glBindVertexArray GLTraced::BindVertexArray
+#define glBindBuffer GLTraced::BindBuffer
+#define glBindBufferBase GLTraced::BindBufferBase
+#define glBufferData GLTraced::BufferData
+#define glActiveTexture GLTraced::ActiveTexture
+#define glBindTexture GLTraced::BindTexture
+#define glBindFramebuffer GLTraced::BindFramebuffer
+#define glBlitFramebuffer GLTraced::BlitFramebuffer
+#define glDrawBuffers GLTraced::DrawBuffers
+#define glViewport GLTraced::Viewport
+#define glClear GLTraced::Clear
+#define glClearColor GLTraced::ClearColor
+#define glEnable GLTraced::Enable
+#define glDisable GLTraced::Disable
+#define glDepthFunc GLTraced::DepthFunc
+#define glDepthMask GLTraced::DepthMask
+#define glColorMask GLTraced::ColorMask
+#define glCullFace GLTraced::CullFace
+#define glPolygonMode GLTraced::PolygonMode
+#define glDrawArrays GLTraced::DrawArrays
+#define glDrawElements GLTraced::DrawElements
+#define glMultiDrawElementsIndirect GLTraced::MultiDrawElementsIndirect
+#endif
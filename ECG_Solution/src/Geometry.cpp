@@ -1,9 +1,38 @@
 #include "Geometry.h"
+#include "MeshFile.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "GLTrace.h"
 
 
 
-Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::shared_ptr<Material> material):modelMatrix(modelMatrix), material(material), nrOfVertices(geometryData.indices.size())
+Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::shared_ptr<Material> material) : modelMatrix(modelMatrix), material(material)
 {
+	geometryData.track();
+	//streams the generator left empty (the torus has no uvs) are allocated but not filled
+	size_t vertexCount = geometryData.positions.size();
+	createBuffers(geometryData.positions.data(), geometryData.normals.size() == vertexCount ? geometryData.normals.data() : nullptr,
+		geometryData.uv.size() == vertexCount ? geometryData.uv.data() : nullptr, vertexCount, geometryData.indices.data(), geometryData.indices.size());
+}
+
+Geometry::Geometry(glm::mat4 modelMatrix, const MeshFile::Mesh& mesh, std::shared_ptr<Material> material, unsigned int lod) : modelMatrix(modelMatrix), material(material)
+{
+	//the streams already have the buffer layout, uploaded straight from the mapping
+	const MeshFile::LOD& range = mesh.lods[std::min(lod, mesh.header.lodCount - 1)];
+	createBuffers(mesh.positions, mesh.normals, mesh.uv, mesh.header.vertexCount, mesh.indices + range.indexOffset, range.indexCount);
+}
+
+Geometry::Geometry(glm::mat4 modelMatrix, const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uv, size_t vertexCount,
+	const unsigned int* indices, size_t indexCount, std::shared_ptr<Material> material) : modelMatrix(modelMatrix), material(material)
+{
+	createBuffers(positions, normals, uv, vertexCount, indices, indexCount);
+}
+
+void Geometry::createBuffers(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uv, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	nrOfVertices = int(indexCount);
+	normalMatrix = glm::mat3(glm::inverse(glm::transpose(modelMatrix)));
+
 	//Create Vertex Array Object
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
@@ -11,7 +40,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::share
 	//create vertex position array
 	glGenBuffers(1, &vboPositions);
 	glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
-	glBufferData(GL_ARRAY_BUFFER, geometryData.positions.size() * sizeof(glm::vec3), geometryData.positions.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), positions, GL_STATIC_DRAW);
 	//Bind vertex positions to location 0
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
@@ -19,7 +48,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::share
 	//create normals array buffer
 	glGenBuffers(1, &vboNormals);
 	glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
-	glBufferData(GL_ARRAY_BUFFER, geometryData.normals.size() * sizeof(glm::vec3), geometryData.normals.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), normals, GL_STATIC_DRAW);
 	//Bind vertex normals to location 1
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
@@ -27,7 +56,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::share
 	//create uv array buffer
 	glGenBuffers(1, &vboUV);
 	glBindBuffer(GL_ARRAY_BUFFER, vboUV);
-	glBufferData(GL_ARRAY_BUFFER, geometryData.uv.size() * sizeof(glm::vec2), geometryData.uv.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec2), uv, GL_STATIC_DRAW);
 	//Bind vertex uv to location 2
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
@@ -36,15 +65,46 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::share
 	//create Index Array
 	glGenBuffers(1, &vboIndices);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometryData.indices.size() * sizeof(unsigned int), geometryData.indices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboPositions, vertexCount * sizeof(glm::vec3), "Geometry positions");
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboNormals, vertexCount * sizeof(glm::vec3), "Geometry normals");
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboUV, vertexCount * sizeof(glm::vec2), "Geometry uvs");
+	MemoryTracker::allocate(MemoryTracker::INDEX_BUFFERS, vboIndices, indexCount * sizeof(unsigned int), "Geometry indices");
+
+	//Create position only Vertex Array Object, shares the position and index buffers
+	glGenVertexArrays(1, &vaoDepth);
+	glBindVertexArray(vaoDepth);
+	glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
 
 	//Reset all bindings to 0
 	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	//set color
 	color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
+	//sphere around the bounding box center
+	glm::vec3 minimum(0.0f), maximum(0.0f);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		minimum = i == 0 ? positions[i] : glm::min(minimum, positions[i]);
+		maximum = i == 0 ? positions[i] : glm::max(maximum, positions[i]);
+	}
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radius = 0.0f;
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		radius = std::max(radius, glm::length(positions[i] - center));
+	}
+	bounds = glm::vec4(center, radius);
+	//materials without a shader, e.g. for geometry that is only uploaded, sort first
+	GLuint program = material->getShader() ? material->getShader()->getHandle() : 0;
+	stateKey = (uint32_t(program) << 16) | (uint32_t(uintptr_t(material.get()) >> 4) & 0xFFFF);
+
 	isEmpty = false;
 }
 
@@ -59,7 +119,12 @@ Geometry::~Geometry()
 		glDeleteBuffers(1, &vboPositions);
 		glDeleteBuffers(1, &vboNormals);
 		glDeleteBuffers(1, &vboUV);
+		MemoryTracker::release(MemoryTracker::INDEX_BUFFERS, vboIndices);
+		MemoryTracker::release(MemoryTracker::VERTEX_BUFFERS, vboPositions);
+		MemoryTracker::release(MemoryTracker::VERTEX_BUFFERS, vboNormals);
+		MemoryTracker::release(MemoryTracker::VERTEX_BUFFERS, vboUV);
 		glDeleteVertexArrays(1, &vao);
+		glDeleteVertexArrays(1, &vaoDepth);
 		std::cout << "Buffers deleted" << std::endl;
 	}
 }
@@ -70,24 +135,97 @@ void Geometry::setColor(glm::vec3 color)
 }
 
 
+void Geometry::setNode(const SceneGraph* sceneGraph, SceneGraph::Node node)
+{
+	this->sceneGraph = sceneGraph;
+	this->node = node;
+}
+
+/*
+ Model and normal matrix, the cached ones unless an extra matrix is combined in
+*/
+void Geometry::getMatrices(const glm::mat4& matrix, glm::mat4& totalMatrix, glm::mat3& totalNormalMatrix) const
+{
+	const glm::mat4& worldMatrix = sceneGraph ? sceneGraph->getWorldMatrix(node) : modelMatrix;
+	if (matrix == glm::mat4(1.0f))
+	{
+		totalMatrix = worldMatrix;
+		totalNormalMatrix = sceneGraph ? sceneGraph->getNormalMatrix(node) : normalMatrix;
+		return;
+	}
+	totalMatrix = matrix * worldMatrix;
+	totalNormalMatrix = glm::mat3(glm::inverse(glm::transpose(totalMatrix)));
+}
+
+void Geometry::submit(GLuint vertexArray)
+{
+	glBindVertexArray(vertexArray);
+	glDrawElements(GL_TRIANGLES, nrOfVertices, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+	RenderStatistics::add(RenderStatistics::VERTEX_ARRAY_BINDS);
+	RenderStatistics::add(RenderStatistics::DRAW_CALLS);
+	RenderStatistics::add(RenderStatistics::TRIANGLES, nrOfVertices / 3);
+	RenderStatistics::add(RenderStatistics::VERTICES, nrOfVertices);
+}
+
 void Geometry::draw(glm::mat4 matrix)
 {
-	//Combined Matrices, would allow hierarchical animation later
-	glm::mat4 totalMatrix = matrix * modelMatrix;
+	glm::mat4 totalMatrix;
+	glm::mat3 totalNormalMatrix;
+	getMatrices(matrix, totalMatrix, totalNormalMatrix);
 	std::shared_ptr<Shader> shader = material->getShader();
 	//set Model Uniforms
 	material->setUniforms(0);
 	shader->use();
 	shader->setUniform("modelMatrix", totalMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::inverse(glm::transpose(totalMatrix))));
+	shader->setUniform("normalMatrix", totalNormalMatrix);
 	shader->setUniform("materialColor", color);
 	//Bind Buffers
-	glBindVertexArray(vao);
-	glDrawElements(GL_TRIANGLES, nrOfVertices, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	submit(vao);
 
 }
 
+/*
+ Draws only the positions with the given depth shader (viewProjectionMatrix has to be set already)
+*/
+void Geometry::drawDepth(std::shared_ptr<Shader>& depthShader, glm::mat4 matrix)
+{
+	glm::mat4 totalMatrix = matrix * (sceneGraph ? sceneGraph->getWorldMatrix(node) : modelMatrix);
+	depthShader->use();
+	depthShader->setUniform("modelMatrix", totalMatrix);
+	submit(vaoDepth);
+}
+
+glm::vec4 Geometry::getBoundingSphere() const
+{
+	const glm::mat4& worldMatrix = sceneGraph ? sceneGraph->getWorldMatrix(node) : modelMatrix;
+	glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(glm::vec3(bounds), 1.0f));
+	float scale = std::max(glm::length(glm::vec3(worldMatrix[0])), std::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+	return glm::vec4(center, bounds.w * scale);
+}
+
+uint32_t Geometry::getStateKey() const
+{
+	return stateKey;
+}
+
+/*
+ Draws into the G-buffer (viewProjectionMatrix has to be set already).
+ Returns false without drawing if the material does not support deferred shading.
+*/
+bool Geometry::drawGBuffer(std::shared_ptr<Shader>& gBufferShader, glm::mat4 matrix)
+{
+	if (!material->setGBufferUniforms(gBufferShader)) return false;
+	glm::mat4 totalMatrix;
+	glm::mat3 totalNormalMatrix;
+	getMatrices(matrix, totalMatrix, totalNormalMatrix);
+	gBufferShader->use();
+	gBufferShader->setUniform("modelMatrix", totalMatrix);
+	gBufferShader->setUniform("normalMatrix", totalNormalMatrix);
+	submit(vao);
+	return true;
+}
+
 GeometryData Geometry::createCubeGeometry(float width, float height, float depth)
 {
 	GeometryData data;
@@ -235,6 +373,7 @@ GeometryData Geometry::createCubeGeometry(float width, float height, float depth
 		22,20,23
 	};
 
+	data.track();
 	return data;
 }
 
@@ -295,6 +434,7 @@ GeometryData Geometry::createSphereGeometry(float radius, unsigned int longitude
 		}
 	}
 
+	data.track();
 	return data;
 }
 
@@ -359,6 +499,7 @@ GeometryData Geometry::createCylinderGeometry(float radius, float height, unsign
 		data.indices.push_back(5 + 4 * (i + 1));
 		data.indices.push_back(5 + 4 * i);
 	}
+	data.track();
 	return data;
 }
 
@@ -400,5 +541,6 @@ GeometryData Geometry::createTorusGeometry(float bigRadius, float smallRadius, u
 			data.indices.push_back(tubeIndex == tubeSections-1? circleIndex :  circleIndex + (tubeIndex+1) * circleSections);
 		}
 	}
+	data.track();
 	return data;
 }
@@ -3,15 +3,25 @@
 #include <memory>
 
 #include <glm/glm.hpp>
-#include <Gl/glew.h>
+#include <GL/glew.h>
 #include <glm/gtc/constants.hpp>
 
 #include "Shader.h"
 #include "Material.h"
+#include "SceneGraph.h"
+#include "MemoryTracker.h"
 
 
 using namespace std;
 
+namespace MeshFile {
+	struct Mesh;
+}
+
+/*
+ Accounted with the MemoryTracker by address, track() registers the current size,
+ loaders and generators call it once the vectors are filled.
+*/
 struct GeometryData {
 	//Vertex data
 	vector<glm::vec3> positions;
@@ -19,14 +29,58 @@ struct GeometryData {
 	vector<glm::vec2> uv;
 	//Indices
 	vector<unsigned int> indices;
+
+	GeometryData() {}
+	GeometryData(const GeometryData& other) : positions(other.positions), normals(other.normals), uv(other.uv), indices(other.indices) { track(); }
+	GeometryData(GeometryData&& other) noexcept : positions(std::move(other.positions)), normals(std::move(other.normals)), uv(std::move(other.uv)), indices(std::move(other.indices))
+	{
+		other.track();
+		track();
+	}
+	GeometryData& operator=(const GeometryData& other);
+	GeometryData& operator=(GeometryData&& other) noexcept;
+	~GeometryData() { MemoryTracker::release(MemoryTracker::GEOMETRY_DATA, uintptr_t(this)); }
+
+	size_t getByteSize() const
+	{
+		return positions.capacity() * sizeof(glm::vec3) + normals.capacity() * sizeof(glm::vec3) + uv.capacity() * sizeof(glm::vec2) + indices.capacity() * sizeof(unsigned int);
+	}
+	void track() const
+	{
+		if (getByteSize() > 0) MemoryTracker::allocate(MemoryTracker::GEOMETRY_DATA, uintptr_t(this), getByteSize());
+		else MemoryTracker::release(MemoryTracker::GEOMETRY_DATA, uintptr_t(this));
+	}
 };
 
+inline GeometryData& GeometryData::operator=(const GeometryData& other)
+{
+	positions = other.positions;
+	normals = other.normals;
+	uv = other.uv;
+	indices = other.indices;
+	track();
+	return *this;
+}
+
+inline GeometryData& GeometryData::operator=(GeometryData&& other) noexcept
+{
+	positions = std::move(other.positions);
+	normals = std::move(other.normals);
+	uv = std::move(other.uv);
+	indices = std::move(other.indices);
+	other.track();
+	track();
+	return *this;
+}
+
 class Geometry
 {
 private:
 	bool isEmpty = true;
 	//Buffers
 	GLuint vao;
+	//Position only stream for depth passes
+	GLuint vaoDepth;
 
 	GLuint vboPositions;
 	GLuint vboNormals;
@@ -36,22 +90,47 @@ private:
 	//nrOfVertices
 	int nrOfVertices;
 
-	//Matrices
+	//Matrices, the normal matrix is cached since the model matrix only changes through a scene graph
 	glm::mat4 modelMatrix;
+	glm::mat3 normalMatrix;
+	const SceneGraph* sceneGraph = nullptr;
+	SceneGraph::Node node = SceneGraph::none;
 
 	//Shader and Material stuff like color
 	std::shared_ptr<Material> material;
 	glm::vec3 color;
+	//bounding sphere in model space, center and radius
+	glm::vec4 bounds;
+	//program in the upper, material in the lower 16 bits
+	uint32_t stateKey;
+
+	void getMatrices(const glm::mat4& matrix, glm::mat4& totalMatrix, glm::mat3& totalNormalMatrix) const;
+	//draws all triangles of a vertex array and counts them
+	void submit(GLuint vertexArray);
+	void createBuffers(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uv, size_t vertexCount, const unsigned int* indices, size_t indexCount);
 
 public:
 	Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::shared_ptr<Material> material);
 	Geometry(glm::mat4 modelMatrix, GeometryData& geometryData, std::shared_ptr<Shader> shader);
+	//uploads one level of detail of a mapped '.mesh' file without converting it
+	Geometry(glm::mat4 modelMatrix, const MeshFile::Mesh& mesh, std::shared_ptr<Material> material, unsigned int lod = 0);
+	//uploads vertex streams in the buffer layout, e.g. from a mapped scene snapshot
+	Geometry(glm::mat4 modelMatrix, const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uv, size_t vertexCount,
+		const unsigned int* indices, size_t indexCount, std::shared_ptr<Material> material);
 
 	~Geometry();
 
 	void setColor(glm::vec3 color);
+	//takes the model matrix from a scene graph node, the graph has to outlive the geometry
+	void setNode(const SceneGraph* sceneGraph, SceneGraph::Node node);
 
 	void draw(glm::mat4 matrix = glm::mat4(1.0f));
+	void drawDepth(std::shared_ptr<Shader>& depthShader, glm::mat4 matrix = glm::mat4(1.0f));
+	//world space bounding sphere (center, radius), reads the scene graph so call it after its update
+	glm::vec4 getBoundingSphere() const;
+	//equal for geometries that draw with the same program and material
+	uint32_t getStateKey() const;
+	bool drawGBuffer(std::shared_ptr<Shader>& gBufferShader, glm::mat4 matrix = glm::mat4(1.0f));
 
 	//Construction helper
 	static GeometryData createCubeGeometry(float width, float height, float depth);
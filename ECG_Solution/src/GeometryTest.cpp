@@ -0,0 +1,64 @@
+/*
+ Checks of Geometry that need a GL context, run by CTest on a headless context.
+ Returns 1 if a check fails.
+*/
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "HeadlessContext.h"
+#include "Geometry.h"
+#include "Material.h"
+#include "Shader.h"
+#include "JobSystem.h"
+#include "DrawList.h"
+#include "MemoryTracker.h"
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			std::cout << "FAILED: " << description << std::endl;
+			++failures;
+		}
+	}
+
+	//geometry that is only uploaded, like the mesh load benchmark does it, has a material without a shader
+	void shaderlessMaterial()
+	{
+		std::shared_ptr<Material> material = std::make_shared<Material>(std::shared_ptr<Shader>());
+		GeometryData sphereData = Geometry::createSphereGeometry(1.0f, 16, 8);
+		Geometry geometry(glm::mat4(1.0f), sphereData, material);
+		check(geometry.getStateKey() >> 16 == 0, "a shaderless material has program 0 in its state key");
+		check(geometry.getBoundingSphere().w > 0.0f, "a shaderless geometry has bounds");
+
+		//sorts before geometry with a program, the camera at z = 5 looks at both
+		std::shared_ptr<Shader> shader = std::make_shared<Shader>("depthOnly.vert", "depthOnly.frag");
+		Geometry shaded(glm::mat4(1.0f), sphereData, std::make_shared<Material>(shader));
+		glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f) * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+		JobSystem jobs(1);
+		DrawList drawList;
+		drawList.build({ &shaded, &geometry }, viewProjection, glm::vec3(0.0f, 0.0f, 5.0f), jobs);
+		check(drawList.getVisible().size() == 2 && drawList.getVisible()[0] == &geometry, "shaderless geometry is drawn first");
+	}
+}
+
+int main()
+{
+	HeadlessContext context(4, 3);
+	if (!context.isValid())
+	{
+		std::cout << "Couldn't create a headless OpenGL 4.3 context" << std::endl;
+		return 1;
+	}
+
+	shaderlessMaterial();
+
+	check(MemoryTracker::reportLeaks() == 0, "every GL object was released");
+	std::cout << (failures == 0 ? "All checks passed" : "Some checks failed") << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+/*
+ Renders frames of a scene without a window and checks them against golden images.
+
+	ECG_Headless [--scene file] [--frames n] [--size widthxheight] [--output directory]
+	             [--golden directory] [--update-golden] [--flythrough [waypoint file]]
+	             [--record-trace [file]] [--replay-trace file] [--deferred] [--texture-batching]
+
+ Frames are rendered into a framebuffer object, read back through pixel buffer objects and written as
+ frame_<n>.png. The scene is animated with a fixed timestep and the camera is fixed or follows the
+ waypoints, so every run renders the same frames. Returns 1 if a frame differs from its golden image.
+ --record-trace records the GL commands of the last frame and replays them after the run, --replay-trace
+ replays a trace recorded by an earlier run of the same scene instead. --deferred and --texture-batching
+ render like [renderer] mode = deferred and texture_batching = true, the settings don't change the headless output.
+*/
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "Utils.h"
+#include "HeadlessContext.h"
+#include "FrameReadback.h"
+#include "PNGFile.h"
+#include "Shader.h"
+#include "Camera.h"
+#include "LightManager.h"
+#include "ImageBasedLighting.h"
+#include "Scene.h"
+#include "FlyThrough.h"
+#include "FrameTimes.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "JobSystem.h"
+#include "DrawList.h"
+#include "DeferredRenderer.h"
+#include "TexturedBatch.h"
+#include "GLTrace.h"
+
+namespace {
+	struct ImageDifference {
+		//largest difference of a color channel
+		int maximum = 0;
+		//pixels with a channel differing by more than the tolerance
+		size_t pixels = 0;
+	};
+
+	ImageDifference compareImages(const Image& a, const Image& b, int tolerance)
+	{
+		ImageDifference difference;
+		for (size_t pixel = 0; pixel < a.pixels.size() / 4; ++pixel)
+		{
+			int largest = 0;
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				largest = std::max(largest, std::abs(int(a.pixels[pixel * 4 + channel]) - int(b.pixels[pixel * 4 + channel])));
+			}
+			difference.maximum = std::max(difference.maximum, largest);
+			if (largest > tolerance) ++difference.pixels;
+		}
+		return difference;
+	}
+
+	void createDirectory(const std::string& directory)
+	{
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+
+	std::string frameName(unsigned long frame)
+	{
+		std::ostringstream name;
+		name << "frame_" << std::setw(3) << std::setfill('0') << frame << ".png";
+		return name.str();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	/* --------------------------------------------- */
+	// Load settings.ini, arguments override them
+	/* --------------------------------------------- */
+
+	INIReader reader("assets/settings.ini");
+
+	std::string sceneFile = reader.Get("scene", "file", "./assets/scene.ini");
+	bool sceneSnapshot = reader.GetBoolean("scene", "snapshot", true);
+	int width = reader.GetInteger("headless", "width", 256);
+	int height = reader.GetInteger("headless", "height", 256);
+	int frames = reader.GetInteger("headless", "frames", 4);
+	double timestep = reader.GetReal("headless", "timestep", 0.25);
+	std::string outputDirectory = reader.Get("headless", "output", "./headless");
+	std::string goldenDirectory = reader.Get("headless", "golden", "./assets/golden");
+	int tolerance = reader.GetInteger("headless", "tolerance", 8);
+	double maxDiffering = reader.GetReal("headless", "max_differing", 0.001);
+	float fov = float(reader.GetReal("camera", "fov", 60.0f));
+	float nearZ = float(reader.GetReal("camera", "near", 0.1f));
+	float farZ = float(reader.GetReal("camera", "far", 100.0f));
+	bool updateGolden = false;
+	bool frustumCulling = reader.GetBoolean("renderer", "frustum_culling", true);
+	unsigned int jobThreads = (unsigned int)std::max(0, int(reader.GetInteger("jobs", "threads", 0)));
+	bool deferred = false;
+	bool textureBatching = false;
+	bool recordTrace = false;
+	std::string traceFile;
+	unsigned int replayFrames = (unsigned int)std::max(1, int(reader.GetInteger("gl_trace", "replay_frames", 200)));
+	std::string waypoints = reader.Get("headless", "waypoints", "");
+	if (waypoints.empty()) waypoints = reader.Get("flythrough", "file", "./assets/lights.txt");
+	std::string waypointFile = reader.GetBoolean("headless", "flythrough", true) ? waypoints : "";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0;
+		if (argument == "--scene" && hasValue) sceneFile = argv[++i];
+		else if (argument == "--frames" && hasValue) frames = std::atoi(argv[++i]);
+		else if (argument == "--size" && hasValue) std::sscanf(argv[++i], "%dx%d", &width, &height);
+		else if (argument == "--output" && hasValue) outputDirectory = argv[++i];
+		else if (argument == "--golden" && hasValue) goldenDirectory = argv[++i];
+		else if (argument == "--update-golden") updateGolden = true;
+		else if (argument == "--flythrough") waypointFile = hasValue ? argv[++i] : waypoints;
+		else if (argument == "--record-trace")
+		{
+			recordTrace = true;
+			traceFile = hasValue ? argv[++i] : reader.Get("gl_trace", "file", "");
+		}
+		else if (argument == "--replay-trace" && hasValue) traceFile = argv[++i];
+		else if (argument == "--deferred") deferred = true;
+		else if (argument == "--texture-batching") textureBatching = true;
+		else
+		{
+			EXIT_WITH_ERROR("Unknown argument " << argument)
+		}
+	}
+	if (frames < 1 || width < 1 || height < 1)
+	{
+		EXIT_WITH_ERROR("Nothing to render")
+	}
+
+	/* --------------------------------------------- */
+	// Create context and render target
+	/* --------------------------------------------- */
+
+	HeadlessContext context(4, 3);
+	if (!context.isValid())
+	{
+		EXIT_WITH_ERROR("Failed to create a headless OpenGL context")
+	}
+	std::cout << "Rendering " << frames << " frames of " << sceneFile << " at " << width << "x" << height << " on " << context.getRenderer() << std::endl;
+
+	//sRGB color like the window's framebuffer, read back as encoded 8 bit values
+	GLuint framebuffer, colorBuffer, depthBuffer;
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_SRGB8_ALPHA8, width, height);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	//renderbuffer names can be the same as texture names, keyed by address instead
+	MemoryTracker::allocate(MemoryTracker::FRAMEBUFFERS, uintptr_t(&colorBuffer), MemoryTracker::getTextureSize(GL_SRGB8_ALPHA8, width, height, 1), "Offscreen color");
+	MemoryTracker::allocate(MemoryTracker::FRAMEBUFFERS, uintptr_t(&depthBuffer), MemoryTracker::getTextureSize(GL_DEPTH24_STENCIL8, width, height, 1), "Offscreen depth");
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		EXIT_WITH_ERROR("Failed to create the offscreen framebuffer")
+	}
+	glViewport(0, 0, width, height);
+
+	//the same defaults as the window
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+	glEnable(GL_DEPTH_TEST);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	glEnable(GL_FRAMEBUFFER_SRGB);
+
+	/* --------------------------------------------- */
+	// Initialize scene and render loop
+	/* --------------------------------------------- */
+
+	int result = EXIT_SUCCESS;
+	{
+		std::vector<std::shared_ptr<Shader>> shaders;
+		std::shared_ptr<Shader> simpleTexture = std::make_shared<Shader>("diffuseTexture.vert", "diffuseTexture.frag");
+		shaders.emplace_back(simpleTexture);
+		std::shared_ptr<Shader> phongPBR = std::make_shared<Shader>("PBR_shader_phong.vert", "PBR_shader_phong.frag");
+		shaders.emplace_back(phongPBR);
+
+		//textures are loaded right away, nothing is streamed in later frames
+		Scene scene(sceneFile, sceneSnapshot, simpleTexture, phongPBR, [](const std::string& path) {
+			return std::make_shared<Texture>(path);
+		});
+		if (!scene.isLoaded())
+		{
+			EXIT_WITH_ERROR("Failed to load scene")
+		}
+		LightManager lightManager;
+		scene.createLights(lightManager);
+		std::vector<Geometry*> geometries = scene.getGeometries();
+		JobSystem jobs(jobThreads);
+		DrawList drawList;
+
+		std::unique_ptr<TexturedBatch> texturedBatch;
+		if (textureBatching)
+		{
+			texturedBatch = std::make_unique<TexturedBatch>(std::make_shared<Shader>("diffuseTexture.vert", "diffuseTexture.frag", std::vector<std::string>{ "BATCHED" }));
+			std::vector<Geometry*> unbatched;
+			if (!scene.addToBatch(*texturedBatch, unbatched))
+			{
+				EXIT_WITH_ERROR("Failed to batch the textured objects")
+			}
+			texturedBatch->upload();
+			shaders.emplace_back(texturedBatch->getShader());
+			geometries = unbatched;
+		}
+		std::unique_ptr<DeferredRenderer> deferredRenderer;
+		if (deferred)
+		{
+			deferredRenderer = std::make_unique<DeferredRenderer>(width, height);
+		}
+
+		ImageBasedLighting imageBasedLighting("./assets/textures/cubemap", reader.GetBoolean("ibl", "recompute", false));
+		imageBasedLighting.setUniforms(shaders);
+		if (deferredRenderer)
+		{
+			imageBasedLighting.setUniforms(deferredRenderer->getLightingShaders());
+		}
+		imageBasedLighting.bind();
+
+		Camera camera(fov, float(width) / float(height), nearZ, farZ);
+		camera.update(0, 0, 8.0f, false, false);
+		std::unique_ptr<FlyThrough> flyThrough;
+		if (!waypointFile.empty())
+		{
+			flyThrough = std::make_unique<FlyThrough>(waypointFile);
+			if (!flyThrough->isLoaded())
+			{
+				EXIT_WITH_ERROR("Failed to load waypoints")
+			}
+		}
+
+		createDirectory(outputDirectory);
+		if (updateGolden)
+		{
+			createDirectory(goldenDirectory);
+		}
+		int mismatches = 0;
+		FrameReadback readback(width, height, [&](unsigned long frame, const Image& image) {
+			std::string name = frameName(frame);
+			savePNG(outputDirectory + "/" + name, image);
+			if (goldenDirectory.empty()) return;
+			if (updateGolden)
+			{
+				savePNG(goldenDirectory + "/" + name, image);
+				return;
+			}
+			Image golden;
+			if (!loadPNG(goldenDirectory + "/" + name, golden))
+			{
+				std::cout << "  " << name << ": no golden image in " << goldenDirectory << std::endl;
+				++mismatches;
+				return;
+			}
+			if (golden.width != image.width || golden.height != image.height)
+			{
+				std::cout << "  " << name << ": golden image is " << golden.width << "x" << golden.height << std::endl;
+				++mismatches;
+				return;
+			}
+			ImageDifference difference = compareImages(image, golden, tolerance);
+			bool matches = double(difference.pixels) <= maxDiffering * double(size_t(width) * height);
+			std::cout << "  " << name << ": " << (matches ? "matches" : "DIFFERS") << ", " << difference.pixels << " pixels differ by more than "
+				<< tolerance << ", largest difference " << difference.maximum << std::endl;
+			if (!matches) ++mismatches;
+		});
+
+		FrameTimes frameTimes;
+		RenderStatistics::reset();
+		auto start = std::chrono::high_resolution_clock::now();
+		auto frameStart = start;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			if (recordTrace && frame == frames - 1)
+			{
+				GLTrace::begin();
+			}
+			Shader::beginFrame();
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			if (flyThrough)
+			{
+				//the frames are spread evenly over the whole path
+				float position = frames > 1 ? float(frame) / float(frames - 1) * float(flyThrough->getSegmentCount()) : 0.0f;
+				size_t segment = std::min(size_t(position), flyThrough->getSegmentCount() - 1);
+				FlyThrough::Pose pose = flyThrough->getPose(segment, position - float(segment));
+				camera.setPose(pose.position, pose.direction);
+			}
+			scene.update(frame * timestep, &jobs);
+
+			lightManager.setUniforms(shaders);
+			for (std::shared_ptr<Shader> shader : shaders)
+			{
+				shader->use();
+				shader->setUniform("viewProjectionMatrix", camera.getViewProjectionMatrix());
+				shader->setUniform("cameraPosition", camera.getPosition());
+			}
+			drawList.build(geometries, camera.getViewProjectionMatrix(), camera.getPosition(), jobs, frustumCulling);
+			if (deferredRenderer)
+			{
+				deferredRenderer->render(drawList.getVisible(), lightManager, camera, framebuffer);
+			}
+			else
+			{
+				for (Geometry* geometry : drawList.getVisible())
+				{
+					geometry->draw();
+				}
+			}
+			if (texturedBatch)
+			{
+				if (frustumCulling) texturedBatch->cull(camera.getViewProjectionMatrix());
+				texturedBatch->draw();
+			}
+			GLTrace::end();
+
+			RenderStatistics::endFrame();
+			readback.read(frame);
+			readback.poll();
+			auto frameEnd = std::chrono::high_resolution_clock::now();
+			frameTimes.add(std::chrono::duration<double>(frameEnd - frameStart).count());
+			frameStart = frameEnd;
+		}
+		readback.poll(true);
+		std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - start;
+
+		/* --------------------------------------------- */
+		// Statistics
+		/* --------------------------------------------- */
+
+		std::cout << "Rendered " << frames << " frames in " << total.count() << "ms." << std::endl;
+		std::cout << frameTimes.getReport();
+		std::cout << "Per frame: " << RenderStatistics::format(RenderStatistics::getTotalCounters(), std::max(1.0, double(frames))) << "." << std::endl;
+		std::cout << MemoryTracker::getReport();
+		if (recordTrace && !traceFile.empty() && !GLTrace::save(traceFile))
+		{
+			std::cout << "Failed to write GL trace " << traceFile << std::endl;
+			result = EXIT_FAILURE;
+		}
+		if (!recordTrace && !traceFile.empty() && !GLTrace::load(traceFile))
+		{
+			result = EXIT_FAILURE;
+		}
+		else if (recordTrace || !traceFile.empty())
+		{
+			std::cout << GLTrace::getReplayReport(replayFrames);
+		}
+		if (updateGolden)
+		{
+			std::cout << "Golden images written to " << goldenDirectory << std::endl;
+		}
+		else if (!goldenDirectory.empty())
+		{
+			std::cout << (mismatches == 0 ? "All frames match the golden images." : "Frames differ from the golden images.") << std::endl;
+			if (mismatches > 0) result = EXIT_FAILURE;
+		}
+		GLenum error = glGetError();
+		if (error != GL_NO_ERROR)
+		{
+			std::cout << "OpenGL error " << error << std::endl;
+			result = EXIT_FAILURE;
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	MemoryTracker::release(MemoryTracker::FRAMEBUFFERS, uintptr_t(&colorBuffer));
+	MemoryTracker::release(MemoryTracker::FRAMEBUFFERS, uintptr_t(&depthBuffer));
+	size_t leaks = MemoryTracker::reportLeaks();
+	if (leaks > 0)
+	{
+		std::cout << leaks << " allocations were not released." << std::endl;
+	}
+
+	return result;
+}
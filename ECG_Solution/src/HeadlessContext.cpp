@@ -0,0 +1,87 @@
+#include "HeadlessContext.h"
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+#include <cstring>
+
+HeadlessContext::HeadlessContext(int major, int minor) : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT)
+{
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	if (clientExtensions != nullptr && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr)
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != nullptr)
+		{
+			eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+	}
+	if (eglDisplay == EGL_NO_DISPLAY)
+	{
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+	{
+		std::cout << "Could not initialize an EGL display" << std::endl;
+		return;
+	}
+	display = eglDisplay;
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "EGL display does not support OpenGL" << std::endl;
+		return;
+	}
+
+	//any config, nothing is drawn to an EGL surface
+	const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount);
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext eglContext = eglCreateContext(eglDisplay, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+	if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+	{
+		std::cout << "Could not create an OpenGL " << major << "." << minor << " core context without a surface" << std::endl;
+		if (eglContext != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglContext);
+		return;
+	}
+	context = eglContext;
+
+	glewExperimental = true;
+	GLenum error = glewInit();
+	if (error != GLEW_OK)
+	{
+		std::cout << "Failed to init glew: " << glewGetErrorString(error) << std::endl;
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(eglDisplay, eglContext);
+		context = EGL_NO_CONTEXT;
+	}
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (display == EGL_NO_DISPLAY) return;
+	if (context != EGL_NO_CONTEXT)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+	}
+	eglTerminate(display);
+}
+
+bool HeadlessContext::isValid() const
+{
+	return context != EGL_NO_CONTEXT;
+}
+
+std::string HeadlessContext::getRenderer() const
+{
+	if (!isValid()) return "";
+	return std::string((const char*)glGetString(GL_RENDERER)) + ", " + (const char*)glGetString(GL_VERSION);
+}
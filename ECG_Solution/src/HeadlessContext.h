@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+
+/*
+ OpenGL core context without a window through EGL. The surfaceless platform (EGL_MESA_platform_surfaceless)
+ is used if available, so it also runs on a software implementation like llvmpipe on machines without
+ a GPU or display server. There is no default framebuffer, rendering has to go into framebuffer objects.
+*/
+class HeadlessContext
+{
+private:
+	//EGLDisplay and EGLContext, EGL headers stay out of this header
+	void* display;
+	void* context;
+public:
+	HeadlessContext(int major, int minor);
+	~HeadlessContext();
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	//the context is current and GLEW is initialized
+	bool isValid() const;
+	std::string getRenderer() const;
+};
@@ -0,0 +1,575 @@
+#include "ImageBasedLighting.h"
+#include "KTXFile.h"
+#include "DDSFile.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "AssetCache.h"
+#include "Utils.h"
+#include "JobSystem.h"
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <chrono>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+	const char* faceNames[6] = { "posx", "negx", "posy", "negy", "posz", "negz" };
+
+	//resolution the source cubemap is reduced to before filtering
+	const int sourceSize = 128;
+	const int irradianceSourceSize = 16;
+	const unsigned int prefilterSamples = 128;
+	const unsigned int brdfSamples = 256;
+	const float pi = glm::pi<float>();
+	//bump when the filtering or the cached formats change, older caches are then recomputed
+	const uint32_t cacheVersion = 2;
+
+	/*
+	 CPU cubemap with linear RGB texels and a mip chain, index is level * 6 + face
+	*/
+	struct CubeImage {
+		std::vector<int> sizes;
+		std::vector<std::vector<glm::vec3>> texels;
+
+		glm::vec3& at(int level, int face, int x, int y)
+		{
+			return texels[level * 6 + face][y * sizes[level] + x];
+		}
+		const glm::vec3& at(int level, int face, int x, int y) const
+		{
+			return texels[level * 6 + face][y * sizes[level] + x];
+		}
+		int levels() const
+		{
+			return int(sizes.size());
+		}
+	};
+
+	//direction through texel coordinates u,v in [0,1] of a face, GL cubemap conventions
+	glm::vec3 faceDirection(int face, float u, float v)
+	{
+		float sc = 2.0f * u - 1.0f;
+		float tc = 2.0f * v - 1.0f;
+		glm::vec3 direction;
+		switch (face)
+		{
+		case 0: direction = glm::vec3(1.0f, -tc, -sc); break;
+		case 1: direction = glm::vec3(-1.0f, -tc, sc); break;
+		case 2: direction = glm::vec3(sc, 1.0f, tc); break;
+		case 3: direction = glm::vec3(sc, -1.0f, -tc); break;
+		case 4: direction = glm::vec3(sc, -tc, 1.0f); break;
+		default: direction = glm::vec3(-sc, -tc, -1.0f); break;
+		}
+		return glm::normalize(direction);
+	}
+
+	glm::vec3 sampleCube(const CubeImage& cube, const glm::vec3& direction, int level)
+	{
+		glm::vec3 a = glm::abs(direction);
+		int face;
+		float sc, tc, ma;
+		if (a.x >= a.y && a.x >= a.z)
+		{
+			ma = a.x;
+			face = direction.x > 0.0f ? 0 : 1;
+			sc = direction.x > 0.0f ? -direction.z : direction.z;
+			tc = -direction.y;
+		}
+		else if (a.y >= a.z)
+		{
+			ma = a.y;
+			face = direction.y > 0.0f ? 2 : 3;
+			sc = direction.x;
+			tc = direction.y > 0.0f ? direction.z : -direction.z;
+		}
+		else
+		{
+			ma = a.z;
+			face = direction.z > 0.0f ? 4 : 5;
+			sc = direction.z > 0.0f ? direction.x : -direction.x;
+			tc = -direction.y;
+		}
+		int size = cube.sizes[level];
+		int x = glm::clamp(int(0.5f * (sc / ma + 1.0f) * size), 0, size - 1);
+		int y = glm::clamp(int(0.5f * (tc / ma + 1.0f) * size), 0, size - 1);
+		return cube.at(level, face, x, y);
+	}
+
+	//box filters level 0 down to a 1x1 mip
+	void buildMips(CubeImage& cube)
+	{
+		while (cube.sizes.back() > 1)
+		{
+			int level = cube.levels();
+			int size = cube.sizes.back() / 2;
+			cube.sizes.push_back(size);
+			for (int face = 0; face < 6; ++face)
+			{
+				cube.texels.push_back(std::vector<glm::vec3>(size * size));
+				for (int y = 0; y < size; ++y)
+				{
+					for (int x = 0; x < size; ++x)
+					{
+						cube.at(level, face, x, y) = 0.25f * (cube.at(level - 1, face, 2 * x, 2 * y) + cube.at(level - 1, face, 2 * x + 1, 2 * y)
+							+ cube.at(level - 1, face, 2 * x, 2 * y + 1) + cube.at(level - 1, face, 2 * x + 1, 2 * y + 1));
+					}
+				}
+			}
+		}
+	}
+
+	float areaElement(float x, float y)
+	{
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+	}
+
+	//solid angle covered by a cubemap texel
+	float texelSolidAngle(int x, int y, int size)
+	{
+		float invSize = 1.0f / size;
+		float x0 = 2.0f * x * invSize - 1.0f;
+		float y0 = 2.0f * y * invSize - 1.0f;
+		float x1 = x0 + 2.0f * invSize;
+		float y1 = y0 + 2.0f * invSize;
+		return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+	}
+
+	glm::vec2 hammersley(unsigned int i, unsigned int n)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return glm::vec2(float(i) / float(n), float(bits) * 2.3283064365386963e-10f);
+	}
+
+	//GGX half vector around normal, alpha = roughness^2 like PBR_shader_phong.frag
+	glm::vec3 importanceSampleGGX(glm::vec2 xi, const glm::vec3& normal, float alpha)
+	{
+		float phi = 2.0f * pi * xi.x;
+		float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		glm::vec3 h = glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+
+		glm::vec3 up = std::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+		return glm::normalize(tangent * h.x + bitangent * h.y + normal * h.z);
+	}
+
+	//separable Smith geometry term with the Schlick-GGX approximation, k = alpha / 2 as for image based lighting
+	float smithSchlickGGX(float NdotV, float NdotL, float alpha)
+	{
+		float k = alpha / 2.0f;
+		return (NdotV / (NdotV * (1.0f - k) + k)) * (NdotL / (NdotL * (1.0f - k) + k));
+	}
+
+	std::vector<unsigned char> packHalf(const std::vector<glm::vec4>& pixels, int components)
+	{
+		std::vector<unsigned char> data(pixels.size() * components * sizeof(glm::uint16));
+		glm::uint16* half = reinterpret_cast<glm::uint16*>(data.data());
+		for (size_t i = 0; i < pixels.size(); ++i)
+		{
+			for (int c = 0; c < components; ++c)
+			{
+				half[i * components + c] = glm::packHalf1x16(pixels[i][c]);
+			}
+		}
+		return data;
+	}
+
+	GLuint uploadKTX(KTXImage& image)
+	{
+		GLenum target = image.faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		GLuint handle;
+		glGenTextures(1, &handle);
+		glBindTexture(target, handle);
+		glTexStorage2D(target, image.levels, image.internalFormat, image.width, image.height);
+		MemoryTracker::allocate(MemoryTracker::TEXTURES, handle, MemoryTracker::getTextureSize(image.internalFormat, image.width, image.height, image.levels, image.faces), "IBL map");
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (unsigned int level = 0; level < image.levels; ++level)
+		{
+			GLsizei width = std::max(1u, image.width >> level);
+			GLsizei height = std::max(1u, image.height >> level);
+			for (unsigned int face = 0; face < image.faces; ++face)
+			{
+				GLenum faceTarget = image.faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				glTexSubImage2D(faceTarget, level, 0, 0, width, height, image.format, image.type, image.image(level, face).data());
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, image.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glBindTexture(target, 0);
+		return handle;
+	}
+
+	std::string cachePath(const std::string& directory, const char* name)
+	{
+		return directory + "/" + name + ".ktx";
+	}
+
+	//hash of the cache version and the six face files, 0 if a face is missing
+	uint64_t sourceKey(const std::string& directory)
+	{
+		uint64_t key = AssetCache::hash(&cacheVersion, sizeof(cacheVersion));
+		for (int face = 0; face < 6; ++face)
+		{
+			std::ifstream in(directory + "/" + faceNames[face] + ".dds", std::ios::binary);
+			if (!in) return 0;
+			std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			key = AssetCache::hash(data.data(), data.size(), key);
+		}
+		return key;
+	}
+
+	void setCacheKey(KTXImage& image, uint64_t key)
+	{
+		image.keyValues["ECGcacheVersion"] = std::to_string(cacheVersion);
+		image.keyValues["ECGsourceKey"] = std::to_string(key);
+	}
+
+	bool hasCacheKey(KTXImage& image, uint64_t key)
+	{
+		return image.keyValues["ECGcacheVersion"] == std::to_string(cacheVersion) && image.keyValues["ECGsourceKey"] == std::to_string(key);
+	}
+}
+
+ImageBasedLighting::ImageBasedLighting(std::string directory, bool recompute) : irradianceMap(0), prefilteredMap(0), brdfLUT(0)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	if (!recompute && loadCache(directory))
+	{
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+		std::cout << "IBL loaded from cache in " << time.count() << "ms" << std::endl;
+	}
+	else if (!precompute(directory))
+	{
+		std::cout << "Couldn't load cubemap " << directory << ", image based lighting disabled" << std::endl;
+		createFallback();
+	}
+}
+
+ImageBasedLighting::~ImageBasedLighting()
+{
+	glDeleteTextures(1, &irradianceMap);
+	glDeleteTextures(1, &prefilteredMap);
+	glDeleteTextures(1, &brdfLUT);
+	MemoryTracker::release(MemoryTracker::TEXTURES, irradianceMap);
+	MemoryTracker::release(MemoryTracker::TEXTURES, prefilteredMap);
+	MemoryTracker::release(MemoryTracker::TEXTURES, brdfLUT);
+}
+
+bool ImageBasedLighting::loadCache(const std::string& directory)
+{
+	KTXImage irradiance, prefiltered, lut;
+	if (!loadKTX(cachePath(directory, "irradiance"), irradiance)
+		|| !loadKTX(cachePath(directory, "prefiltered"), prefiltered)
+		|| !loadKTX(cachePath(directory, "brdf_lut"), lut))
+	{
+		return false;
+	}
+	//outdated cache, e.g. from different settings, an older version or a changed cubemap
+	uint64_t key = sourceKey(directory);
+	if (key == 0 || !hasCacheKey(irradiance, key) || !hasCacheKey(prefiltered, key) || !hasCacheKey(lut, key))
+	{
+		return false;
+	}
+	if (irradiance.faces != 6 || prefiltered.faces != 6 || prefiltered.levels != prefilteredLevels
+		|| prefiltered.width != prefilteredSize || lut.width != brdfLUTSize)
+	{
+		return false;
+	}
+	irradianceMap = uploadKTX(irradiance);
+	prefilteredMap = uploadKTX(prefiltered);
+	brdfLUT = uploadKTX(lut);
+	return true;
+}
+
+bool ImageBasedLighting::precompute(const std::string& directory)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//Decode the compressed faces on the GPU and reduce them to sourceSize
+	CubeImage source;
+	source.sizes.push_back(sourceSize);
+	GLuint decodeTexture;
+	glGenTextures(1, &decodeTexture);
+	glBindTexture(GL_TEXTURE_2D, decodeTexture);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	for (int face = 0; face < 6; ++face)
+	{
+		DDSTexture img;
+		if (!loadDDSFile(directory + "/" + faceNames[face] + ".dds", img))
+		{
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glDeleteTextures(1, &decodeTexture);
+			MemoryTracker::release(MemoryTracker::TEXTURES, decodeTexture);
+			return false;
+		}
+		unsigned int blockSize = img.format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+		GLenum srgbFormat = blockSize == 8 ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+			: img.format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT : GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+		//decoded as sRGB, so the read back texels are already linear
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, srgbFormat, img.width, img.height, 0, GLsizei(img.levels[0].size), img.levels[0].data);
+		MemoryTracker::allocate(MemoryTracker::TEXTURES, decodeTexture, img.levels[0].size, "IBL decode");
+		std::vector<glm::vec4> decoded(img.width * img.height);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, decoded.data());
+
+		std::vector<glm::vec3> texels(sourceSize * sourceSize);
+		for (int y = 0; y < sourceSize; ++y)
+		{
+			for (int x = 0; x < sourceSize; ++x)
+			{
+				unsigned int x0 = x * img.width / sourceSize, x1 = std::max(x0 + 1, (x + 1) * img.width / sourceSize);
+				unsigned int y0 = y * img.height / sourceSize, y1 = std::max(y0 + 1, (y + 1) * img.height / sourceSize);
+				glm::vec3 sum(0.0f);
+				for (unsigned int dy = y0; dy < y1; ++dy)
+				{
+					for (unsigned int dx = x0; dx < x1; ++dx)
+					{
+						sum += glm::vec3(decoded[dy * img.width + dx]);
+					}
+				}
+				texels[y * sourceSize + x] = sum / float((x1 - x0) * (y1 - y0));
+			}
+		}
+		source.texels.push_back(texels);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &decodeTexture);
+	MemoryTracker::release(MemoryTracker::TEXTURES, decodeTexture);
+	buildMips(source);
+	int irradianceSourceLevel = 0;
+	while (source.sizes[irradianceSourceLevel] > irradianceSourceSize) ++irradianceSourceLevel;
+
+	std::chrono::duration<double, std::milli> decodeTime = std::chrono::high_resolution_clock::now() - start;
+
+	std::vector<std::vector<glm::vec4>> irradiance(6, std::vector<glm::vec4>(irradianceSize * irradianceSize));
+	std::vector<std::vector<glm::vec4>> prefiltered(6 * prefilteredLevels);
+	std::vector<glm::vec4> lut(brdfLUTSize * brdfLUTSize);
+
+	//Directions and solid angle weighted radiance of the irradiance source texels
+	std::vector<glm::vec3> irradianceDirections;
+	std::vector<glm::vec3> irradianceRadiance;
+	int irradianceSourceTexels = source.sizes[irradianceSourceLevel];
+	for (int face = 0; face < 6; ++face)
+	{
+		for (int y = 0; y < irradianceSourceTexels; ++y)
+		{
+			for (int x = 0; x < irradianceSourceTexels; ++x)
+			{
+				irradianceDirections.push_back(faceDirection(face, (x + 0.5f) / irradianceSourceTexels, (y + 0.5f) / irradianceSourceTexels));
+				irradianceRadiance.push_back(source.at(irradianceSourceLevel, face, x, y) * texelSolidAngle(x, y, irradianceSourceTexels));
+			}
+		}
+	}
+
+	std::vector<std::function<void()>> tasks;
+	//Diffuse irradiance, cosine weighted integral over all source texels
+	for (int face = 0; face < 6; ++face)
+	{
+		tasks.push_back([&, face]() {
+			for (int y = 0; y < irradianceSize; ++y)
+			{
+				for (int x = 0; x < irradianceSize; ++x)
+				{
+					glm::vec3 normal = faceDirection(face, (x + 0.5f) / irradianceSize, (y + 0.5f) / irradianceSize);
+					glm::vec3 sum(0.0f);
+					for (size_t i = 0; i < irradianceDirections.size(); ++i)
+					{
+						float cosTheta = glm::dot(normal, irradianceDirections[i]);
+						if (cosTheta > 0.0f)
+						{
+							sum += irradianceRadiance[i] * cosTheta;
+						}
+					}
+					irradiance[face][y * irradianceSize + x] = glm::vec4(sum / pi, 1.0f);
+				}
+			}
+		});
+	}
+	//Specular, GGX prefiltered per mip (roughness = level / (levels - 1)), N = V = R assumption
+	for (int level = 0; level < prefilteredLevels; ++level)
+	{
+		for (int face = 0; face < 6; ++face)
+		{
+			tasks.push_back([&, level, face]() {
+				int size = prefilteredSize >> level;
+				float roughness = float(level) / float(prefilteredLevels - 1);
+				float alpha = std::max(0.001f, roughness * roughness);
+				float texelSolidAngle = 4.0f * pi / (6.0f * sourceSize * sourceSize);
+				std::vector<glm::vec4>& pixels = prefiltered[level * 6 + face];
+				pixels.resize(size * size);
+				for (int y = 0; y < size; ++y)
+				{
+					for (int x = 0; x < size; ++x)
+					{
+						glm::vec3 normal = faceDirection(face, (x + 0.5f) / size, (y + 0.5f) / size);
+						if (level == 0)
+						{
+							pixels[y * size + x] = glm::vec4(sampleCube(source, normal, 0), 1.0f);
+							continue;
+						}
+						glm::vec3 sum(0.0f);
+						float weight = 0.0f;
+						for (unsigned int i = 0; i < prefilterSamples; ++i)
+						{
+							glm::vec3 h = importanceSampleGGX(hammersley(i, prefilterSamples), normal, alpha);
+							glm::vec3 l = 2.0f * glm::dot(normal, h) * h - normal;
+							float NdotL = glm::dot(normal, l);
+							if (NdotL <= 0.0f) continue;
+							//sample a source mip matching the footprint of the sample (filtered importance sampling)
+							float NdotH = std::max(glm::dot(normal, h), 0.0f);
+							float alpha2 = alpha * alpha;
+							float denominator = 1.0f + (alpha2 - 1.0f) * NdotH * NdotH;
+							float D = alpha2 / (pi * denominator * denominator);
+							float pdf = D / 4.0f + 0.0001f;
+							float sampleSolidAngle = 1.0f / (prefilterSamples * pdf);
+							float lod = glm::clamp(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f, float(source.levels() - 1));
+							sum += sampleCube(source, l, int(lod + 0.5f)) * NdotL;
+							weight += NdotL;
+						}
+						pixels[y * size + x] = glm::vec4(sum / std::max(weight, 0.0001f), 1.0f);
+					}
+				}
+			});
+		}
+	}
+	//Split-sum BRDF table, x = NdotV, y = roughness, one task per row block
+	const int lutRowsPerTask = 16;
+	for (int row = 0; row < brdfLUTSize; row += lutRowsPerTask)
+	{
+		tasks.push_back([&, row]() {
+			for (int y = row; y < row + lutRowsPerTask; ++y)
+			{
+				float roughness = (y + 0.5f) / brdfLUTSize;
+				float alpha = roughness * roughness;
+				for (int x = 0; x < brdfLUTSize; ++x)
+				{
+					float NdotV = (x + 0.5f) / brdfLUTSize;
+					glm::vec3 v = glm::vec3(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+					glm::vec3 normal = glm::vec3(0.0f, 0.0f, 1.0f);
+					float scale = 0.0f;
+					float bias = 0.0f;
+					for (unsigned int i = 0; i < brdfSamples; ++i)
+					{
+						glm::vec3 h = importanceSampleGGX(hammersley(i, brdfSamples), normal, alpha);
+						glm::vec3 l = 2.0f * glm::dot(v, h) * h - v;
+						float NdotL = std::max(l.z, 0.0f);
+						float NdotH = std::max(h.z, 0.0f);
+						float VdotH = std::max(glm::dot(v, h), 0.0f);
+						if (NdotL <= 0.0f) continue;
+						float G = smithSchlickGGX(NdotV, NdotL, alpha);
+						float GVis = G * VdotH / (NdotH * NdotV);
+						float Fc = std::pow(1.0f - VdotH, 5.0f);
+						scale += (1.0f - Fc) * GVis;
+						bias += Fc * GVis;
+					}
+					lut[y * brdfLUTSize + x] = glm::vec4(scale / brdfSamples, bias / brdfSamples, 0.0f, 0.0f);
+				}
+			}
+		});
+	}
+
+	auto filterStart = std::chrono::high_resolution_clock::now();
+	unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+	parallelFor(tasks.size(), threadCount, [&tasks](size_t task) { tasks[task](); });
+	std::chrono::duration<double, std::milli> filterTime = std::chrono::high_resolution_clock::now() - filterStart;
+
+	//Pack to half floats, cache and upload
+	KTXImage irradianceImage;
+	irradianceImage.type = GL_HALF_FLOAT;
+	irradianceImage.format = GL_RGBA;
+	irradianceImage.internalFormat = GL_RGBA16F;
+	irradianceImage.width = irradianceImage.height = irradianceSize;
+	irradianceImage.faces = 6;
+	irradianceImage.levels = 1;
+	for (int face = 0; face < 6; ++face)
+	{
+		irradianceImage.data.push_back(packHalf(irradiance[face], 4));
+	}
+
+	KTXImage prefilteredImage = irradianceImage;
+	prefilteredImage.width = prefilteredImage.height = prefilteredSize;
+	prefilteredImage.levels = prefilteredLevels;
+	prefilteredImage.data.clear();
+	for (std::vector<glm::vec4>& pixels : prefiltered)
+	{
+		prefilteredImage.data.push_back(packHalf(pixels, 4));
+	}
+
+	KTXImage lutImage;
+	lutImage.type = GL_HALF_FLOAT;
+	lutImage.format = GL_RG;
+	lutImage.internalFormat = GL_RG16F;
+	lutImage.width = lutImage.height = brdfLUTSize;
+	lutImage.data.push_back(packHalf(lut, 2));
+
+	uint64_t key = sourceKey(directory);
+	setCacheKey(irradianceImage, key);
+	setCacheKey(prefilteredImage, key);
+	setCacheKey(lutImage, key);
+	if (!saveKTX(cachePath(directory, "irradiance"), irradianceImage)
+		|| !saveKTX(cachePath(directory, "prefiltered"), prefilteredImage)
+		|| !saveKTX(cachePath(directory, "brdf_lut"), lutImage))
+	{
+		std::cout << "Couldn't write IBL cache to " << directory << std::endl;
+	}
+
+	irradianceMap = uploadKTX(irradianceImage);
+	prefilteredMap = uploadKTX(prefilteredImage);
+	brdfLUT = uploadKTX(lutImage);
+
+	std::chrono::duration<double, std::milli> totalTime = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "IBL precomputed in " << totalTime.count() << "ms (decode " << decodeTime.count() << "ms, filtering "
+		<< filterTime.count() << "ms, " << tasks.size() << " tasks on " << threadCount << " threads)" << std::endl;
+	return true;
+}
+
+//Black 1x1 maps, so shaders sampling them still work without a cubemap
+void ImageBasedLighting::createFallback()
+{
+	KTXImage black;
+	black.type = GL_HALF_FLOAT;
+	black.format = GL_RGBA;
+	black.internalFormat = GL_RGBA16F;
+	black.width = black.height = 1;
+	black.faces = 6;
+	black.levels = 1;
+	black.data.assign(6, packHalf(std::vector<glm::vec4>(1, glm::vec4(0.0f)), 4));
+	irradianceMap = uploadKTX(black);
+	prefilteredMap = uploadKTX(black);
+	black.faces = 1;
+	black.data.resize(1);
+	brdfLUT = uploadKTX(black);
+}
+
+void ImageBasedLighting::bind()
+{
+	glActiveTexture(GL_TEXTURE0 + irradianceUnit);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+	glActiveTexture(GL_TEXTURE0 + prefilteredUnit);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, prefilteredMap);
+	glActiveTexture(GL_TEXTURE0 + brdfLUTUnit);
+	glBindTexture(GL_TEXTURE_2D, brdfLUT);
+	glActiveTexture(GL_TEXTURE0);
+	RenderStatistics::add(RenderStatistics::TEXTURE_BINDS, 3);
+}
+
+void ImageBasedLighting::setUniforms(const std::vector<std::shared_ptr<Shader>>& shaders)
+{
+	for (std::shared_ptr<Shader> shader : shaders)
+	{
+		shader->setUniform("irradianceMap", irradianceUnit);
+		shader->setUniform("prefilteredMap", prefilteredUnit);
+		shader->setUniform("brdfLUT", brdfLUTUnit);
+		shader->setUniform("prefilteredMaxLod", float(prefilteredLevels - 1));
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+/*
+ Image based lighting from the cubemap in a directory (posx.dds ... negz.dds).
+ Precomputes the diffuse irradiance map, the GGX prefiltered specular mip chain
+ and the split-sum BRDF lookup table on worker threads (one task per face and mip)
+ and caches them as '.ktx' files next to the cubemap, later runs only load them.
+ The cache holds a hash of the face files and is recomputed when the cubemap changes.
+*/
+class ImageBasedLighting
+{
+public:
+	static const int irradianceUnit = 8;
+	static const int prefilteredUnit = 9;
+	static const int brdfLUTUnit = 10;
+
+	static const int irradianceSize = 32;
+	static const int prefilteredSize = 128;
+	static const int prefilteredLevels = 5;
+	static const int brdfLUTSize = 128;
+private:
+	GLuint irradianceMap;
+	GLuint prefilteredMap;
+	GLuint brdfLUT;
+
+	bool loadCache(const std::string& directory);
+	bool precompute(const std::string& directory);
+	void createFallback();
+public:
+	ImageBasedLighting(std::string directory, bool recompute = false);
+	~ImageBasedLighting();
+
+	void bind();
+	void setUniforms(const std::vector<std::shared_ptr<Shader>>& shaders);
+};
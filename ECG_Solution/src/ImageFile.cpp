@@ -0,0 +1,125 @@
+#include "ImageFile.h"
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <cctype>
+
+namespace {
+	bool loadTGA(const std::vector<unsigned char>& data, Image& image)
+	{
+		if (data.size() < 18) return false;
+		uint8_t idLength = data[0], colorMapType = data[1], imageType = data[2];
+		unsigned int width = data[12] | data[13] << 8, height = data[14] | data[15] << 8;
+		uint8_t bitsPerPixel = data[16], descriptor = data[17];
+		bool rle = imageType == 10;
+		if (colorMapType != 0 || (imageType != 2 && !rle) || (bitsPerPixel != 24 && bitsPerPixel != 32)) return false;
+		//the mip chain and the block compressor need at least one pixel
+		if (width == 0 || height == 0) return false;
+
+		size_t bytesPerPixel = bitsPerPixel / 8;
+		size_t offset = 18 + idLength;
+		size_t pixelCount = size_t(width) * height;
+		image.width = width;
+		image.height = height;
+		image.pixels.assign(pixelCount * 4, 255);
+
+		//pixels in file order, BGR(A)
+		auto readPixel = [&](size_t pixel, size_t source) {
+			unsigned char* target = &image.pixels[pixel * 4];
+			target[0] = data[source + 2];
+			target[1] = data[source + 1];
+			target[2] = data[source];
+			if (bytesPerPixel == 4) target[3] = data[source + 3];
+		};
+		size_t pixel = 0;
+		while (pixel < pixelCount)
+		{
+			size_t count = 1;
+			bool repeat = false;
+			if (rle)
+			{
+				if (offset >= data.size()) return false;
+				uint8_t packet = data[offset++];
+				count = (packet & 0x7F) + 1;
+				repeat = (packet & 0x80) != 0;
+			}
+			for (size_t i = 0; i < count && pixel < pixelCount; ++i, ++pixel)
+			{
+				if (offset + bytesPerPixel > data.size()) return false;
+				readPixel(pixel, offset);
+				if (!repeat || i + 1 == count) offset += bytesPerPixel;
+			}
+		}
+
+		//bottom to top unless the origin bit is set
+		if (!(descriptor & 0x20))
+		{
+			size_t rowSize = size_t(width) * 4;
+			for (unsigned int y = 0; y < height / 2; ++y)
+			{
+				std::swap_ranges(image.pixels.begin() + y * rowSize, image.pixels.begin() + (y + 1) * rowSize,
+					image.pixels.begin() + (height - 1 - y) * rowSize);
+			}
+		}
+		return true;
+	}
+
+	bool loadPPM(const std::vector<unsigned char>& data, Image& image)
+	{
+		//header is "P6 <width> <height> <maxval>" separated by whitespace, comments start with #
+		size_t offset = 2;
+		unsigned int values[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			while (offset < data.size() && (isspace(data[offset]) || data[offset] == '#'))
+			{
+				if (data[offset] == '#') while (offset < data.size() && data[offset] != '\n') ++offset;
+				else ++offset;
+			}
+			values[i] = 0;
+			while (offset < data.size() && isdigit(data[offset]))
+			{
+				values[i] = values[i] * 10 + (data[offset++] - '0');
+			}
+		}
+		++offset;
+		if (values[0] == 0 || values[1] == 0) return false;
+		if (values[2] != 255 || offset + size_t(values[0]) * values[1] * 3 > data.size()) return false;
+
+		image.width = values[0];
+		image.height = values[1];
+		size_t pixelCount = size_t(image.width) * image.height;
+		image.pixels.resize(pixelCount * 4);
+		for (size_t pixel = 0; pixel < pixelCount; ++pixel)
+		{
+			image.pixels[pixel * 4] = data[offset + pixel * 3];
+			image.pixels[pixel * 4 + 1] = data[offset + pixel * 3 + 1];
+			image.pixels[pixel * 4 + 2] = data[offset + pixel * 3 + 2];
+			image.pixels[pixel * 4 + 3] = 255;
+		}
+		return true;
+	}
+}
+
+bool Image::hasAlpha() const
+{
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		if (pixels[i] != 255) return true;
+	}
+	return false;
+}
+
+bool loadImage(const std::string& file, Image& image)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in) return false;
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (data.size() >= 2 && data[0] == 'P' && data[1] == '6')
+	{
+		return loadPPM(data, image);
+	}
+	return loadTGA(data, image);
+}
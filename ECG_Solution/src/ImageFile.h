@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*!
+ * An 8 bit RGBA image, rows from top to bottom
+ */
+struct Image {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<unsigned char> pixels;
+
+	bool hasAlpha() const;
+};
+
+/*!
+ * Loads an uncompressed or RLE '.tga' (24/32 bit) or a binary '.ppm' (P6)
+ * @return false if the file is missing or in an unsupported format
+ */
+bool loadImage(const std::string& file, Image& image);
@@ -0,0 +1,134 @@
+#include "JobSystem.h"
+
+namespace {
+	//system and deque of the current thread, set for the creator and the workers
+	thread_local const JobSystem* currentSystem = nullptr;
+	thread_local unsigned int currentIndex = 0;
+}
+
+JobSystem::JobSystem(unsigned int threadCount) : stopping(false), queued(0), executed(0), stolen(0)
+{
+	if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		queues.emplace_back(new Queue());
+	}
+	previousSystem = currentSystem;
+	previousIndex = currentIndex;
+	currentSystem = this;
+	currentIndex = 0;
+	for (unsigned int i = 1; i < threadCount; ++i)
+	{
+		workers.emplace_back(&JobSystem::work, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	if (currentSystem == this)
+	{
+		currentSystem = previousSystem;
+		currentIndex = previousIndex;
+	}
+}
+
+unsigned int JobSystem::getQueueIndex() const
+{
+	return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::run(Job job, Counter* counter)
+{
+	if (counter) ++counter->value;
+	Queue& queue = *queues[getQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({ std::move(job), counter });
+	}
+	++queued;
+	//taking the lock orders the push before a worker that is about to sleep checks queued
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wake.notify_one();
+}
+
+bool JobSystem::execute(unsigned int index)
+{
+	QueuedJob job;
+	bool found = false, steal = false;
+	{
+		Queue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			found = true;
+		}
+	}
+	//the oldest job of another deque, starting at the next one so the victims are spread
+	for (size_t offset = 1; !found && offset < queues.size(); ++offset)
+	{
+		Queue& victim = *queues[(index + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			found = steal = true;
+		}
+	}
+	if (!found) return false;
+
+	--queued;
+	job.job();
+	++executed;
+	if (steal) ++stolen;
+	if (job.counter) --job.counter->value;
+	return true;
+}
+
+void JobSystem::work(unsigned int index)
+{
+	currentSystem = this;
+	currentIndex = index;
+	while (!stopping)
+	{
+		if (execute(index)) continue;
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return stopping || queued > 0; });
+	}
+}
+
+void JobSystem::wait(Counter& counter)
+{
+	unsigned int index = getQueueIndex();
+	while (!counter.isDone())
+	{
+		//the remaining jobs are running on other threads
+		if (!execute(index)) std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::getThreadCount() const
+{
+	return (unsigned int)queues.size();
+}
+
+JobSystem::Statistics JobSystem::getStatistics() const
+{
+	Statistics statistics;
+	statistics.executed = executed;
+	statistics.stolen = stolen;
+	return statistics;
+}
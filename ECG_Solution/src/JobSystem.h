@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+/*
+ Work-stealing job system for per-frame CPU work. Every thread, the one that created the system
+ included, has its own deque: a thread pushes and pops its own jobs at the back (last in, first out,
+ the data is still in its cache) and steals from the front of the others once its deque is empty.
+ Jobs signal completion through counters, wait() runs other jobs until its counter drops to zero,
+ so jobs may wait for the jobs they spawned. GL calls stay on the thread that created the system,
+ jobs only produce data it consumes.
+*/
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	//unfinished jobs, a job that was given a counter decrements it when it returns
+	class Counter
+	{
+		friend class JobSystem;
+		std::atomic<int> value;
+	public:
+		Counter() : value(0) {}
+		bool isDone() const { return value.load() == 0; }
+	};
+
+	struct Statistics {
+		unsigned long executed = 0;
+		//jobs run by another thread than the one that pushed them
+		unsigned long stolen = 0;
+	};
+private:
+	struct QueuedJob {
+		Job job;
+		Counter* counter;
+	};
+	struct Queue {
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<bool> stopping;
+	//queued jobs over all deques, idle workers sleep while it is zero
+	std::atomic<int> queued;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<unsigned long> executed;
+	std::atomic<unsigned long> stolen;
+	//system of the creating thread before this one, e.g. the worker of another system, restored on destruction
+	const JobSystem* previousSystem;
+	unsigned int previousIndex;
+
+	//deque of the calling thread, threads foreign to the system use the creator's
+	unsigned int getQueueIndex() const;
+	//runs one job, own deque first, false if all deques were empty
+	bool execute(unsigned int index);
+	void work(unsigned int index);
+public:
+	//threadCount includes the creating thread, 0 for one per hardware thread
+	explicit JobSystem(unsigned int threadCount = 0);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	//waits for the workers to finish their current job, queued jobs are dropped, destroy it on the creating thread
+	~JobSystem();
+
+	void run(Job job, Counter* counter = nullptr);
+	//runs jobs on the calling thread until counter is done
+	void wait(Counter& counter);
+
+	/*!
+	 * Calls function(begin, end) for ranges of at most grainSize indices covering [0, count) and returns when all are done
+	 * @param grainSize: indices per job, large enough that a job takes a few microseconds
+	 */
+	template<typename Function> void parallelFor(size_t count, size_t grainSize, const Function& function)
+	{
+		grainSize = std::max<size_t>(1, grainSize);
+		if (count <= grainSize || workers.empty())
+		{
+			if (count > 0) function(size_t(0), count);
+			return;
+		}
+		Counter counter;
+		for (size_t begin = grainSize; begin < count; begin += grainSize)
+		{
+			size_t end = std::min(count, begin + grainSize);
+			run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+		//the first range on this thread while the workers pick up the others
+		function(size_t(0), grainSize);
+		wait(counter);
+	}
+
+	unsigned int getThreadCount() const;
+	Statistics getStatistics() const;
+};
+
+/*!
+ * Calls function(i) for i in [0, count) on up to threadCount threads, the calling thread included,
+ * with a job system that only lives for this call. For one-off work like importing and cooking assets.
+ */
+template<typename Function> void parallelFor(size_t count, unsigned int threadCount, const Function& function)
+{
+	JobSystem jobs((unsigned int)std::max<size_t>(1, std::min<size_t>(threadCount, count)));
+	jobs.parallelFor(count, 1, [&function](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) function(i);
+	});
+}
@@ -0,0 +1,245 @@
+#include "JsonValue.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	const JsonValue nullValue;
+
+	void appendUTF8(std::string& text, unsigned int codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			text += char(codePoint);
+		}
+		else if (codePoint < 0x800)
+		{
+			text += char(0xC0 | codePoint >> 6);
+			text += char(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			text += char(0xE0 | codePoint >> 12);
+			text += char(0x80 | (codePoint >> 6 & 0x3F));
+			text += char(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			text += char(0xF0 | codePoint >> 18);
+			text += char(0x80 | (codePoint >> 12 & 0x3F));
+			text += char(0x80 | (codePoint >> 6 & 0x3F));
+			text += char(0x80 | (codePoint & 0x3F));
+		}
+	}
+}
+
+//recursive descent over the text, stops at the first error
+class JsonValue::Parser
+{
+public:
+	Parser(const char* begin, const char* end) : begin(begin), position(begin), end(end) {}
+
+	bool parseDocument(JsonValue& value)
+	{
+		if (!parseValue(value, 0)) return false;
+		skipWhitespace();
+		return position == end || fail("trailing characters");
+	}
+
+	std::string error;
+
+private:
+	static const int maxDepth = 256;
+	const char* begin;
+	const char* position;
+	const char* end;
+
+	bool fail(const char* reason)
+	{
+		error = std::string(reason) + " at offset " + std::to_string(position - begin);
+		return false;
+	}
+
+	void skipWhitespace()
+	{
+		while (position < end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r')) ++position;
+	}
+
+	bool consume(const char* literal)
+	{
+		size_t length = std::strlen(literal);
+		if (size_t(end - position) < length || std::memcmp(position, literal, length) != 0) return false;
+		position += length;
+		return true;
+	}
+
+	bool parseValue(JsonValue& value, int depth)
+	{
+		if (depth > maxDepth) return fail("nesting too deep");
+		skipWhitespace();
+		if (position == end) return fail("unexpected end");
+		switch (*position)
+		{
+		case '{': return parseObject(value, depth);
+		case '[': return parseArray(value, depth);
+		case '"':
+			value.type = Type::STRING;
+			return parseString(value.string);
+		case 't':
+		case 'f':
+			value.type = Type::BOOLEAN;
+			value.boolean = *position == 't';
+			return consume(value.boolean ? "true" : "false") || fail("invalid literal");
+		case 'n':
+			value.type = Type::NUL;
+			return consume("null") || fail("invalid literal");
+		default:
+			return parseNumber(value);
+		}
+	}
+
+	bool parseNumber(JsonValue& value)
+	{
+		//strtod needs a terminated string, numbers are short so copy at most 64 characters
+		char buffer[65];
+		size_t length = 0;
+		while (position + length < end && length < 64 && std::strchr("+-0123456789.eE", position[length]) != nullptr) ++length;
+		if (length == 0) return fail("unexpected character");
+		std::memcpy(buffer, position, length);
+		buffer[length] = '\0';
+		char* parsedEnd = nullptr;
+		value.type = Type::NUMBER;
+		value.number = std::strtod(buffer, &parsedEnd);
+		if (parsedEnd != buffer + length) return fail("invalid number");
+		position += length;
+		return true;
+	}
+
+	bool parseHex(unsigned int& codePoint)
+	{
+		if (end - position < 4) return fail("truncated escape");
+		codePoint = 0;
+		for (int i = 0; i < 4; ++i, ++position)
+		{
+			char c = *position;
+			codePoint <<= 4;
+			if (c >= '0' && c <= '9') codePoint |= c - '0';
+			else if (c >= 'a' && c <= 'f') codePoint |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') codePoint |= c - 'A' + 10;
+			else return fail("invalid escape");
+		}
+		return true;
+	}
+
+	bool parseString(std::string& text)
+	{
+		++position;
+		text.clear();
+		while (true)
+		{
+			const char* run = position;
+			while (position < end && *position != '"' && *position != '\\') ++position;
+			text.append(run, position);
+			if (position == end) return fail("unterminated string");
+			if (*position++ == '"') return true;
+
+			if (position == end) return fail("unterminated string");
+			char escape = *position++;
+			switch (escape)
+			{
+			case '"': text += '"'; break;
+			case '\\': text += '\\'; break;
+			case '/': text += '/'; break;
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+			{
+				unsigned int codePoint = 0;
+				if (!parseHex(codePoint)) return false;
+				//surrogate pair
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && consume("\\u"))
+				{
+					unsigned int low = 0;
+					if (!parseHex(low)) return false;
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+				appendUTF8(text, codePoint);
+				break;
+			}
+			default: return fail("invalid escape");
+			}
+		}
+	}
+
+	bool parseArray(JsonValue& value, int depth)
+	{
+		++position;
+		value.type = Type::ARRAY;
+		skipWhitespace();
+		if (consume("]")) return true;
+		while (true)
+		{
+			value.elements.emplace_back();
+			if (!parseValue(value.elements.back(), depth + 1)) return false;
+			skipWhitespace();
+			if (consume("]")) return true;
+			if (!consume(",")) return fail("expected ',' or ']'");
+		}
+	}
+
+	bool parseObject(JsonValue& value, int depth)
+	{
+		++position;
+		value.type = Type::OBJECT;
+		skipWhitespace();
+		if (consume("}")) return true;
+		while (true)
+		{
+			skipWhitespace();
+			if (position == end || *position != '"') return fail("expected member name");
+			value.members.emplace_back();
+			if (!parseString(value.members.back().first)) return false;
+			skipWhitespace();
+			if (!consume(":")) return fail("expected ':'");
+			if (!parseValue(value.members.back().second, depth + 1)) return false;
+			skipWhitespace();
+			if (consume("}")) return true;
+			if (!consume(",")) return fail("expected ',' or '}'");
+		}
+	}
+};
+
+bool JsonValue::parse(const char* begin, const char* end, JsonValue& value, std::string& error)
+{
+	value = JsonValue();
+	Parser parser(begin, end);
+	if (parser.parseDocument(value)) return true;
+	error = parser.error;
+	value = JsonValue();
+	return false;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+	return type == Type::ARRAY && index < elements.size() ? elements[index] : nullValue;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const
+{
+	for (const std::pair<std::string, JsonValue>& member : members)
+	{
+		if (member.first == key) return member.second;
+	}
+	return nullValue;
+}
+
+bool JsonValue::has(const std::string& key) const
+{
+	for (const std::pair<std::string, JsonValue>& member : members)
+	{
+		if (member.first == key) return true;
+	}
+	return false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+/*!
+ * A parsed JSON document node. Lookups of missing members or elements return a null value,
+ * so optional fields can be read with defaults without checking every level.
+ */
+class JsonValue
+{
+public:
+	enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+	JsonValue() {}
+
+	/*!
+	 * Parses a complete document
+	 * @param error: receives the reason and offset if parsing fails
+	 * @return false on malformed input
+	 */
+	static bool parse(const char* begin, const char* end, JsonValue& value, std::string& error);
+
+	Type getType() const { return type; }
+	bool isNull() const { return type == Type::NUL; }
+	bool isNumber() const { return type == Type::NUMBER; }
+	bool isString() const { return type == Type::STRING; }
+	bool isArray() const { return type == Type::ARRAY; }
+	bool isObject() const { return type == Type::OBJECT; }
+
+	bool asBool(bool fallback = false) const { return type == Type::BOOLEAN ? boolean : fallback; }
+	double asNumber(double fallback = 0.0) const { return type == Type::NUMBER ? number : fallback; }
+	int asInt(int fallback = 0) const { return type == Type::NUMBER ? int(number) : fallback; }
+	const std::string& asString() const { return string; }
+
+	//number of array elements or object members
+	size_t size() const { return type == Type::ARRAY ? elements.size() : members.size(); }
+	const JsonValue& operator[](size_t index) const;
+	const JsonValue& operator[](const std::string& key) const;
+	bool has(const std::string& key) const;
+	const std::vector<std::pair<std::string, JsonValue>>& getMembers() const { return members; }
+
+private:
+	class Parser;
+
+	Type type = Type::NUL;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string;
+	std::vector<JsonValue> elements;
+	std::vector<std::pair<std::string, JsonValue>> members;
+};
@@ -0,0 +1,151 @@
+#include "KTXFile.h"
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+namespace {
+	const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const uint32_t endianness = 0x04030201;
+
+	struct KTXHeader {
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	uint32_t typeSize(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_HALF_FLOAT: return 2;
+		case GL_FLOAT: return 4;
+		default: return 1;
+		}
+	}
+
+	uint32_t padding(uint32_t size)
+	{
+		return (4 - size % 4) % 4;
+	}
+}
+
+std::vector<unsigned char>& KTXImage::image(unsigned int level, unsigned int face)
+{
+	return data[level * faces + face];
+}
+
+bool saveKTX(const std::string& file, const KTXImage& image)
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out) return false;
+
+	KTXHeader header;
+	header.endianness = endianness;
+	header.glType = image.type;
+	header.glTypeSize = typeSize(image.type);
+	header.glFormat = image.format;
+	header.glInternalFormat = image.internalFormat;
+	header.glBaseInternalFormat = image.format;
+	header.pixelWidth = image.width;
+	header.pixelHeight = image.height;
+	header.pixelDepth = 0;
+	header.numberOfArrayElements = 0;
+	header.numberOfFaces = image.faces;
+	header.numberOfMipmapLevels = image.levels;
+	//every pair is its size, key and value each null terminated, padded to 4 bytes
+	std::string keyValueData;
+	for (const auto& keyValue : image.keyValues)
+	{
+		uint32_t size = uint32_t(keyValue.first.size() + keyValue.second.size() + 2);
+		keyValueData.append(reinterpret_cast<const char*>(&size), sizeof(size));
+		keyValueData.append(keyValue.first).push_back('\0');
+		keyValueData.append(keyValue.second).push_back('\0');
+		keyValueData.append(padding(size), '\0');
+	}
+	header.bytesOfKeyValueData = uint32_t(keyValueData.size());
+
+	out.write(reinterpret_cast<const char*>(identifier), sizeof(identifier));
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(keyValueData.data(), keyValueData.size());
+
+	const char zeros[4] = { 0, 0, 0, 0 };
+	for (unsigned int level = 0; level < image.levels; ++level)
+	{
+		//for non-array cubemaps imageSize is the size of one face
+		uint32_t imageSize = uint32_t(image.data[level * image.faces].size());
+		out.write(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+		for (unsigned int face = 0; face < image.faces; ++face)
+		{
+			const std::vector<unsigned char>& pixels = image.data[level * image.faces + face];
+			out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+			out.write(zeros, padding(uint32_t(pixels.size())));
+		}
+	}
+	return bool(out);
+}
+
+bool loadKTX(const std::string& file, KTXImage& image)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in) return false;
+
+	unsigned char fileIdentifier[12];
+	KTXHeader header;
+	in.read(reinterpret_cast<char*>(fileIdentifier), sizeof(fileIdentifier));
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!in || std::memcmp(fileIdentifier, identifier, sizeof(identifier)) != 0 || header.endianness != endianness)
+	{
+		return false;
+	}
+	std::string keyValueData(header.bytesOfKeyValueData, '\0');
+	in.read(&keyValueData[0], keyValueData.size());
+	image.keyValues.clear();
+	for (size_t offset = 0; offset + sizeof(uint32_t) <= keyValueData.size();)
+	{
+		uint32_t size;
+		std::memcpy(&size, keyValueData.data() + offset, sizeof(size));
+		offset += sizeof(size);
+		if (size > keyValueData.size() - offset) return false;
+		std::string pair = keyValueData.substr(offset, size);
+		size_t separator = pair.find('\0');
+		if (separator != std::string::npos)
+		{
+			std::string value = pair.substr(separator + 1);
+			image.keyValues[pair.substr(0, separator)] = value.substr(0, value.find('\0'));
+		}
+		offset += size + padding(size);
+	}
+
+	image.type = header.glType;
+	image.format = header.glFormat;
+	image.internalFormat = header.glInternalFormat;
+	image.width = header.pixelWidth;
+	image.height = header.pixelHeight;
+	image.faces = header.numberOfFaces;
+	image.levels = header.numberOfMipmapLevels == 0 ? 1 : header.numberOfMipmapLevels;
+	image.data.assign(image.levels * image.faces, std::vector<unsigned char>());
+
+	for (unsigned int level = 0; level < image.levels; ++level)
+	{
+		uint32_t imageSize = 0;
+		in.read(reinterpret_cast<char*>(&imageSize), sizeof(imageSize));
+		for (unsigned int face = 0; face < image.faces; ++face)
+		{
+			std::vector<unsigned char>& pixels = image.image(level, face);
+			pixels.resize(imageSize);
+			in.read(reinterpret_cast<char*>(pixels.data()), imageSize);
+			in.seekg(padding(imageSize), std::ios::cur);
+		}
+	}
+	return bool(in);
+}
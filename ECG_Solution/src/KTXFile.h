@@ -0,0 +1,36 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/*!
+ * An uncompressed KTX 1.1 image, 2D or cubemap with an optional mip chain
+ */
+struct KTXImage {
+	GLenum type = GL_NONE;
+	GLenum format = GL_NONE;
+	GLenum internalFormat = GL_NONE;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int faces = 1;
+	unsigned int levels = 1;
+	//tightly packed pixels of every level and face, index is level * faces + face
+	std::vector<std::vector<unsigned char>> data;
+	//key/value data, e.g. to recognize outdated caches
+	std::map<std::string, std::string> keyValues;
+
+	std::vector<unsigned char>& image(unsigned int level, unsigned int face);
+};
+
+/*!
+ * Writes an image to a '.ktx' file
+ * @return false if the file could not be written
+ */
+bool saveKTX(const std::string& file, const KTXImage& image);
+
+/*!
+ * Loads a '.ktx' file written by saveKTX (uncompressed, little endian)
+ * @return false if the file is missing or unsupported
+ */
+bool loadKTX(const std::string& file, KTXImage& image);
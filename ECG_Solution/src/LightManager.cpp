@@ -1,10 +1,11 @@
 #include "LightManager.h"
+#include "RenderStatistics.h"
 
 const int LightManager::maxDirectionalLights = 64;
 const int LightManager::maxPointLights = 64;
 const int LightManager::maxSpotLights = 64;
 
-LightManager::LightManager()
+LightManager::LightManager() : pointLightNumber(0), directionalLightNumber(0), spotLightNumber(0)
 {
 }
 
@@ -52,6 +53,16 @@ void LightManager::createSpotLight(glm::vec3 color, glm::vec3 position, glm::vec
 	}
 }
 
+void LightManager::clear()
+{
+	directionalLights.clear();
+	pointLights.clear();
+	spotLights.clear();
+	pointLightNumber = 0;
+	directionalLightNumber = 0;
+	spotLightNumber = 0;
+}
+
 void LightManager::setUniforms(const std::vector<std::shared_ptr<Shader>>& shaders)
 {
 	for (std::shared_ptr<Shader> shader : shaders)
@@ -73,5 +84,6 @@ void LightManager::setUniforms(const std::vector<std::shared_ptr<Shader>>& shade
 	{
 		spotLights[i].setUniforms(shaders, i);
 	}
+	RenderStatistics::add(RenderStatistics::LIGHT_UPLOADS, (directionalLights.size() + pointLights.size() + spotLights.size()) * shaders.size());
 
 }
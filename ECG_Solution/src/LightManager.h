@@ -4,7 +4,7 @@
 #include "Light.h"
 #include "PointLight.h"
 #include "DirectionalLight.h"
-#include "Spotlight.h"
+#include "SpotLight.h"
 class LightManager
 {
 private:
@@ -26,6 +26,8 @@ public:
 	void createDirectionalLight(glm::vec3 color, glm::vec3 direction);
 	void createSpotLight(glm::vec3 color, glm::vec3 position, glm::vec3 direction, float innerOpeningAngle, float outerOpeningAngle, glm::vec3 attenuation);
 
+	void clear();
+
 	void setUniforms(const std::vector<std::shared_ptr<Shader>>& shaders);
 };
 
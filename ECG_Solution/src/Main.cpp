@@ -5,6 +5,7 @@
 */
 
 #include <sstream>
+#include <chrono>
 
 #include "Utils.h"
 #include "GL/glew.h"
@@ -17,7 +18,25 @@
 #include "LambertMaterial.h"
 #include "PBRMaterial.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include "TextureManager.h"
+#include "TexturedBatch.h"
 #include "TextureMaterial.h"
+#include "PipelineStatistics.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "DeferredRenderer.h"
+#include "ImageBasedLighting.h"
+#include "Scene.h"
+#include "SceneGraph.h"
+#include "Profiler.h"
+#include "FrameTimes.h"
+#include "FlyThrough.h"
+#include "JobSystem.h"
+#include "DrawList.h"
+#include "Simulation.h"
+#include "AppBenchmarks.h"
+#include "GLTrace.h"
 
 
 
@@ -31,6 +50,7 @@ static void mouseKeyCallback(GLFWwindow* window, int button, int action, int mod
 static void APIENTRY DebugCallbackDefault(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const GLvoid* userParam);
 static std::string FormatDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severity, const char* msg);
 static void perFrameUniforms(std::vector<std::shared_ptr<Shader>>& shaders, Camera& camera);
+static void renderForward(const std::vector<Geometry*>& geometries, std::shared_ptr<Shader>& depthOnly, Camera& camera, PipelineStatistics& pipelineStatistics, Profiler& profiler);
 
 /* --------------------------------------------- */
 // Global variables
@@ -40,6 +60,13 @@ bool _dragging = false;
 bool _strafing = false;
 bool _wireframe = false;
 bool _backFaceCulling = true;
+bool _depthPrepass = false;
+bool _printProfile = false;
+bool _toggleCapture = false;
+bool _printFrameTimes = false;
+bool _printRenderStatistics = false;
+bool _printMemory = false;
+bool _recordTrace = false;
 
 /* --------------------------------------------- */
 // Main
@@ -51,6 +78,7 @@ int main(int argc, char** argv)
 	// Load settings.ini
 	/* --------------------------------------------- */
 
+	auto programStart = std::chrono::high_resolution_clock::now();
 	INIReader reader("assets/settings.ini");
 
 	int window_width = reader.GetInteger("window", "width", 800);
@@ -60,6 +88,46 @@ int main(int argc, char** argv)
 	float farZ = float(reader.GetReal("camera", "far", 100.0f));
 	int refreshRate = reader.GetInteger("window", "refresh_rate", 120);
 	std::string windowTitle = reader.Get("window", "title", "ECG");
+	_depthPrepass = reader.GetBoolean("renderer", "depth_prepass", false);
+	bool deferred = reader.Get("renderer", "mode", "forward") == "deferred";
+	bool textureBatching = reader.GetBoolean("renderer", "texture_batching", false);
+	bool lightSweep = reader.GetBoolean("benchmark", "light_sweep", false);
+	bool srgbCost = reader.GetBoolean("benchmark", "srgb_cost", false);
+	int benchmarkFrames = reader.GetInteger("benchmark", "frames", 100);
+	std::string textureLoad = reader.Get("benchmark", "texture_load", "none");
+	bool meshLoad = reader.GetBoolean("benchmark", "mesh_load", false);
+	std::string modelImport = reader.Get("benchmark", "model_import", "none");
+	bool sceneGraph = reader.GetBoolean("benchmark", "scene_graph", false);
+	bool jobScaling = reader.GetBoolean("benchmark", "job_scaling", false);
+	bool frustumCulling = reader.GetBoolean("renderer", "frustum_culling", true);
+	unsigned int jobThreads = (unsigned int)std::max(0, int(reader.GetInteger("jobs", "threads", 0)));
+	bool threadedSimulation = reader.GetBoolean("simulation", "threaded", true);
+	double simulationRate = std::max(1.0, reader.GetReal("simulation", "rate", 120.0));
+	std::string sceneFile = reader.Get("scene", "file", "./assets/scene.ini");
+	bool sceneSnapshot = reader.GetBoolean("scene", "snapshot", true);
+	Profiler::setEnabled(reader.GetBoolean("profiler", "enabled", true));
+	std::string traceFile = reader.Get("profiler", "trace_file", "./profile.json");
+	int captureFrames = reader.GetInteger("profiler", "capture_frames", 0);
+	std::string frameTimesFile = reader.Get("frame_times", "csv_file", "");
+	bool flyThroughMode = reader.GetBoolean("flythrough", "enabled", false);
+	std::string waypointFile = reader.Get("flythrough", "file", "./assets/lights.txt");
+	int segmentFrames = std::max(1, int(reader.GetInteger("flythrough", "segment_frames", 120)));
+	double flyThroughTimestep = reader.GetReal("flythrough", "timestep", 1.0 / 60.0);
+	std::string flyThroughFile = reader.Get("flythrough", "csv_file", "");
+	unsigned int replayFrames = (unsigned int)std::max(1, int(reader.GetInteger("gl_trace", "replay_frames", 200)));
+	std::string glTraceFile = reader.Get("gl_trace", "file", "");
+	//--flythrough [waypoint file] overrides the settings
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--flythrough")
+		{
+			flyThroughMode = true;
+			if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0)
+			{
+				waypointFile = argv[++i];
+			}
+		}
+	}
 
 
 	/* --------------------------------------------- */
@@ -75,6 +143,7 @@ int main(int argc, char** argv)
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // Request core profile													  
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE); // Prevent window resizing because viewport would have to resize as well (-> not needed in this course)
 	glfwWindowHint(GLFW_REFRESH_RATE, refreshRate);
+	glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE); // Linear shading output, encoded by GL_FRAMEBUFFER_SRGB
 
 	//Debug Context
 
@@ -110,9 +179,12 @@ int main(int argc, char** argv)
 	// Init framework
 	/* --------------------------------------------- */
 
+	//the framework library only exists for Windows
+#ifdef _WIN32
 	if (!initFramework()) {
 		EXIT_WITH_ERROR("Failed to init framework")
 	}
+#endif
 
 	//Set input callbacks
 	glfwSetKeyCallback(window, keyCallback);
@@ -127,10 +199,43 @@ int main(int argc, char** argv)
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	glEnable(GL_FRAMEBUFFER_SRGB);
 	/* --------------------------------------------- */
 	// Initialize scene and render loop
 	/* --------------------------------------------- */
 	{
+		//first, so the peak memory isn't the one of the scene
+		if (textureLoad == "mapped" || textureLoad == "copy")
+		{
+			textureLoadBenchmark(textureLoad == "mapped", reader.GetInteger("benchmark", "texture_load_repeat", 20));
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		if (meshLoad)
+		{
+			meshLoadBenchmark((unsigned int)reader.GetInteger("benchmark", "mesh_load_triangles", 1000000));
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		if (sceneGraph)
+		{
+			sceneGraphBenchmark(reader.GetInteger("benchmark", "scene_graph_nodes", 100000), benchmarkFrames);
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		if (jobScaling)
+		{
+			jobScalingBenchmark(reader.GetInteger("benchmark", "job_scaling_nodes", 200000), benchmarkFrames);
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		if (modelImport != "none")
+		{
+			modelImportBenchmark(modelImport, (unsigned int)reader.GetInteger("benchmark", "mesh_load_triangles", 1000000));
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+
+		//Transform updates, culling and draw order on all cores, the results are consumed here
+		JobSystem jobs(jobThreads);
+		DrawList drawList;
+
 		//Shaders
 		std::vector<std::shared_ptr<Shader>> shaders;
 
@@ -138,30 +243,63 @@ int main(int argc, char** argv)
 		shaders.emplace_back(simpleTexture);
 		std::shared_ptr<Shader> phongPBR = std::make_shared<Shader>("PBR_shader_phong.vert", "PBR_shader_phong.frag");
 		shaders.emplace_back(phongPBR);
-		//Textures
-		std::shared_ptr<Texture> brickTexture = std::make_shared<Texture>("./assets/textures/bricks_diffuse.dds");
-		std::shared_ptr<Texture> woodTexture = std::make_shared<Texture>("./assets/textures/wood_texture.dds");
-
-		std::shared_ptr<Material> difTexCube = std::make_shared<TextureMaterial>(simpleTexture,0.1f,0.7f,0.1f,2.0f,woodTexture);
-		std::shared_ptr<Material> difTexBricks = std::make_shared<TextureMaterial>(simpleTexture,0.1f,0.7f,0.3f,8.0f,brickTexture);
-
-		
+		//Depth pre-pass, not part of shaders since it needs no lights
+		std::shared_ptr<Shader> depthOnly = std::make_shared<Shader>("depthOnly.vert", "depthOnly.frag");
+		//Textures, streamed in the background unless disabled
+		TextureStreamer textureStreamer(reader.GetReal("textures", "upload_budget_ms", 2.0));
+		TextureManager textureManager(textureStreamer, size_t(reader.GetInteger("textures", "vram_budget_mb", 256)) * 1024 * 1024);
+		bool streaming = reader.GetBoolean("textures", "streaming", true);
+
+		//Scene, textures are shared with the texture manager
+		Scene scene(sceneFile, sceneSnapshot, simpleTexture, phongPBR, [&](const std::string& path) {
+			return streaming ? textureManager.get(path) : std::make_shared<Texture>(path);
+		});
+		if (!scene.isLoaded())
+		{
+			EXIT_WITH_ERROR("Failed to load scene")
+		}
 
 		//Lights
 		LightManager lightManager;
-		lightManager.createPointLight(glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.1f, 0.4f, 1.0f));
-		lightManager.createDirectionalLight(glm::vec3(0.8f), glm::vec3(0.0f, -1.0f, -1.0f));
+		scene.createLights(lightManager);
+
+		std::vector<Geometry*> geometries = scene.getGeometries();
 
-		//Geometry task 5
-		glm::mat4 texturedCubeMM = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.5f, 0.0f));
-		Geometry texturedCube(texturedCubeMM, Geometry::createCubeGeometry(1.5f, 1.5f, 1.5), difTexCube);
+		//Textured objects as one multi-draw, textures as layers of a texture array
+		std::unique_ptr<TexturedBatch> texturedBatch;
+		if (textureBatching)
+		{
+			texturedBatch = std::make_unique<TexturedBatch>(std::make_shared<Shader>("diffuseTexture.vert", "diffuseTexture.frag", std::vector<std::string>{ "BATCHED" }));
+			std::vector<Geometry*> unbatched;
+			if (scene.addToBatch(*texturedBatch, unbatched))
+			{
+				texturedBatch->upload();
+				shaders.emplace_back(texturedBatch->getShader());
+				geometries = unbatched;
+			}
+			else
+			{
+				texturedBatch.reset();
+			}
+		}
 
-		glm::mat4 texturedCylinderMM = glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, -1.0f, 0.0f));
-		Geometry texturedCylinder(texturedCylinderMM, Geometry::createCylinderGeometry(1.0f, 1.3f, 32), difTexBricks);
+		//Fragment shader invocations of the shading pass, tagged by pre-pass off (0) / on (1)
+		PipelineStatistics pipelineStatistics(2);
 
-		glm::mat4 texturedSphereMM = glm::translate(glm::mat4(1.0f), glm::vec3(1.5f, -1.0f, 0.0f));
-		Geometry texturedSphere(texturedSphereMM, Geometry::createSphereGeometry(1.0f, 64, 32), difTexBricks);
+		std::unique_ptr<DeferredRenderer> deferredRenderer;
+		if (deferred || lightSweep)
+		{
+			deferredRenderer = std::make_unique<DeferredRenderer>(window_width, window_height);
+		}
 
+		//Environment lighting, precomputed once and cached next to the cubemap
+		ImageBasedLighting imageBasedLighting("./assets/textures/cubemap", reader.GetBoolean("ibl", "recompute", false));
+		imageBasedLighting.setUniforms(shaders);
+		if (deferredRenderer)
+		{
+			imageBasedLighting.setUniforms(deferredRenderer->getLightingShaders());
+		}
+		imageBasedLighting.bind();
 
 		//Camera
 		Camera camera(fov, float(window_width) / float(window_height), nearZ, farZ);
@@ -169,35 +307,257 @@ int main(int argc, char** argv)
 		double thisFrameTime = 0, oldFrameTime = 0, deltaT = 0;
 		double startTime = glfwGetTime();
 		unsigned long framecounter = 0;
+		//every frame time after the first, F6 prints the percentiles, F7 the render statistics of the last frame and F8 the memory usage
+		FrameTimes frameTimes;
+		//CPU and GPU zones of the frame loop, F4 prints a summary and F5 starts/stops a trace capture
+		Profiler profiler;
+		if (captureFrames > 0)
+		{
+			profiler.startCapture();
+		}
+		if (lightSweep)
+		{
+			PipelineStatistics sweepStatistics(2);
+			lightCountBenchmark(window, phongPBR, *deferredRenderer, camera, [&](const std::vector<Geometry*>& sweepGeometries) {
+				renderForward(sweepGeometries, depthOnly, camera, sweepStatistics, profiler);
+			}, _depthPrepass, benchmarkFrames);
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		if (srgbCost)
+		{
+			srgbBenchmark(window, phongPBR, imageBasedLighting, camera, benchmarkFrames);
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
+		/*
+		 Fly-through: the camera follows the waypoints and the scene is animated with a fixed timestep,
+		 so every run renders the same frames. All textures are resident before the first frame,
+		 the frame times are collected per segment between two waypoints.
+		*/
+		std::unique_ptr<FlyThrough> flyThrough;
+		std::vector<FrameTimes> segmentTimes;
+		std::vector<RenderStatistics::Counters> segmentCounters;
+		const int flyThroughWarmupFrames = 10;
+		long flyThroughFrame = -flyThroughWarmupFrames;
+		long flyThroughFrames = 0;
+		if (flyThroughMode)
+		{
+			flyThrough = std::make_unique<FlyThrough>(waypointFile);
+			if (!flyThrough->isLoaded())
+			{
+				EXIT_WITH_ERROR("Failed to load waypoints")
+			}
+			segmentTimes.resize(flyThrough->getSegmentCount());
+			segmentCounters.resize(flyThrough->getSegmentCount());
+			flyThroughFrames = long(flyThrough->getSegmentCount()) * segmentFrames;
+			while (textureStreamer.getPendingCount() > 0)
+			{
+				textureStreamer.update();
+			}
+			glfwSwapInterval(0);
+		}
+		//Camera and scene clock on their own thread, the fly-through steps both once per frame instead
+		std::unique_ptr<Simulation> simulation;
+		if (threadedSimulation && !flyThrough)
+		{
+			simulation = std::make_unique<Simulation>(camera, 1.0 / simulationRate);
+		}
+		RenderStatistics::reset();
 		while (!glfwWindowShouldClose(window)) {
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			bool recordTrace = _recordTrace;
+			if (recordTrace)
+			{
+				GLTrace::begin();
+				_recordTrace = false;
+			}
+			profiler.beginFrame();
+			{
+				PROFILE_ZONE("Clear");
+				PROFILE_GPU_ZONE(profiler, "Clear");
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			}
 
 			//timings
 			++framecounter;
+			Shader::beginFrame();
 			thisFrameTime = glfwGetTime();
 			deltaT = thisFrameTime - oldFrameTime;
 			oldFrameTime = thisFrameTime;
+			if (framecounter > 1)
+			{
+				frameTimes.add(deltaT);
+			}
+			if (flyThrough)
+			{
+				//the time since the last frame began is the time of the last frame
+				if (flyThroughFrame > 0)
+				{
+					segmentTimes[(flyThroughFrame - 1) / segmentFrames].add(deltaT);
+					segmentCounters[(flyThroughFrame - 1) / segmentFrames] += RenderStatistics::getFrameCounters();
+				}
+				if (flyThroughFrame == flyThroughFrames)
+				{
+					glfwSetWindowShouldClose(window, GL_TRUE);
+				}
+			}
+
+			//Keep textures within the memory budget and upload streamed ones within the time budget
+			{
+				PROFILE_ZONE("Texture streaming");
+				PROFILE_GPU_ZONE(profiler, "Texture streaming");
+				textureManager.update();
+				textureStreamer.update();
+			}
 
 			//Poll Input Events
-			glfwPollEvents();
-			glfwGetCursorPos(window, &mouseX, &mouseY);
+			{
+				PROFILE_ZONE("Input");
+				glfwPollEvents();
+				glfwGetCursorPos(window, &mouseX, &mouseY);
+			}
 			//update camera
-			camera.update(int(mouseX), int(mouseY), _zoom, _dragging, _strafing);
+			double sceneTime = thisFrameTime - startTime;
+			if (flyThrough)
+			{
+				PROFILE_ZONE("Camera");
+				long frame = std::max(0l, std::min(flyThroughFrame, flyThroughFrames - 1));
+				FlyThrough::Pose pose = flyThrough->getPose(size_t(frame / segmentFrames), float(frame % segmentFrames) / float(segmentFrames));
+				camera.setPose(pose.position, pose.direction);
+				sceneTime = double(std::max(0l, flyThroughFrame)) * flyThroughTimestep;
+				++flyThroughFrame;
+			}
+			else if (simulation)
+			{
+				PROFILE_ZONE("Camera");
+				Simulation::Input input;
+				input.mouseX = int(mouseX);
+				input.mouseY = int(mouseY);
+				input.zoom = _zoom;
+				input.dragging = _dragging;
+				input.strafing = _strafing;
+				simulation->setInput(input);
+				Simulation::State state;
+				if (simulation->getState(state))
+				{
+					camera.setPose(state.cameraPosition, state.cameraDirection);
+					sceneTime = state.time;
+				}
+			}
+			else
+			{
+				PROFILE_ZONE("Camera");
+				camera.update(int(mouseX), int(mouseY), _zoom, _dragging, _strafing);
+			}
+			//world and normal matrices of animated objects
+			{
+				PROFILE_ZONE("Scene graph");
+				scene.update(sceneTime, &jobs);
+			}
 
 			//Update Lights
-			lightManager.setUniforms(shaders);
+			{
+				PROFILE_ZONE("Light upload");
+				PROFILE_GPU_ZONE(profiler, "Light upload");
+				lightManager.setUniforms(shaders);
+			}
 
 			//Update Frame uniforms
-			perFrameUniforms(shaders, camera);
+			{
+				PROFILE_ZONE("Frame uniforms");
+				PROFILE_GPU_ZONE(profiler, "Frame uniforms");
+				perFrameUniforms(shaders, camera);
+			}
+
+			//Visible geometries in draw order
+			{
+				PROFILE_ZONE("Draw list");
+				drawList.build(geometries, camera.getViewProjectionMatrix(), camera.getPosition(), jobs, frustumCulling);
+				if (texturedBatch && frustumCulling)
+				{
+					texturedBatch->cull(camera.getViewProjectionMatrix());
+				}
+			}
 
 			//draw Geometries
-			texturedCube.draw();
-			texturedCylinder.draw();
-			texturedSphere.draw();
-
+			{
+				PROFILE_ZONE("Render");
+				PROFILE_GPU_ZONE(profiler, "Render");
+				if (deferred)
+				{
+					deferredRenderer->render(drawList.getVisible(), lightManager, camera);
+				}
+				else
+				{
+					renderForward(drawList.getVisible(), depthOnly, camera, pipelineStatistics, profiler);
+				}
+				if (texturedBatch)
+				{
+					PROFILE_ZONE("Textured batch");
+					PROFILE_GPU_ZONE(profiler, "Textured batch");
+					texturedBatch->draw();
+				}
+			}
+
+			if (recordTrace)
+			{
+				GLTrace::end();
+			}
 
 			//Swap Buffers
-			glfwSwapBuffers(window);
+			{
+				PROFILE_ZONE("Swap");
+				glfwSwapBuffers(window);
+			}
+			profiler.endFrame();
+			RenderStatistics::endFrame();
+			if (recordTrace)
+			{
+				std::cout << GLTrace::getReplayReport(replayFrames);
+				if (!glTraceFile.empty() && !GLTrace::save(glTraceFile))
+				{
+					std::cout << "Failed to write GL trace " << glTraceFile << std::endl;
+				}
+			}
+			if (framecounter == 1)
+			{
+				glFinish();
+				std::chrono::duration<double, std::milli> firstFrame = std::chrono::high_resolution_clock::now() - programStart;
+				std::cout << "Time to first frame: " << firstFrame.count() << "ms, scene " << (scene.isFromSnapshot() ? "mapped from snapshot" : "resolved from scene file")
+					<< " in " << scene.getLoadTime() << "ms." << std::endl;
+			}
+
+			if (_printFrameTimes)
+			{
+				std::cout << frameTimes.getReport();
+				_printFrameTimes = false;
+			}
+			if (_printRenderStatistics)
+			{
+				std::cout << "Last frame: " << RenderStatistics::format(RenderStatistics::getFrameCounters()) << "." << std::endl;
+				_printRenderStatistics = false;
+			}
+			if (_printMemory)
+			{
+				std::cout << MemoryTracker::getReport();
+				_printMemory = false;
+			}
+			if (_printProfile)
+			{
+				std::cout << profiler.getSummary();
+				_printProfile = false;
+			}
+			if (_toggleCapture || (captureFrames > 0 && framecounter == (unsigned long)captureFrames && profiler.isCapturing()))
+			{
+				if (!profiler.isCapturing())
+				{
+					profiler.startCapture();
+					std::cout << "Profiler capture started" << std::endl;
+				}
+				else
+				{
+					std::cout << (profiler.stopCapture(traceFile) ? "Profiler capture written to " : "Could not write profiler capture ") << traceFile << std::endl;
+				}
+				_toggleCapture = false;
+			}
 		}
 		/* --------------------------------------------- */
 		// Statistics
@@ -205,6 +565,80 @@ int main(int argc, char** argv)
 		double endTime = glfwGetTime();
 		std::cout << "Program ran for " << endTime - startTime << "seconds." << std::endl;
 		std::cout << "Average fps: " << framecounter / (endTime - startTime) << "." << std::endl;
+		std::cout << frameTimes.getReport();
+		RenderStatistics::Counters totalCounters = RenderStatistics::getTotalCounters();
+		double countedFrames = std::max(1.0, double(RenderStatistics::getFrameCount()));
+		std::cout << "Per frame: " << RenderStatistics::format(totalCounters, countedFrames) << "." << std::endl;
+		if (!frameTimesFile.empty())
+		{
+			std::cout << (frameTimes.appendCSV(frameTimesFile, sceneFile, RenderStatistics::getCSVHeader(), RenderStatistics::getCSVValues(totalCounters, countedFrames)) ? "Frame times appended to " : "Could not write frame times to ") << frameTimesFile << std::endl;
+		}
+		if (flyThrough)
+		{
+			std::cout << "Fly-through of " << flyThrough->getWaypointCount() << " waypoints, " << segmentFrames << " frames per segment:" << std::endl;
+			bool written = true;
+			for (size_t segment = 0; segment < segmentTimes.size(); ++segment)
+			{
+				std::cout << "  Segment " << segment + 1 << ": " << segmentTimes[segment].getReport();
+				if (!flyThroughFile.empty())
+				{
+					written = segmentTimes[segment].appendCSV(flyThroughFile, waypointFile + " segment " + std::to_string(segment + 1),
+						RenderStatistics::getCSVHeader(), RenderStatistics::getCSVValues(segmentCounters[segment], std::max(1.0, double(segmentTimes[segment].getCount())))) && written;
+				}
+			}
+			if (!flyThroughFile.empty())
+			{
+				std::cout << (written ? "Segment frame times appended to " : "Could not write segment frame times to ") << flyThroughFile << std::endl;
+			}
+		}
+		Shader::UniformStatistics uniformStatistics = Shader::getTotalStatistics();
+		std::cout << "Uniform uploads per frame: " << double(uniformStatistics.uploads) / framecounter
+			<< ", avoided per frame: " << double(uniformStatistics.skipped) / framecounter
+			<< ", locations changed per frame: " << double(uniformStatistics.changed) / framecounter << "." << std::endl;
+		TextureManager::Counters textureCounters = textureManager.getTotalCounters();
+		std::cout << "Resident texture memory: " << textureCounters.residentBytes / 1024 << " KB, evictions: " << textureCounters.evictions
+			<< ", reuploads: " << textureCounters.reuploads << "." << std::endl;
+		if (Profiler::isEnabled())
+		{
+			std::cout << profiler.getSummary();
+		}
+		if (profiler.isCapturing())
+		{
+			std::cout << (profiler.stopCapture(traceFile) ? "Profiler capture written to " : "Could not write profiler capture ") << traceFile << std::endl;
+		}
+		SceneGraph::Counters transformCounters = scene.getSceneGraph().getTotalCounters();
+		unsigned long sceneUpdates = std::max(1ul, scene.getSceneGraph().getUpdateCount());
+		std::cout << "Transforms updated per frame: " << double(transformCounters.updated) / sceneUpdates << " of " << double(transformCounters.total) / sceneUpdates << "." << std::endl;
+		JobSystem::Statistics jobStatistics = jobs.getStatistics();
+		std::cout << "Jobs: " << jobStatistics.executed << " on " << jobs.getThreadCount() << " threads, " << jobStatistics.stolen << " stolen." << std::endl;
+		if (simulation)
+		{
+			std::cout << "Simulation: " << simulation->getStepCount() << " steps at " << simulationRate << "Hz, " << simulation->getDroppedCount() << " dropped." << std::endl;
+		}
+		std::cout << MemoryTracker::getReport();
+		if (pipelineStatistics.isSupported())
+		{
+			pipelineStatistics.poll(true);
+			const char* modes[] = { "without", "with" };
+			for (int mode = 0; mode < 2; ++mode)
+			{
+				PipelineStatistics::Result result = pipelineStatistics.getResult(mode);
+				if (result.frames == 0) continue;
+				std::cout << "Fragment shader invocations per frame " << modes[mode] << " depth pre-pass: "
+					<< double(result.fragmentInvocations) / result.frames << " (" << result.frames << " frames)." << std::endl;
+			}
+		}
+		else
+		{
+			std::cout << "GL_ARB_pipeline_statistics_query not supported, no fragment statistics." << std::endl;
+		}
+	}
+
+	//every asset was released with the scope above
+	size_t leaks = MemoryTracker::reportLeaks();
+	if (leaks > 0)
+	{
+		std::cout << leaks << " allocations were not released." << std::endl;
 	}
 
 
@@ -214,7 +648,9 @@ int main(int argc, char** argv)
 	// Destroy framework
 	/* --------------------------------------------- */
 
+#ifdef _WIN32
 	destroyFramework();
+#endif
 
 
 	/* --------------------------------------------- */
@@ -259,6 +695,35 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
 			glDisable(GL_CULL_FACE);
 		}
 	}
+	if (key == GLFW_KEY_F3)
+	{
+		_depthPrepass = !_depthPrepass;
+		std::cout << "Depth pre-pass " << (_depthPrepass ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F4)
+	{
+		_printProfile = true;
+	}
+	if (key == GLFW_KEY_F5)
+	{
+		_toggleCapture = true;
+	}
+	if (key == GLFW_KEY_F6)
+	{
+		_printFrameTimes = true;
+	}
+	if (key == GLFW_KEY_F7)
+	{
+		_printRenderStatistics = true;
+	}
+	if (key == GLFW_KEY_F8)
+	{
+		_printMemory = true;
+	}
+	if (key == GLFW_KEY_F9)
+	{
+		_recordTrace = true;
+	}
 }
 
 static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
@@ -396,3 +861,43 @@ void perFrameUniforms(std::vector<std::shared_ptr<Shader>>& shaders, Camera & ca
 		shader->setUniform("cameraPosition", camera.getPosition());
 	}
 }
+
+/*
+ Forward shading of all geometries, with optional depth pre-pass
+*/
+void renderForward(const std::vector<Geometry*>& geometries, std::shared_ptr<Shader>& depthOnly, Camera& camera, PipelineStatistics& pipelineStatistics, Profiler& profiler)
+{
+	//Depth pre-pass, shading pass then only runs for visible fragments
+	if (_depthPrepass)
+	{
+		depthOnly->setUniform("viewProjectionMatrix", camera.getViewProjectionMatrix());
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		PROFILE_ZONE("Depth pre-pass");
+		PROFILE_GPU_ZONE(profiler, "Depth pre-pass");
+		for (Geometry* geometry : geometries)
+		{
+			geometry->drawDepth(depthOnly);
+		}
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	//draw Geometries
+	pipelineStatistics.begin(_depthPrepass ? 1 : 0);
+	for (Geometry* geometry : geometries)
+	{
+		PROFILE_ZONE("Draw");
+		PROFILE_GPU_ZONE(profiler, "Draw");
+		geometry->draw();
+	}
+	pipelineStatistics.end();
+	pipelineStatistics.poll();
+
+	if (_depthPrepass)
+	{
+		//depth writes are needed for the next clear
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+}
@@ -0,0 +1,82 @@
+#include "MappedFile.h"
+#include "MemoryTracker.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) : mapping(nullptr), size(0), file(INVALID_HANDLE_VALUE), fileMapping(nullptr)
+{
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+	fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (fileMapping == nullptr) return;
+	mapping = static_cast<const unsigned char*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mapping == nullptr) return;
+	size = size_t(fileSize.QuadPart);
+	MemoryTracker::allocate(MemoryTracker::MAPPED_FILES, uintptr_t(this), size, path);
+}
+
+MappedFile::~MappedFile()
+{
+	MemoryTracker::release(MemoryTracker::MAPPED_FILES, uintptr_t(this));
+	if (mapping != nullptr) UnmapViewOfFile(mapping);
+	if (fileMapping != nullptr) CloseHandle(fileMapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const std::string& path) : mapping(nullptr), size(0), descriptor(-1)
+{
+	descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) return;
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0) return;
+	void* address = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (address == MAP_FAILED) return;
+	madvise(address, size_t(status.st_size), MADV_SEQUENTIAL);
+	mapping = static_cast<const unsigned char*>(address);
+	size = size_t(status.st_size);
+	MemoryTracker::allocate(MemoryTracker::MAPPED_FILES, uintptr_t(this), size, path);
+}
+
+MappedFile::~MappedFile()
+{
+	MemoryTracker::release(MemoryTracker::MAPPED_FILES, uintptr_t(this));
+	if (mapping != nullptr) munmap(const_cast<unsigned char*>(mapping), size);
+	if (descriptor >= 0) close(descriptor);
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return mapping != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return mapping;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
+
+void MappedFile::prefetch() const
+{
+	const size_t pageSize = 4096;
+	volatile unsigned char sum = 0;
+	for (size_t offset = 0; offset < size; offset += pageSize)
+	{
+		sum += mapping[offset];
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+/*
+ Read only mapping of a whole file (mmap, MapViewOfFile on Windows).
+ Pages are read by the OS on first access and never copied to the heap.
+*/
+class MappedFile
+{
+private:
+	const unsigned char* mapping;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* fileMapping;
+#else
+	int descriptor;
+#endif
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const;
+	const unsigned char* data() const;
+	size_t getSize() const;
+	//touches every page, so a worker thread takes the page faults instead of the reader
+	void prefetch() const;
+};
@@ -17,6 +17,10 @@ void Material::setUniforms(int textureUnit)
 	setUniforms();
 }
 
+bool Material::setGBufferUniforms(std::shared_ptr<Shader>& /*gBufferShader*/)
+{
+	return false;
+}
 
 std::shared_ptr<Shader> Material::getShader()
 {
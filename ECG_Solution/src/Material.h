@@ -10,6 +10,8 @@ public:
 	virtual ~Material();
 	virtual void setUniforms();
 	virtual void setUniforms(int textureUnit);
+	//Sets the material on a G-buffer shader, returns false if the material can only be rendered forward
+	virtual bool setGBufferUniforms(std::shared_ptr<Shader>& gBufferShader);
 	virtual std::shared_ptr<Shader> getShader() final;
 };
 
@@ -0,0 +1,190 @@
+#include "MemoryTracker.h"
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+	const char* names[MemoryTracker::CATEGORY_COUNT] = {
+		"vertex buffers", "index buffers", "uniform/storage buffers", "staging buffers",
+		"textures", "framebuffers", "programs", "geometry data", "mapped files"
+	};
+
+	struct Allocation {
+		size_t bytes;
+		std::string label;
+	};
+
+	struct State {
+		std::mutex mutex;
+		std::map<std::pair<int, uintptr_t>, Allocation> allocations;
+		MemoryTracker::Usage categories[MemoryTracker::CATEGORY_COUNT];
+		MemoryTracker::Usage gpu;
+		MemoryTracker::Usage cpu;
+	};
+
+	//never destroyed, static objects may release their memory after the end of main
+	State& state()
+	{
+		static State* instance = new State();
+		return *instance;
+	}
+
+	void grow(MemoryTracker::Usage& usage, size_t oldBytes, size_t newBytes)
+	{
+		usage.liveBytes = usage.liveBytes - oldBytes + newBytes;
+		usage.peakBytes = std::max(usage.peakBytes, usage.liveBytes);
+	}
+
+	std::string kilobytes(size_t bytes)
+	{
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(1) << double(bytes) / 1024.0 << " KB";
+		return out.str();
+	}
+
+	unsigned int blockBytes(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	unsigned int pixelBytes(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8: return 1;
+		case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+		case GL_RGB8: case GL_SRGB8: return 3;
+		case GL_RGB16F: return 6;
+		case GL_RGBA16F: case GL_RG32F: return 8;
+		case GL_RGB32F: return 12;
+		case GL_RGBA32F: return 16;
+		//RGBA8, RG16, R11F_G11F_B10F, DEPTH24_STENCIL8, DEPTH_COMPONENT32F, ...
+		default: return 4;
+		}
+	}
+}
+
+void MemoryTracker::allocate(Category category, uintptr_t key, size_t bytes, const std::string& label)
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	Usage& usage = category < FIRST_CPU_CATEGORY ? s.gpu : s.cpu;
+	auto inserted = s.allocations.insert({ { int(category), key }, { bytes, label } });
+	size_t oldBytes = 0;
+	if (inserted.second)
+	{
+		++s.categories[category].liveAllocations;
+		++s.categories[category].allocations;
+		++usage.liveAllocations;
+		++usage.allocations;
+	}
+	else
+	{
+		oldBytes = inserted.first->second.bytes;
+		inserted.first->second.bytes = bytes;
+		if (!label.empty()) inserted.first->second.label = label;
+	}
+	grow(s.categories[category], oldBytes, bytes);
+	grow(usage, oldBytes, bytes);
+}
+
+void MemoryTracker::release(Category category, uintptr_t key)
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	auto search = s.allocations.find({ int(category), key });
+	if (search == s.allocations.end()) return;
+	Usage& usage = category < FIRST_CPU_CATEGORY ? s.gpu : s.cpu;
+	s.categories[category].liveBytes -= search->second.bytes;
+	--s.categories[category].liveAllocations;
+	usage.liveBytes -= search->second.bytes;
+	--usage.liveAllocations;
+	s.allocations.erase(search);
+}
+
+MemoryTracker::Usage MemoryTracker::getUsage(Category category)
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return s.categories[category];
+}
+
+MemoryTracker::Usage MemoryTracker::getGPUUsage()
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return s.gpu;
+}
+
+MemoryTracker::Usage MemoryTracker::getCPUUsage()
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	return s.cpu;
+}
+
+const char* MemoryTracker::getName(Category category)
+{
+	return names[category];
+}
+
+std::string MemoryTracker::getReport()
+{
+	Usage gpu = getGPUUsage(), cpu = getCPUUsage();
+	std::ostringstream out;
+	for (int i = 0; i < CATEGORY_COUNT; ++i)
+	{
+		if (i == 0 || i == FIRST_CPU_CATEGORY)
+		{
+			const Usage& total = i == 0 ? gpu : cpu;
+			out << (i == 0 ? "GPU" : "CPU") << " memory: " << kilobytes(total.liveBytes) << " live, " << kilobytes(total.peakBytes) << " peak" << std::endl;
+		}
+		Usage usage = getUsage(Category(i));
+		if (usage.allocations == 0) continue;
+		out << "  " << names[i] << ": " << kilobytes(usage.liveBytes) << " live in " << usage.liveAllocations << " allocations, "
+			<< kilobytes(usage.peakBytes) << " peak" << std::endl;
+	}
+	return out.str();
+}
+
+size_t MemoryTracker::reportLeaks()
+{
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	for (const auto& allocation : s.allocations)
+	{
+		std::cout << "Leaked " << names[allocation.first.first] << " " << (allocation.second.label.empty() ? "allocation" : allocation.second.label)
+			<< ": " << allocation.second.bytes << " bytes" << std::endl;
+	}
+	return s.allocations.size();
+}
+
+size_t MemoryTracker::getTextureSize(GLenum internalFormat, unsigned int width, unsigned int height, unsigned int levels, unsigned int layers)
+{
+	unsigned int block = blockBytes(internalFormat);
+	size_t bytes = 0;
+	for (unsigned int level = 0; level < levels; ++level)
+	{
+		unsigned int levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+		bytes += block > 0 ? size_t((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * block
+			: size_t(levelWidth) * levelHeight * pixelBytes(internalFormat);
+	}
+	return bytes * layers;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ Accounting of GPU allocations (buffers, textures, programs) and CPU-side asset memory.
+ Every allocation site registers the size of what it created under a key, the GL name for GPU
+ objects and the address for CPU ones, and releases the key when it deletes it. Registering a key
+ again replaces its size, e.g. when a buffer is orphaned with a different size.
+ Thread safe, assets are loaded on worker threads. No GL calls, the asset cooker uses it too.
+*/
+class MemoryTracker
+{
+public:
+	enum Category {
+		VERTEX_BUFFERS,
+		INDEX_BUFFERS,
+		//uniform, shader storage and indirect command buffers
+		UNIFORM_BUFFERS,
+		//pixel buffers for uploads and read backs
+		STAGING_BUFFERS,
+		TEXTURES,
+		//render targets
+		FRAMEBUFFERS,
+		//size of the linked program binary, the closest the driver tells
+		PROGRAMS,
+		GEOMETRY_DATA,
+		MAPPED_FILES,
+		CATEGORY_COUNT
+	};
+	//categories before FIRST_CPU_CATEGORY are in video memory
+	static const Category FIRST_CPU_CATEGORY = GEOMETRY_DATA;
+
+	struct Usage {
+		size_t liveBytes = 0;
+		size_t peakBytes = 0;
+		size_t liveAllocations = 0;
+		//allocations ever made
+		size_t allocations = 0;
+	};
+
+	static void allocate(Category category, uintptr_t key, size_t bytes, const std::string& label = "");
+	//unknown keys are ignored, like glDelete* ignores 0
+	static void release(Category category, uintptr_t key);
+
+	static Usage getUsage(Category category);
+	//sum over the GPU or CPU categories, the peak is the peak of the sum
+	static Usage getGPUUsage();
+	static Usage getCPUUsage();
+
+	static const char* getName(Category category);
+	//live and peak bytes in total and per category
+	static std::string getReport();
+	/*!
+	 * Prints every allocation that is still registered, call it after all assets were released
+	 * @return the number of leaked allocations
+	 */
+	static size_t reportLeaks();
+
+	//bytes of a texture with all its levels, layers are array layers or cube faces
+	static size_t getTextureSize(GLenum internalFormat, unsigned int width, unsigned int height, unsigned int levels, unsigned int layers = 1);
+};
@@ -0,0 +1,152 @@
+#include "MeshFile.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	const char magic[4] = { 'M', 'E', 'S', 'H' };
+
+	static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::vec2) == 8, "vertex streams are written as tightly packed floats");
+	static_assert(sizeof(MeshOptimizer::Meshlet) == 48 && sizeof(MeshFile::LOD) == 32, "file structures must not have padding");
+
+	using SectionFile::addSection;
+	using SectionFile::validSection;
+}
+
+bool MeshFile::save(const std::string& file, const GeometryData& geometry, unsigned int lodCount)
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out || geometry.positions.empty()) return false;
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, magic, 4);
+	header.version = version;
+	header.vertexCount = uint32_t(geometry.positions.size());
+
+	glm::vec3 boundsMin = geometry.positions[0], boundsMax = boundsMin;
+	for (const glm::vec3& position : geometry.positions)
+	{
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+	for (int i = 0; i < 3; ++i)
+	{
+		header.boundsMin[i] = boundsMin[i];
+		header.boundsMax[i] = boundsMax[i];
+	}
+
+	//each level clusters the previous one, with cells grown until at least half of the triangles are gone
+	std::vector<LOD> lods;
+	std::vector<unsigned int> indices;
+	std::vector<MeshOptimizer::Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+	std::vector<unsigned int> level = geometry.indices;
+	float diagonal = glm::length(boundsMax - boundsMin);
+	float cellSize = diagonal / 1024.0f;
+	float error = 0.0f;
+	for (unsigned int lod = 0; lod < std::max(1u, lodCount); ++lod)
+	{
+		LOD range = {};
+		range.indexOffset = uint32_t(indices.size());
+		range.indexCount = uint32_t(level.size());
+		range.meshletOffset = uint32_t(meshlets.size());
+		range.error = error;
+		MeshOptimizer::buildMeshlets(level, geometry.positions, meshlets, meshletVertices, meshletTriangles);
+		range.meshletCount = uint32_t(meshlets.size()) - range.meshletOffset;
+		indices.insert(indices.end(), level.begin(), level.end());
+		lods.push_back(range);
+		if (lod + 1 == lodCount) break;
+
+		std::vector<unsigned int> coarser;
+		do
+		{
+			cellSize *= 2.0f;
+			coarser = MeshOptimizer::simplifyClusters(level, geometry.positions, cellSize);
+		} while (coarser.size() * 2 > level.size() && cellSize < diagonal);
+		if (coarser.empty() || coarser.size() * 2 > level.size()) break;
+		level = MeshOptimizer::optimizeVertexCache(coarser, geometry.positions.size());
+		error = cellSize;
+	}
+	header.indexCount = lods[0].indexCount;
+	header.lodCount = uint32_t(lods.size());
+	header.meshletCount = uint32_t(meshlets.size());
+
+	std::vector<glm::vec3> normals(geometry.normals);
+	std::vector<glm::vec2> uv(geometry.uv);
+	normals.resize(geometry.positions.size(), glm::vec3(0.0f, 1.0f, 0.0f));
+	uv.resize(geometry.positions.size(), glm::vec2(0.0f));
+
+	std::vector<char> sections;
+	header.positions = addSection(sections, sizeof(Header), geometry.positions.data(), geometry.positions.size());
+	header.normals = addSection(sections, sizeof(Header), normals.data(), normals.size());
+	header.uv = addSection(sections, sizeof(Header), uv.data(), uv.size());
+	header.indices = addSection(sections, sizeof(Header), indices.data(), indices.size());
+	header.lods = addSection(sections, sizeof(Header), lods.data(), lods.size());
+	header.meshlets = addSection(sections, sizeof(Header), meshlets.data(), meshlets.size());
+	header.meshletVertices = addSection(sections, sizeof(Header), meshletVertices.data(), meshletVertices.size());
+	header.meshletTriangles = addSection(sections, sizeof(Header), meshletTriangles.data(), meshletTriangles.size());
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(sections.data(), sections.size());
+	return bool(out);
+}
+
+bool MeshFile::parse(const unsigned char* data, size_t size, Mesh& mesh)
+{
+	if (data == nullptr || size < sizeof(Header)) return false;
+	Header& header = mesh.header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, magic, 4) != 0 || header.version != version || header.lodCount == 0) return false;
+
+	//the index section holds all levels, the sizes of the others follow from the counts
+	if (!validSection(header.positions, size, sizeof(glm::vec3), header.vertexCount)
+		|| !validSection(header.normals, size, sizeof(glm::vec3), header.vertexCount)
+		|| !validSection(header.uv, size, sizeof(glm::vec2), header.vertexCount)
+		|| !validSection(header.indices, size, sizeof(uint32_t), header.indices.size / sizeof(uint32_t))
+		|| !validSection(header.lods, size, sizeof(LOD), header.lodCount)
+		|| !validSection(header.meshlets, size, sizeof(MeshOptimizer::Meshlet), header.meshletCount)
+		|| !validSection(header.meshletVertices, size, sizeof(uint32_t), header.meshletVertices.size / sizeof(uint32_t))
+		|| !validSection(header.meshletTriangles, size, 1, header.meshletTriangles.size))
+	{
+		return false;
+	}
+
+	mesh.positions = reinterpret_cast<const glm::vec3*>(data + header.positions.offset);
+	mesh.normals = reinterpret_cast<const glm::vec3*>(data + header.normals.offset);
+	mesh.uv = reinterpret_cast<const glm::vec2*>(data + header.uv.offset);
+	mesh.indices = reinterpret_cast<const uint32_t*>(data + header.indices.offset);
+	mesh.lods = reinterpret_cast<const LOD*>(data + header.lods.offset);
+	mesh.meshlets = reinterpret_cast<const MeshOptimizer::Meshlet*>(data + header.meshlets.offset);
+	mesh.meshletVertices = reinterpret_cast<const uint32_t*>(data + header.meshletVertices.offset);
+	mesh.meshletTriangles = data + header.meshletTriangles.offset;
+
+	size_t indexCount = header.indices.size / sizeof(uint32_t);
+	for (uint32_t lod = 0; lod < header.lodCount; ++lod)
+	{
+		const LOD& range = mesh.lods[lod];
+		if (size_t(range.indexOffset) + range.indexCount > indexCount || size_t(range.meshletOffset) + range.meshletCount > header.meshletCount) return false;
+	}
+	return true;
+}
+
+bool MeshFile::load(const std::string& file, Mesh& mesh)
+{
+	std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(file);
+	if (!mapping->isOpen() || !parse(mapping->data(), mapping->getSize(), mesh)) return false;
+	mesh.file = mapping;
+	return true;
+}
+
+GeometryData MeshFile::toGeometryData(const Mesh& mesh, unsigned int lod)
+{
+	const LOD& range = mesh.lods[std::min(lod, mesh.header.lodCount - 1)];
+	GeometryData geometry;
+	geometry.positions.assign(mesh.positions, mesh.positions + mesh.header.vertexCount);
+	geometry.normals.assign(mesh.normals, mesh.normals + mesh.header.vertexCount);
+	geometry.uv.assign(mesh.uv, mesh.uv + mesh.header.vertexCount);
+	geometry.indices.assign(mesh.indices + range.indexOffset, mesh.indices + range.indexOffset + range.indexCount);
+	geometry.track();
+	return geometry;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "MappedFile.h"
+#include "SectionFile.h"
+
+/*
+ Cooked '.mesh' file, laid out to be memory mapped and uploaded without conversion:
+ a header followed by sections at aligned offsets. Vertex streams have the layout of the
+ Geometry buffers (vec3 positions, vec3 normals, vec2 uvs, 32 bit indices). Every level of detail
+ is a range of the shared index buffer and of the meshlet list, level 0 is the full mesh.
+*/
+namespace MeshFile
+{
+	const uint32_t version = 2;
+	using SectionFile::alignment;
+	using SectionFile::Section;
+	const unsigned int maxLodCount = 4;
+
+	struct LOD {
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		uint32_t meshletOffset;
+		uint32_t meshletCount;
+		//size of the merged cells in object space, 0 for the full mesh
+		float error;
+		uint32_t padding[3];
+	};
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		uint32_t meshletCount;
+		float boundsMin[3];
+		float boundsMax[3];
+		Section positions;
+		Section normals;
+		Section uv;
+		Section indices;
+		Section lods;
+		Section meshlets;
+		Section meshletVertices;
+		Section meshletTriangles;
+	};
+
+	//a parsed file, the pointers point into the mapping
+	struct Mesh {
+		Header header;
+		const glm::vec3* positions = nullptr;
+		const glm::vec3* normals = nullptr;
+		const glm::vec2* uv = nullptr;
+		const uint32_t* indices = nullptr;
+		const LOD* lods = nullptr;
+		const MeshOptimizer::Meshlet* meshlets = nullptr;
+		const uint32_t* meshletVertices = nullptr;
+		const uint8_t* meshletTriangles = nullptr;
+		std::shared_ptr<MappedFile> file;
+	};
+
+	/*!
+	 * Writes a mesh with generated levels of detail and meshlets. The geometry should already
+	 * be optimized for the vertex cache and fetch, coarser levels are optimized here.
+	 * @return false if the file could not be written
+	 */
+	bool save(const std::string& file, const GeometryData& geometry, unsigned int lodCount = maxLodCount);
+
+	/*!
+	 * Validates a file in memory and points the sections into it
+	 * @return false if the data is truncated, misaligned or of another version
+	 */
+	bool parse(const unsigned char* data, size_t size, Mesh& mesh);
+
+	/*!
+	 * Memory maps and parses a file, nothing is read until the sections are used
+	 * @return false if the file is missing or invalid
+	 */
+	bool load(const std::string& file, Mesh& mesh);
+
+	//copies one level of detail, used where GeometryData is needed
+	GeometryData toGeometryData(const Mesh& mesh, unsigned int lod = 0);
+}
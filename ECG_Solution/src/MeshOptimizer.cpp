@@ -0,0 +1,325 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+	float vertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0) return -1.0f;
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			//the last triangle's vertices get a fixed score so it isn't simply repeated
+			if (cachePosition < 3) score = 0.75f;
+			else score = std::pow(1.0f - float(cachePosition - 3) / (MeshOptimizer::cacheSize - 3), 1.5f);
+		}
+		//vertices with few triangles left are finished first
+		return score + 2.0f / std::sqrt(float(remainingTriangles));
+	}
+}
+
+std::vector<unsigned int> MeshOptimizer::optimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (unsigned int index : indices)
+	{
+		++remaining[index];
+	}
+	//triangles of each vertex, the first remaining[v] entries from offsets[v] are not emitted yet
+	std::vector<size_t> offsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+	}
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			adjacency[fill[indices[triangle * 3 + corner]]++] = (unsigned int)triangle;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		scores[vertex] = vertexScore(-1, remaining[vertex]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		triangleScores[triangle] = scores[indices[triangle * 3]] + scores[indices[triangle * 3 + 1]] + scores[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	std::vector<unsigned int> cache, newCache;
+	size_t scanPosition = 0;
+	long long best = -1;
+	for (size_t count = 0; count < triangleCount; ++count)
+	{
+		if (best < 0)
+		{
+			//nothing connected in the cache, continue with the next triangle in input order
+			while (emitted[scanPosition]) ++scanPosition;
+			best = (long long)scanPosition;
+		}
+		size_t triangle = size_t(best);
+		emitted[triangle] = true;
+
+		newCache.clear();
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			unsigned int vertex = indices[triangle * 3 + corner];
+			result.push_back(vertex);
+			newCache.push_back(vertex);
+			//remove the triangle from the vertex' remaining ones
+			size_t begin = offsets[vertex], end = begin + remaining[vertex];
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (adjacency[i] == triangle)
+				{
+					std::swap(adjacency[i], adjacency[end - 1]);
+					break;
+				}
+			}
+			--remaining[vertex];
+		}
+		for (unsigned int vertex : cache)
+		{
+			if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end()) newCache.push_back(vertex);
+		}
+		for (size_t i = cacheSize; i < newCache.size(); ++i)
+		{
+			cachePosition[newCache[i]] = -1;
+			scores[newCache[i]] = vertexScore(-1, remaining[newCache[i]]);
+		}
+		if (newCache.size() > size_t(cacheSize))
+		{
+			std::vector<unsigned int> evicted(newCache.begin() + cacheSize, newCache.end());
+			newCache.resize(cacheSize);
+			for (unsigned int vertex : evicted)
+			{
+				for (size_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; ++i)
+				{
+					unsigned int t = adjacency[i];
+					triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+				}
+			}
+		}
+		cache.swap(newCache);
+
+		//rescore the cached vertices and their triangles, the best of those is next
+		for (size_t i = 0; i < cache.size(); ++i)
+		{
+			cachePosition[cache[i]] = int(i);
+			scores[cache[i]] = vertexScore(int(i), remaining[cache[i]]);
+		}
+		best = -1;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : cache)
+		{
+			for (size_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; ++i)
+			{
+				unsigned int t = adjacency[i];
+				triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void MeshOptimizer::optimizeVertexFetch(GeometryData& geometry)
+{
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(geometry.positions.size(), unused);
+	unsigned int next = 0;
+	for (unsigned int& index : geometry.indices)
+	{
+		if (remap[index] == unused) remap[index] = next++;
+		index = remap[index];
+	}
+
+	GeometryData reordered;
+	reordered.positions.resize(next);
+	reordered.normals.resize(next);
+	reordered.uv.resize(next);
+	for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+	{
+		if (remap[vertex] == unused) continue;
+		reordered.positions[remap[vertex]] = geometry.positions[vertex];
+		if (vertex < geometry.normals.size()) reordered.normals[remap[vertex]] = geometry.normals[vertex];
+		if (vertex < geometry.uv.size()) reordered.uv[remap[vertex]] = geometry.uv[vertex];
+	}
+	geometry.positions.swap(reordered.positions);
+	geometry.normals.swap(reordered.normals);
+	geometry.uv.swap(reordered.uv);
+	geometry.track();
+}
+
+float MeshOptimizer::averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount, int fifoSize)
+{
+	if (indices.empty()) return 0.0f;
+	//time stamp of the vertex' last transform, in cache while fewer than fifoSize misses happened since
+	std::vector<long long> loaded(vertexCount, -(long long)fifoSize - 1);
+	long long misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (misses - loaded[index] > fifoSize)
+		{
+			loaded[index] = misses++;
+		}
+	}
+	return float(misses) / (indices.size() / 3);
+}
+
+void MeshOptimizer::computeNormals(GeometryData& geometry)
+{
+	geometry.normals.assign(geometry.positions.size(), glm::vec3(0.0f));
+	for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+	{
+		glm::vec3 a = geometry.positions[geometry.indices[i]], b = geometry.positions[geometry.indices[i + 1]], c = geometry.positions[geometry.indices[i + 2]];
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		for (int corner = 0; corner < 3; ++corner) geometry.normals[geometry.indices[i + corner]] += normal;
+	}
+	for (glm::vec3& normal : geometry.normals)
+	{
+		float length = glm::length(normal);
+		normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+	geometry.track();
+}
+
+std::vector<unsigned int> MeshOptimizer::simplifyClusters(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, float cellSize)
+{
+	if (positions.empty() || cellSize <= 0.0f) return indices;
+	glm::vec3 boundsMin = positions[0];
+	for (const glm::vec3& position : positions)
+	{
+		boundsMin = glm::min(boundsMin, position);
+	}
+
+	//cell of every vertex and the vertex closest to each cell's center
+	std::vector<uint64_t> cells(positions.size());
+	std::unordered_map<uint64_t, unsigned int> representatives;
+	representatives.reserve(positions.size() / 4);
+	for (size_t vertex = 0; vertex < positions.size(); ++vertex)
+	{
+		glm::vec3 cell = glm::floor((positions[vertex] - boundsMin) / cellSize);
+		uint64_t key = uint64_t(cell.x) | uint64_t(cell.y) << 21 | uint64_t(cell.z) << 42;
+		cells[vertex] = key;
+		auto found = representatives.emplace(key, (unsigned int)vertex);
+		if (!found.second)
+		{
+			glm::vec3 center = boundsMin + (cell + 0.5f) * cellSize;
+			unsigned int current = found.first->second;
+			if (glm::length(positions[vertex] - center) < glm::length(positions[current] - center)) found.first->second = (unsigned int)vertex;
+		}
+	}
+
+	std::vector<unsigned int> result;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		unsigned int a = representatives[cells[indices[i]]], b = representatives[cells[indices[i + 1]]], c = representatives[cells[indices[i + 2]]];
+		if (a == b || b == c || a == c) continue;
+		result.push_back(a);
+		result.push_back(b);
+		result.push_back(c);
+	}
+	return result;
+}
+
+void MeshOptimizer::buildMeshlets(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+	std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles)
+{
+	//local index of each vertex in the current meshlet
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> local(positions.size(), unused);
+	Meshlet meshlet = {};
+	meshlet.vertexOffset = uint32_t(meshletVertices.size());
+	meshlet.triangleOffset = uint32_t(meshletTriangles.size());
+
+	auto finish = [&]() {
+		if (meshlet.triangleCount == 0) return;
+		glm::vec3 boundsMin = positions[meshletVertices[meshlet.vertexOffset]], boundsMax = boundsMin;
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+		{
+			unsigned int vertex = meshletVertices[meshlet.vertexOffset + i];
+			boundsMin = glm::min(boundsMin, positions[vertex]);
+			boundsMax = glm::max(boundsMax, positions[vertex]);
+			local[vertex] = unused;
+		}
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius = 0.0f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+		{
+			radius = std::max(radius, glm::length(positions[meshletVertices[meshlet.vertexOffset + i]] - center));
+		}
+
+		std::vector<glm::vec3> normals(meshlet.triangleCount);
+		glm::vec3 axis(0.0f);
+		for (uint32_t triangle = 0; triangle < meshlet.triangleCount; ++triangle)
+		{
+			const uint8_t* corners = &meshletTriangles[meshlet.triangleOffset + triangle * 3];
+			glm::vec3 a = positions[meshletVertices[meshlet.vertexOffset + corners[0]]];
+			glm::vec3 b = positions[meshletVertices[meshlet.vertexOffset + corners[1]]];
+			glm::vec3 c = positions[meshletVertices[meshlet.vertexOffset + corners[2]]];
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float length = glm::length(normal);
+			normals[triangle] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+			axis += normals[triangle];
+		}
+		float axisLength = glm::length(axis);
+		axis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+		float cutoff = axisLength > 0.0f ? 1.0f : -1.0f;
+		for (const glm::vec3& normal : normals)
+		{
+			cutoff = std::min(cutoff, glm::dot(axis, normal));
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			meshlet.center[i] = center[i];
+			meshlet.coneAxis[i] = axis[i];
+		}
+		meshlet.radius = radius;
+		meshlet.coneCutoff = cutoff;
+		meshlets.push_back(meshlet);
+		meshlet = {};
+		meshlet.vertexOffset = uint32_t(meshletVertices.size());
+		meshlet.triangleOffset = uint32_t(meshletTriangles.size());
+	};
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		unsigned int added = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			added += local[indices[i + corner]] == unused;
+		}
+		if (meshlet.vertexCount + added > maxMeshletVertices || meshlet.triangleCount == maxMeshletTriangles) finish();
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			unsigned int vertex = indices[i + corner];
+			if (local[vertex] == unused)
+			{
+				local[vertex] = meshlet.vertexCount++;
+				meshletVertices.push_back(vertex);
+			}
+			meshletTriangles.push_back(uint8_t(local[vertex]));
+		}
+		++meshlet.triangleCount;
+	}
+	finish();
+}
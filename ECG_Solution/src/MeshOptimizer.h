@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Geometry.h"
+
+/*
+ Index and vertex reordering for the post transform cache and vertex fetch,
+ level of detail generation and meshlet clustering
+*/
+namespace MeshOptimizer
+{
+	static const int cacheSize = 32;
+	static const unsigned int maxMeshletVertices = 64;
+	static const unsigned int maxMeshletTriangles = 124;
+
+	//a cluster of triangles using few vertices, with bounds for culling
+	struct Meshlet {
+		//first entry in the meshlet vertex list, the local triangle indices refer to those
+		uint32_t vertexOffset;
+		//first local index in the meshlet triangle list, 3 per triangle
+		uint32_t triangleOffset;
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+		float center[3];
+		float radius;
+		//every triangle normal is within the cone, the cutoff is the smallest cosine and negative if no cone fits
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	//triangle order after Forsyth's linear-speed vertex cache optimization
+	std::vector<unsigned int> optimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount);
+	//orders vertices by first use in the index buffer
+	void optimizeVertexFetch(GeometryData& geometry);
+	//average transformed vertices per triangle for a FIFO cache, 0.5 is ideal, 3 the worst
+	float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount, int fifoSize = 16);
+	//area weighted vertex normals from the triangles
+	void computeNormals(GeometryData& geometry);
+
+	/*!
+	 * Simplifies by vertex clustering, vertices in the same cell of a uniform grid are merged into the one
+	 * closest to the cell center and collapsed triangles are dropped. The vertices are kept, only indices change.
+	 * @param cellSize: edge length of the grid cells, the geometric error of the result
+	 */
+	std::vector<unsigned int> simplifyClusters(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, float cellSize);
+
+	//splits the triangles in input order into meshlets, appending to the lists
+	void buildMeshlets(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+		std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles);
+}
@@ -0,0 +1,38 @@
+#include "ModelImporter.h"
+#include "OBJFile.h"
+#include "GLTFFile.h"
+#include <iostream>
+
+bool importModel(const std::string& file, ImportedModel& model, const ImportSettings& settings)
+{
+	size_t dot = file.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : file.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	if (extension == ".obj") return importOBJ(file, model, settings);
+	if (extension == ".gltf" || extension == ".glb") return importGLTF(file, model, settings);
+	std::cout << "Unknown model format " << file << std::endl;
+	return false;
+}
+
+GeometryData mergeMeshes(const ImportedModel& model)
+{
+	GeometryData merged;
+	for (const GeometryData& mesh : model.meshes)
+	{
+		unsigned int base = (unsigned int)merged.positions.size();
+		merged.positions.insert(merged.positions.end(), mesh.positions.begin(), mesh.positions.end());
+		merged.normals.insert(merged.normals.end(), mesh.normals.begin(), mesh.normals.end());
+		merged.uv.insert(merged.uv.end(), mesh.uv.begin(), mesh.uv.end());
+		for (unsigned int index : mesh.indices)
+		{
+			merged.indices.push_back(base + index);
+		}
+	}
+	merged.track();
+	return merged;
+}
+
+unsigned int importThreadCount(const ImportSettings& settings)
+{
+	return settings.threadCount > 0 ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+}
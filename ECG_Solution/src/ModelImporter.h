@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "JobSystem.h"
+
+//metallic roughness parameters of an imported material, the base color is linear
+struct ImportedMaterial {
+	std::string name;
+	glm::vec3 baseColor = glm::vec3(0.8f);
+	float metallic = 0.0f;
+	float roughness = 0.5f;
+	//path of the base color texture, empty if there is none
+	std::string baseColorTexture;
+};
+
+//meshes are split by material, a material of -1 means none was assigned
+struct ImportedModel {
+	std::vector<GeometryData> meshes;
+	std::vector<int> meshMaterials;
+	std::vector<ImportedMaterial> materials;
+	//bytes of source files parsed
+	size_t sourceSize = 0;
+};
+
+struct ImportSettings {
+	//parser threads, 0 for one per hardware thread
+	unsigned int threadCount = 0;
+	//reads '.obj' files block by block instead of mapping them whole, for files larger than the address space or memory
+	bool streaming = false;
+	size_t blockSize = 64 * 1024 * 1024;
+};
+
+/*!
+ * Imports a '.obj' (with its '.mtl' libraries) or glTF 2.0 '.gltf'/'.glb' file, chosen by extension
+ * @return false if the file is missing, malformed or has no triangles
+ */
+bool importModel(const std::string& file, ImportedModel& model, const ImportSettings& settings = ImportSettings());
+
+//all meshes in one, for users that don't need the materials
+GeometryData mergeMeshes(const ImportedModel& model);
+
+//threads used for settings.threadCount
+unsigned int importThreadCount(const ImportSettings& settings);
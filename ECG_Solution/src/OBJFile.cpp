@@ -0,0 +1,489 @@
+#include "OBJFile.h"
+#include "MeshOptimizer.h"
+#include "MappedFile.h"
+#include <fstream>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	struct VertexKey {
+		int position;
+		int uv;
+		int normal;
+		int material;
+		bool operator==(const VertexKey& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal && material == other.material;
+		}
+	};
+
+	struct VertexKeyHash {
+		size_t operator()(const VertexKey& key) const
+		{
+			return size_t(key.position) * 73856093u ^ size_t(key.uv) * 19349663u ^ size_t(key.normal) * 83492791u ^ size_t(key.material) * 2654435761u;
+		}
+	};
+
+	//a face corner as written: 0 based, -1 if absent, or counted from the chunk's first vertex if its relative bit is set
+	struct Corner {
+		int position;
+		int uv;
+		int normal;
+		uint8_t relative;
+	};
+
+	const uint8_t relativePosition = 1, relativeUV = 2, relativeNormal = 4;
+
+	//a range of whole lines, parsed independently of the others
+	struct Chunk {
+		const char* begin;
+		const char* end;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		//three per triangle
+		std::vector<Corner> corners;
+		//'usemtl' names and the first corner using them
+		std::vector<std::pair<size_t, std::string>> materialSwitches;
+		std::vector<std::string> libraries;
+		//material of each run of corners, resolved after parsing
+		std::vector<std::pair<size_t, int>> materialRuns;
+		//unique vertices of the chunk and the corners as indices into them
+		std::vector<VertexKey> vertices;
+		std::vector<unsigned int> indices;
+		bool valid = true;
+	};
+
+	bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	bool isDigit(char c)
+	{
+		return (unsigned char)(c - '0') < 10;
+	}
+
+	const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && isSpace(*p)) ++p;
+		return p;
+	}
+
+	const char* parseInt(const char* p, const char* end, int& value)
+	{
+		bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+')) ++p;
+		int result = 0;
+		while (p < end && isDigit(*p)) result = result * 10 + (*p++ - '0');
+		value = negative ? -result : result;
+		return p;
+	}
+
+	//faster than strtod/streams and locale independent, exact to float precision for the usual short decimals
+	const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		p = skipSpaces(p, end);
+		bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+')) ++p;
+		double result = 0.0;
+		while (p < end && isDigit(*p)) result = result * 10.0 + (*p++ - '0');
+		if (p < end && *p == '.')
+		{
+			++p;
+			double scale = 1.0;
+			while (p < end && isDigit(*p))
+			{
+				scale *= 0.1;
+				result += (*p++ - '0') * scale;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			int exponent;
+			p = parseInt(p + 1, end, exponent);
+			result *= std::pow(10.0, exponent);
+		}
+		value = float(negative ? -result : result);
+		return p;
+	}
+
+	bool startsWith(const char* line, const char* end, const char* keyword)
+	{
+		size_t length = std::strlen(keyword);
+		return size_t(end - line) > length && std::memcmp(line, keyword, length) == 0 && isSpace(line[length]);
+	}
+
+	std::string restOfLine(const char* p, const char* end)
+	{
+		p = skipSpaces(p, end);
+		while (end > p && isSpace(end[-1])) --end;
+		return std::string(p, end);
+	}
+
+	int encodeIndex(int value, size_t count, uint8_t bit, Corner& corner)
+	{
+		if (value > 0) return value - 1;
+		if (value == 0) return -1;
+		corner.relative |= bit;
+		return int(count) + value;
+	}
+
+	void parseChunk(Chunk& chunk)
+	{
+		std::vector<Corner> face;
+		const char* p = chunk.begin;
+		while (p < chunk.end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(chunk.end - p)));
+			if (lineEnd == nullptr) lineEnd = chunk.end;
+			const char* line = skipSpaces(p, lineEnd);
+			p = lineEnd + 1;
+			if (lineEnd - line < 2) continue;
+
+			if (line[0] == 'v' && isSpace(line[1]))
+			{
+				glm::vec3 position;
+				const char* q = parseFloat(line + 1, lineEnd, position.x);
+				q = parseFloat(q, lineEnd, position.y);
+				parseFloat(q, lineEnd, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if (line[0] == 'v' && line[1] == 't')
+			{
+				glm::vec2 uv;
+				parseFloat(parseFloat(line + 2, lineEnd, uv.x), lineEnd, uv.y);
+				chunk.uvs.push_back(uv);
+			}
+			else if (line[0] == 'v' && line[1] == 'n')
+			{
+				glm::vec3 normal;
+				const char* q = parseFloat(line + 2, lineEnd, normal.x);
+				q = parseFloat(q, lineEnd, normal.y);
+				parseFloat(q, lineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if (line[0] == 'f' && isSpace(line[1]))
+			{
+				//v, v/vt, v//vn or v/vt/vn
+				face.clear();
+				const char* q = line + 1;
+				while (true)
+				{
+					q = skipSpaces(q, lineEnd);
+					if (q >= lineEnd || *q == '#') break;
+					int position = 0, uv = 0, normal = 0;
+					q = parseInt(q, lineEnd, position);
+					if (q < lineEnd && *q == '/')
+					{
+						if (++q < lineEnd && *q != '/') q = parseInt(q, lineEnd, uv);
+						if (q < lineEnd && *q == '/') q = parseInt(q + 1, lineEnd, normal);
+					}
+					while (q < lineEnd && !isSpace(*q)) ++q;
+
+					Corner corner;
+					corner.relative = 0;
+					corner.position = encodeIndex(position, chunk.positions.size(), relativePosition, corner);
+					corner.uv = encodeIndex(uv, chunk.uvs.size(), relativeUV, corner);
+					corner.normal = encodeIndex(normal, chunk.normals.size(), relativeNormal, corner);
+					face.push_back(corner);
+				}
+				for (size_t i = 2; i < face.size(); ++i)
+				{
+					chunk.corners.push_back(face[0]);
+					chunk.corners.push_back(face[i - 1]);
+					chunk.corners.push_back(face[i]);
+				}
+			}
+			else if (startsWith(line, lineEnd, "usemtl"))
+			{
+				chunk.materialSwitches.emplace_back(chunk.corners.size(), restOfLine(line + 6, lineEnd));
+			}
+			else if (startsWith(line, lineEnd, "mtllib"))
+			{
+				chunk.libraries.push_back(restOfLine(line + 6, lineEnd));
+			}
+		}
+	}
+
+	//accumulates the parsed blocks of one file into the model
+	class OBJImporter
+	{
+	public:
+		OBJImporter(const std::string& file, ImportedModel& model, unsigned int threadCount)
+			: directory(file.substr(0, file.find_last_of("/\\") + 1)), model(model), threadCount(threadCount) {}
+
+		bool parseBlock(const char* begin, const char* end)
+		{
+			//a few chunks per thread so uneven chunks still balance, small blocks aren't split much
+			const size_t minimumChunkSize = 256 * 1024;
+			size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount * 4, size_t(end - begin) / minimumChunkSize));
+			std::vector<Chunk> chunks(chunkCount);
+			const char* chunkBegin = begin;
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				const char* chunkEnd = i + 1 == chunkCount ? end : begin + size_t(uint64_t(end - begin) * (i + 1) / chunkCount);
+				if (chunkEnd < chunkBegin) chunkEnd = chunkBegin;
+				while (chunkEnd < end && (chunkEnd == begin || chunkEnd[-1] != '\n')) ++chunkEnd;
+				chunks[i].begin = chunkBegin;
+				chunks[i].end = chunkEnd;
+				chunkBegin = chunkEnd;
+			}
+			parallelFor(chunks.size(), threadCount, [&](size_t i) { parseChunk(chunks[i]); });
+
+			//vertex offsets of the chunks and the materials in effect
+			std::vector<size_t> positionBase(chunks.size()), uvBase(chunks.size()), normalBase(chunks.size());
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				Chunk& chunk = chunks[i];
+				positionBase[i] = positions.size();
+				uvBase[i] = uvs.size();
+				normalBase[i] = normals.size();
+				positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+				uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+				normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+				std::vector<glm::vec3>().swap(chunk.positions);
+				std::vector<glm::vec2>().swap(chunk.uvs);
+				std::vector<glm::vec3>().swap(chunk.normals);
+
+				for (const std::string& library : chunk.libraries)
+				{
+					loadLibrary(library);
+				}
+				chunk.materialRuns.emplace_back(0, currentMaterial);
+				for (const std::pair<size_t, std::string>& materialSwitch : chunk.materialSwitches)
+				{
+					currentMaterial = materialId(materialSwitch.second);
+					chunk.materialRuns.emplace_back(materialSwitch.first, currentMaterial);
+				}
+			}
+
+			parallelFor(chunks.size(), threadCount, [&](size_t i) {
+				deduplicate(chunks[i], int(positionBase[i]), int(uvBase[i]), int(normalBase[i]));
+			});
+
+			for (Chunk& chunk : chunks)
+			{
+				if (!chunk.valid) return false;
+				merge(chunk);
+			}
+			return true;
+		}
+
+		bool finish()
+		{
+			for (size_t mesh = 0; mesh < model.meshes.size(); ++mesh)
+			{
+				if (missingNormals[mesh]) MeshOptimizer::computeNormals(model.meshes[mesh]);
+				model.meshes[mesh].track();
+			}
+			return !model.meshes.empty();
+		}
+
+	private:
+		std::string directory;
+		ImportedModel& model;
+		unsigned int threadCount;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::unordered_map<std::string, int> materialIds;
+		std::vector<std::string> libraries;
+		int currentMaterial = -1;
+		//mesh of each material, -1 included
+		std::unordered_map<int, size_t> meshes;
+		std::vector<bool> missingNormals;
+		//the index of every vertex in its material's mesh
+		std::unordered_map<VertexKey, unsigned int, VertexKeyHash> vertices;
+
+		int materialId(const std::string& name)
+		{
+			auto found = materialIds.find(name);
+			if (found != materialIds.end()) return found->second;
+			//used but not defined, keeps the default parameters
+			ImportedMaterial material;
+			material.name = name;
+			model.materials.push_back(material);
+			return materialIds[name] = int(model.materials.size()) - 1;
+		}
+
+		void loadLibrary(const std::string& library)
+		{
+			if (std::find(libraries.begin(), libraries.end(), library) != libraries.end()) return;
+			libraries.push_back(library);
+			std::ifstream in(directory + library);
+			if (!in)
+			{
+				std::cout << "Missing material library " << directory + library << std::endl;
+				return;
+			}
+			ImportedMaterial* material = nullptr;
+			//'Pr' takes precedence over the Phong exponent
+			bool roughnessGiven = false;
+			std::string line;
+			while (std::getline(in, line))
+			{
+				const char* begin = line.c_str();
+				const char* end = begin + line.size();
+				begin = skipSpaces(begin, end);
+				if (startsWith(begin, end, "newmtl"))
+				{
+					material = &model.materials[materialId(restOfLine(begin + 6, end))];
+					roughnessGiven = false;
+				}
+				else if (material == nullptr)
+				{
+					continue;
+				}
+				else if (startsWith(begin, end, "Kd"))
+				{
+					const char* q = parseFloat(begin + 2, end, material->baseColor.r);
+					q = parseFloat(q, end, material->baseColor.g);
+					parseFloat(q, end, material->baseColor.b);
+				}
+				else if (startsWith(begin, end, "Pm"))
+				{
+					parseFloat(begin + 2, end, material->metallic);
+				}
+				else if (startsWith(begin, end, "Pr"))
+				{
+					parseFloat(begin + 2, end, material->roughness);
+					roughnessGiven = true;
+				}
+				else if (startsWith(begin, end, "Ns") && !roughnessGiven)
+				{
+					//Blinn-Phong exponent to GGX roughness
+					float exponent;
+					parseFloat(begin + 2, end, exponent);
+					material->roughness = std::sqrt(2.0f / (std::max(exponent, 0.0f) + 2.0f));
+				}
+				else if (startsWith(begin, end, "map_Kd"))
+				{
+					material->baseColorTexture = directory + restOfLine(begin + 6, end);
+				}
+			}
+		}
+
+		void deduplicate(Chunk& chunk, int positionBase, int uvBase, int normalBase)
+		{
+			auto resolve = [](int value, bool relative, int base, size_t count) {
+				if (relative) value += base;
+				return value >= 0 && size_t(value) < count ? value : -1;
+			};
+			std::unordered_map<VertexKey, unsigned int, VertexKeyHash> local;
+			local.reserve(chunk.corners.size() / 4);
+			chunk.indices.resize(chunk.corners.size());
+			size_t run = 0;
+			for (size_t i = 0; i < chunk.corners.size(); ++i)
+			{
+				while (run + 1 < chunk.materialRuns.size() && chunk.materialRuns[run + 1].first <= i) ++run;
+				const Corner& corner = chunk.corners[i];
+				VertexKey key;
+				key.position = resolve(corner.position, (corner.relative & relativePosition) != 0, positionBase, positions.size());
+				key.uv = resolve(corner.uv, (corner.relative & relativeUV) != 0, uvBase, uvs.size());
+				key.normal = resolve(corner.normal, (corner.relative & relativeNormal) != 0, normalBase, normals.size());
+				key.material = chunk.materialRuns[run].second;
+				if (key.position < 0)
+				{
+					chunk.valid = false;
+					return;
+				}
+				auto found = local.emplace(key, (unsigned int)chunk.vertices.size());
+				if (found.second) chunk.vertices.push_back(key);
+				chunk.indices[i] = found.first->second;
+			}
+			std::vector<Corner>().swap(chunk.corners);
+		}
+
+		void merge(const Chunk& chunk)
+		{
+			std::vector<unsigned int> remap(chunk.vertices.size());
+			std::vector<size_t> meshOf(chunk.vertices.size());
+			for (size_t i = 0; i < chunk.vertices.size(); ++i)
+			{
+				const VertexKey& key = chunk.vertices[i];
+				auto mesh = meshes.find(key.material);
+				if (mesh == meshes.end())
+				{
+					mesh = meshes.emplace(key.material, model.meshes.size()).first;
+					model.meshes.emplace_back();
+					model.meshMaterials.push_back(key.material);
+					missingNormals.push_back(false);
+				}
+				GeometryData& geometry = model.meshes[mesh->second];
+				meshOf[i] = mesh->second;
+				auto found = vertices.emplace(key, (unsigned int)geometry.positions.size());
+				if (found.second)
+				{
+					geometry.positions.push_back(positions[key.position]);
+					geometry.uv.push_back(key.uv >= 0 ? uvs[key.uv] : glm::vec2(0.0f));
+					geometry.normals.push_back(key.normal >= 0 ? normals[key.normal] : glm::vec3(0.0f));
+					if (key.normal < 0) missingNormals[mesh->second] = true;
+				}
+				remap[i] = found.first->second;
+			}
+			for (unsigned int index : chunk.indices)
+			{
+				model.meshes[meshOf[index]].indices.push_back(remap[index]);
+			}
+		}
+	};
+}
+
+bool importOBJ(const std::string& file, ImportedModel& model, const ImportSettings& settings)
+{
+	model = ImportedModel();
+	OBJImporter importer(file, model, importThreadCount(settings));
+	if (!settings.streaming)
+	{
+		MappedFile mapping(file);
+		if (!mapping.isOpen()) return false;
+		model.sourceSize = mapping.getSize();
+		const char* text = reinterpret_cast<const char*>(mapping.data());
+		return importer.parseBlock(text, text + mapping.getSize()) && importer.finish();
+	}
+
+	std::ifstream in(file, std::ios::binary | std::ios::ate);
+	if (!in) return false;
+	//no larger than the file, so small files don't pay for clearing a whole block
+	size_t fileSize = size_t(in.tellg());
+	in.seekg(0);
+	std::vector<char> block(std::max<size_t>(std::min(settings.blockSize, fileSize + 1), 4096));
+	size_t filled = 0;
+	while (true)
+	{
+		in.read(block.data() + filled, block.size() - filled);
+		size_t read = size_t(in.gcount());
+		filled += read;
+		model.sourceSize += read;
+		bool last = !in;
+		//only whole lines are parsed, the rest moves to the front for the next block
+		size_t parsed = filled;
+		if (!last)
+		{
+			while (parsed > 0 && block[parsed - 1] != '\n') --parsed;
+			if (parsed == 0)
+			{
+				//a line longer than the block
+				block.resize(block.size() * 2);
+				continue;
+			}
+		}
+		if (!importer.parseBlock(block.data(), block.data() + parsed)) return false;
+		std::memmove(block.data(), block.data() + parsed, filled - parsed);
+		filled -= parsed;
+		if (last) break;
+	}
+	return importer.finish();
+}
+
+bool loadOBJ(const std::string& file, GeometryData& geometry)
+{
+	ImportedModel model;
+	if (!importOBJ(file, model)) return false;
+	geometry = mergeMeshes(model);
+	return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include "Geometry.h"
+#include "ModelImporter.h"
+
+/*!
+ * Loads the triangles of a Wavefront '.obj' file (v, vt, vn, f), polygons are triangulated as fans
+ * and vertices with the same position/uv/normal triple are shared. Missing normals are computed.
+ * @return false if the file is missing or has no faces
+ */
+bool loadOBJ(const std::string& file, GeometryData& geometry);
+
+/*!
+ * Imports a '.obj' file split by 'usemtl' material, with the materials of its 'mtllib' files (Kd, Ns or Pr/Pm, map_Kd).
+ * The text is cut into chunks at line ends and parsed on settings.threadCount threads, vertices are then
+ * deduplicated per chunk and merged through one hash map. Without streaming the whole file is mapped,
+ * with streaming it is read block by block and only one block of text is in memory.
+ * Vertices have to be defined before the faces using them, as the format requires.
+ * @return false if the file is missing, a face uses an undefined vertex or there are no faces
+ */
+bool importOBJ(const std::string& file, ImportedModel& model, const ImportSettings& settings = ImportSettings());
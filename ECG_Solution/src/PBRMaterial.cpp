@@ -1,11 +1,12 @@
 #include "PBRMaterial.h"
+#include <glm/gtc/color_space.hpp>
 
 /*
 ; Random Material
 */
 PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader,glm::vec3 baseColor):Material(shader)
 {
-	this->baseColor = baseColor;
+	this->baseColor = glm::convertSRGBToLinear(baseColor);
 	std::random_device rd;
 	std::mt19937 rng(rd());
 	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
@@ -22,7 +23,7 @@ PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader,glm::vec3 baseColor):Mat
 
 PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor, float metallic, float roughness) :Material(shader)
 {
-	this->baseColor = baseColor;
+	this->baseColor = glm::convertSRGBToLinear(baseColor);
 	std::random_device rd;
 	std::mt19937 rng(rd());
 	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
@@ -42,7 +43,7 @@ PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor, fl
 */
 PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor, float ambient, float metallic, float specular, float specularTint, float roughness, float anisotropic, float sheen, float sheenTint, float clearcoat, float clearcoatGloss) :Material(shader)
 {
-	this->baseColor = baseColor;
+	this->baseColor = glm::convertSRGBToLinear(baseColor);
 	this->ambient = ambient;
 	this->metallic = metallic;
 	this->specular = specular;
@@ -54,21 +55,50 @@ PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor, fl
 	this->cleatcoatGloss = clearcoatGloss;
 }
 
+/*
+	Parameters of an imported model, the remaining coefficients are off
+*/
+PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, const ImportedMaterial& material) :Material(shader)
+{
+	this->baseColor = material.baseColor;
+	this->ambient = 0.1f;
+	this->metallic = material.metallic;
+	this->specular = 0.5f;
+	this->specularTint = 0.0f;
+	this->roughness = material.roughness;
+	this->sheen = 0.0f;
+	this->sheenTint = 0.0f;
+	this->clearcoat = 0.0f;
+	this->cleatcoatGloss = 0.0f;
+}
+
 PBRMaterial::~PBRMaterial()
 {
 }
 
+void PBRMaterial::setMaterialUniforms(std::shared_ptr<Shader>& target)
+{
+	target->setUniform("materialCoefficients.baseColor", baseColor);
+	target->setUniform("materialCoefficients.ambient", ambient);
+	target->setUniform("materialCoefficients.metallic", metallic);
+	target->setUniform("materialCoefficients.specular", specular);
+	target->setUniform("materialCoefficients.specularTint", specularTint);
+	target->setUniform("materialCoefficients.roughness", roughness);
+	target->setUniform("materialCoefficients.sheen", sheen);
+	target->setUniform("materialCoefficients.sheenTint", sheenTint);
+	target->setUniform("materialCoefficients.clearcoat", clearcoat);
+	target->setUniform("materialCoefficients.clearcoatGloss", cleatcoatGloss);
+}
+
 void PBRMaterial::setUniforms()
 {
 	shader->use();
-	shader->setUniform("materialCoefficients.baseColor", baseColor);
-	shader->setUniform("materialCoefficients.ambient", ambient);
-	shader->setUniform("materialCoefficients.metallic", metallic);
-	shader->setUniform("materialCoefficients.specularTint", specularTint);
-	shader->setUniform("materialCoefficients.roughness", roughness);
-	shader->setUniform("materialCoefficients.sheen", sheen);
-	shader->setUniform("materialCoefficients.sheenTint", sheenTint);
-	shader->setUniform("materialCoefficients.clearcoat", clearcoat);
-	shader->setUniform("materialCoefficients.cleatcoatGloss", cleatcoatGloss);
+	setMaterialUniforms(shader);
 	shader->unuse();
 }
+
+bool PBRMaterial::setGBufferUniforms(std::shared_ptr<Shader>& gBufferShader)
+{
+	setMaterialUniforms(gBufferShader);
+	return true;
+}
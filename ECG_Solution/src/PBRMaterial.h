@@ -1,12 +1,13 @@
 #pragma once
 #include "Material.h"
+#include "ModelImporter.h"
 #include <random>
 
 class PBRMaterial :
 	public Material
 {
 private:
-	glm::vec3 baseColor;
+	glm::vec3 baseColor; //linear, converted from the sRGB color passed in
 	float ambient;
 	float metallic;
 	float specular;
@@ -16,12 +17,16 @@ private:
 	float sheenTint;
 	float clearcoat;
 	float cleatcoatGloss;
+
+	void setMaterialUniforms(std::shared_ptr<Shader>& target);
 public:
-	PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor);
-	PBRMaterial::PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor,float metallic, float roughness);
+	PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor);
+	PBRMaterial(std::shared_ptr<Shader> shader, glm::vec3 baseColor,float metallic, float roughness);
 	PBRMaterial(std::shared_ptr<Shader> shader,glm::vec3 baseColor, float ambient, float metallic, float specular, float specularTint, float roughness, float anisotropic, float sheen, float sheenTint, float clearcoat, float clearcoatGloss);
+	PBRMaterial(std::shared_ptr<Shader> shader, const ImportedMaterial& material);
 	virtual ~PBRMaterial();
 
 	virtual void setUniforms();
+	virtual bool setGBufferUniforms(std::shared_ptr<Shader>& gBufferShader);
 };
 
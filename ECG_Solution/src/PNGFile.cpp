@@ -0,0 +1,42 @@
+#include "PNGFile.h"
+#include <png.h>
+#include <cstring>
+#include <iostream>
+
+bool loadPNG(const std::string& file, Image& image)
+{
+	png_image png;
+	std::memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&png, file.c_str()))
+	{
+		return false;
+	}
+	png.format = PNG_FORMAT_RGBA;
+	image.width = png.width;
+	image.height = png.height;
+	image.pixels.resize(PNG_IMAGE_SIZE(png));
+	if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+	{
+		std::cout << "Could not decode " << file << ": " << png.message << std::endl;
+		png_image_free(&png);
+		return false;
+	}
+	return true;
+}
+
+bool savePNG(const std::string& file, const Image& image)
+{
+	png_image png;
+	std::memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	png.width = image.width;
+	png.height = image.height;
+	png.format = PNG_FORMAT_RGBA;
+	if (!png_image_write_to_file(&png, file.c_str(), 0, image.pixels.data(), 0, nullptr))
+	{
+		std::cout << "Could not write " << file << ": " << png.message << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include "ImageFile.h"
+
+/*!
+ * Loads a '.png' file as 8 bit RGBA, needs libpng
+ * @return false if the file is missing or can't be decoded
+ */
+bool loadPNG(const std::string& file, Image& image);
+
+/*!
+ * Writes an image as an 8 bit RGBA '.png' file
+ * @return false if the file could not be written
+ */
+bool savePNG(const std::string& file, const Image& image);
@@ -0,0 +1,82 @@
+#include "PipelineStatistics.h"
+
+PipelineStatistics::PipelineStatistics(int tagCount) : current(0), active(false), results(tagCount)
+{
+	supported = GLEW_ARB_pipeline_statistics_query != 0;
+	if (supported)
+	{
+		glGenQueries(queryCount, queries);
+	}
+	for (int i = 0; i < queryCount; ++i)
+	{
+		pending[i] = false;
+		queryTags[i] = 0;
+	}
+}
+
+PipelineStatistics::~PipelineStatistics()
+{
+	if (supported)
+	{
+		glDeleteQueries(queryCount, queries);
+	}
+}
+
+bool PipelineStatistics::isSupported()
+{
+	return supported;
+}
+
+void PipelineStatistics::begin(int tag)
+{
+	if (!supported) return;
+	//slot still in flight, wait for it instead of overwriting the result
+	if (pending[current])
+	{
+		collect(current, true);
+	}
+	queryTags[current] = tag;
+	glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[current]);
+	active = true;
+}
+
+void PipelineStatistics::end()
+{
+	if (!supported || !active) return;
+	glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+	pending[current] = true;
+	active = false;
+	current = (current + 1) % queryCount;
+}
+
+void PipelineStatistics::poll(bool finish)
+{
+	if (!supported) return;
+	for (int i = 0; i < queryCount; ++i)
+	{
+		if (pending[i])
+		{
+			collect(i, finish);
+		}
+	}
+}
+
+void PipelineStatistics::collect(int index, bool wait)
+{
+	if (!wait)
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) return;
+	}
+	GLuint64 invocations = 0;
+	glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &invocations);
+	pending[index] = false;
+	results[queryTags[index]].fragmentInvocations += invocations;
+	++results[queryTags[index]].frames;
+}
+
+PipelineStatistics::Result PipelineStatistics::getResult(int tag)
+{
+	return results[tag];
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+
+/*
+ Counts fragment shader invocations with GL_ARB_pipeline_statistics_query.
+ Results are read back a few frames later so the queries never stall.
+ Every query is tagged (e.g. with the render mode) and results are summed per tag.
+*/
+class PipelineStatistics
+{
+public:
+	struct Result {
+		GLuint64 fragmentInvocations = 0;
+		unsigned long frames = 0;
+	};
+private:
+	static const int queryCount = 4;
+	GLuint queries[queryCount];
+	int queryTags[queryCount];
+	bool pending[queryCount];
+	int current;
+	bool supported;
+	bool active;
+	std::vector<Result> results;
+
+	void collect(int index, bool wait);
+public:
+	PipelineStatistics(int tagCount);
+	~PipelineStatistics();
+
+	bool isSupported();
+	void begin(int tag);
+	void end();
+	//Reads all finished queries, waits for outstanding ones if finish is set
+	void poll(bool finish = false);
+	Result getResult(int tag);
+};
@@ -0,0 +1,310 @@
+#include "Profiler.h"
+#include <chrono>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+	const uint32_t gpuThread = 0xFFFF;
+
+	struct Record {
+		const char* name;
+		int64_t start;
+		int64_t end;
+	};
+
+	//written by its thread, read by Profiler::endFrame
+	struct ThreadRing {
+		uint32_t thread;
+		Record records[Profiler::ringSize];
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+		std::atomic<unsigned long> dropped;
+	};
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::atomic<bool> enabled(true);
+
+	//only locked when a thread records its first zone and when the rings are read
+	std::mutex ringsMutex;
+	std::vector<std::shared_ptr<ThreadRing>> rings;
+	thread_local ThreadRing* localRing = nullptr;
+
+	ThreadRing& getLocalRing()
+	{
+		if (localRing == nullptr)
+		{
+			std::shared_ptr<ThreadRing> ring = std::make_shared<ThreadRing>();
+			ring->head = 0;
+			ring->tail = 0;
+			ring->dropped = 0;
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			ring->thread = uint32_t(rings.size());
+			rings.push_back(ring);
+			localRing = ring.get();
+		}
+		return *localRing;
+	}
+
+	void writeJSONString(std::ostream& out, const std::string& text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\') out << '\\';
+			out << c;
+		}
+		out << '"';
+	}
+}
+
+Profiler::Zone::Zone(const char* name) : name(enabled ? name : nullptr), start(this->name ? now() : 0)
+{
+}
+
+Profiler::Zone::~Zone()
+{
+	if (name == nullptr) return;
+	ThreadRing& ring = getLocalRing();
+	size_t head = ring.head.load(std::memory_order_relaxed);
+	if (head - ring.tail.load(std::memory_order_acquire) >= ringSize)
+	{
+		++ring.dropped;
+		return;
+	}
+	ring.records[head % ringSize] = { name, start, now() };
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+Profiler::GpuZone::GpuZone(Profiler& profiler, const char* name) : profiler(profiler), index(-1)
+{
+	GpuFrame* gpuFrame = profiler.currentGpuFrame;
+	if (!enabled || gpuFrame == nullptr || gpuFrame->count == maxGpuZones) return;
+	index = gpuFrame->count++;
+	gpuFrame->names[index] = name;
+	glQueryCounter(gpuFrame->queries[2 * index], GL_TIMESTAMP);
+}
+
+Profiler::GpuZone::~GpuZone()
+{
+	//the frame can't end inside a zone, so the current frame is the one the zone began in
+	if (index < 0 || profiler.currentGpuFrame == nullptr) return;
+	glQueryCounter(profiler.currentGpuFrame->queries[2 * index + 1], GL_TIMESTAMP);
+}
+
+Profiler::Profiler() : currentGpuFrame(nullptr), frame(0), frameStart(0), droppedGpuFrames(0), capturing(false)
+{
+	gpuSupported = GLEW_ARB_timer_query != 0 || GLEW_VERSION_3_3;
+	for (GpuFrame& gpuFrame : gpuFrames)
+	{
+		if (gpuSupported) glGenQueries(2 * maxGpuZones, gpuFrame.queries);
+		gpuFrame.count = 0;
+		gpuFrame.pending = false;
+	}
+}
+
+Profiler::~Profiler()
+{
+	if (!gpuSupported) return;
+	for (GpuFrame& gpuFrame : gpuFrames)
+	{
+		glDeleteQueries(2 * maxGpuZones, gpuFrame.queries);
+	}
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	::enabled = enabled;
+}
+
+bool Profiler::isEnabled()
+{
+	return enabled;
+}
+
+int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::beginFrame()
+{
+	frameStart = now();
+	if (!enabled || !gpuSupported) return;
+	for (GpuFrame& gpuFrame : gpuFrames)
+	{
+		if (gpuFrame.pending) collectGpu(gpuFrame, false);
+	}
+	//the set of frameLatency frames ago, dropped if its results still aren't there
+	GpuFrame& gpuFrame = gpuFrames[frame % frameLatency];
+	if (gpuFrame.pending) ++droppedGpuFrames;
+	gpuFrame.count = 0;
+	gpuFrame.frame = frame;
+	gpuFrame.pending = false;
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	gpuFrame.clockOffset = now() - int64_t(gpuTime);
+	currentGpuFrame = &gpuFrame;
+}
+
+void Profiler::endFrame()
+{
+	if (currentGpuFrame != nullptr)
+	{
+		currentGpuFrame->pending = currentGpuFrame->count > 0;
+		currentGpuFrame = nullptr;
+	}
+
+	//the frame's slot of the summary starts empty, GPU zones of this frame arrive later
+	for (Summary& summary : summaries)
+	{
+		summary.frames[frame % summaryFrames] = 0.0;
+	}
+	if (enabled)
+	{
+		record("Frame", frameStart, now(), getLocalRing().thread, frame, false);
+	}
+	std::vector<std::shared_ptr<ThreadRing>> threadRings;
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		threadRings = rings;
+	}
+	for (const std::shared_ptr<ThreadRing>& ring : threadRings)
+	{
+		size_t head = ring->head.load(std::memory_order_acquire);
+		for (size_t i = ring->tail.load(std::memory_order_relaxed); i < head; ++i)
+		{
+			const Record& zone = ring->records[i % ringSize];
+			record(zone.name, zone.start, zone.end, ring->thread, frame, false);
+		}
+		ring->tail.store(head, std::memory_order_release);
+	}
+	++frame;
+}
+
+void Profiler::collectGpu(GpuFrame& gpuFrame, bool wait)
+{
+	//the last query finishes last
+	GLuint available = GL_FALSE;
+	if (!wait)
+	{
+		glGetQueryObjectuiv(gpuFrame.queries[2 * gpuFrame.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) return;
+	}
+	for (int i = 0; i < gpuFrame.count; ++i)
+	{
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(gpuFrame.queries[2 * i], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(gpuFrame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+		record(gpuFrame.names[i], int64_t(start) + gpuFrame.clockOffset, int64_t(end) + gpuFrame.clockOffset, gpuThread, gpuFrame.frame, true);
+	}
+	gpuFrame.pending = false;
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end, uint32_t thread, unsigned long eventFrame, bool gpu)
+{
+	//too old for the summary window
+	if (frame - eventFrame < summaryFrames)
+	{
+		std::map<std::string, size_t>& indices = summaryIndices[gpu ? 1 : 0];
+		auto found = indices.find(name);
+		if (found == indices.end())
+		{
+			found = indices.emplace(name, summaries.size()).first;
+			summaries.emplace_back();
+			summaries.back().name = name;
+			summaries.back().gpu = gpu;
+			std::fill(summaries.back().frames, summaries.back().frames + summaryFrames, 0.0);
+		}
+		summaries[found->second].frames[eventFrame % summaryFrames] += double(end - start) * 1e-6;
+	}
+	if (capturing)
+	{
+		trace.push_back({ name, thread, start, end });
+	}
+}
+
+void Profiler::startCapture()
+{
+	trace.clear();
+	capturing = true;
+}
+
+bool Profiler::stopCapture(const std::string& file)
+{
+	if (!capturing) return false;
+	for (GpuFrame& gpuFrame : gpuFrames)
+	{
+		if (gpuFrame.pending && &gpuFrame != currentGpuFrame) collectGpu(gpuFrame, true);
+	}
+	capturing = false;
+
+	std::ofstream out(file);
+	if (!out) return false;
+	//complete events ("X") in microseconds, the threads get names through metadata events ("M")
+	out << "{\"traceEvents\":[\n";
+	std::vector<uint32_t> threads;
+	for (const TraceEvent& event : trace)
+	{
+		if (std::find(threads.begin(), threads.end(), event.thread) == threads.end()) threads.push_back(event.thread);
+	}
+	bool first = true;
+	for (uint32_t thread : threads)
+	{
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":";
+		writeJSONString(out, thread == gpuThread ? "GPU" : thread == 0 ? "Main thread" : "Thread " + std::to_string(thread));
+		out << "}}";
+		first = false;
+	}
+	out << std::fixed << std::setprecision(3);
+	for (const TraceEvent& event : trace)
+	{
+		out << (first ? "" : ",\n") << "{\"name\":";
+		writeJSONString(out, event.name);
+		out << ",\"cat\":\"" << (event.thread == gpuThread ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+			<< ",\"ts\":" << double(event.start) * 1e-3 << ",\"dur\":" << double(event.end - event.start) * 1e-3 << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+	trace.clear();
+	return bool(out);
+}
+
+bool Profiler::isCapturing() const
+{
+	return capturing;
+}
+
+std::string Profiler::getSummary() const
+{
+	//the newest frames may still miss their GPU zones, they are left out
+	unsigned long frames = std::min<unsigned long>(frame > frameLatency ? frame - frameLatency : 0, summaryFrames - frameLatency);
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(3);
+	out << "Profile of the last " << frames << " frames, ms per frame (average / maximum):" << std::endl;
+	unsigned long dropped = droppedGpuFrames;
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		for (const std::shared_ptr<ThreadRing>& ring : rings) dropped += ring->dropped;
+	}
+	for (int gpu = 0; gpu < 2; ++gpu)
+	{
+		for (const Summary& summary : summaries)
+		{
+			if (summary.gpu != (gpu == 1)) continue;
+			double total = 0.0, maximum = 0.0;
+			for (unsigned long i = 0; i < frames; ++i)
+			{
+				double value = summary.frames[(frame - frameLatency - 1 - i) % summaryFrames];
+				total += value;
+				maximum = std::max(maximum, value);
+			}
+			out << "  " << (gpu ? "GPU " : "CPU ") << std::left << std::setw(28) << summary.name << std::right
+				<< std::setw(9) << (frames > 0 ? total / frames : 0.0) << " / " << std::setw(9) << maximum << std::endl;
+		}
+	}
+	if (dropped > 0) out << "  " << dropped << " zones or GPU frames dropped" << std::endl;
+	return out.str();
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <GL/glew.h>
+
+/*
+ Frame profiler. CPU zones go into a fixed size ring per thread that only its thread writes and
+ only endFrame() reads (one producer, one consumer, no locks), a full ring drops zones.
+ GPU zones are pairs of glQueryCounter timestamps, so they can nest. Every frame has its own
+ query set and results are read frameLatency frames later once they are available, reading never stalls.
+ Zones feed a rolling summary of the last summaryFrames frames and, while capturing, a trace in
+ the Chrome trace event format (load it in chrome://tracing or about:tracing).
+ Zone names have to outlive the profiler, string literals are expected.
+*/
+class Profiler
+{
+public:
+	static const size_t ringSize = 16384;
+	static const int frameLatency = 3;
+	static const int maxGpuZones = 256;
+	static const int summaryFrames = 120;
+
+	//CPU zone of the enclosing scope
+	class Zone
+	{
+	private:
+		const char* name;
+		int64_t start;
+	public:
+		Zone(const char* name);
+		~Zone();
+	};
+
+	//GPU zone of the commands issued in the enclosing scope
+	class GpuZone
+	{
+	private:
+		Profiler& profiler;
+		int index;
+	public:
+		GpuZone(Profiler& profiler, const char* name);
+		~GpuZone();
+	};
+private:
+	struct GpuFrame {
+		GLuint queries[2 * maxGpuZones];
+		const char* names[maxGpuZones];
+		int count;
+		unsigned long frame;
+		//CPU minus GPU clock when the frame began
+		int64_t clockOffset;
+		bool pending;
+	};
+	struct Summary {
+		std::string name;
+		bool gpu;
+		//ms per frame, indexed by frame % summaryFrames
+		double frames[summaryFrames];
+	};
+	struct TraceEvent {
+		const char* name;
+		uint32_t thread;
+		int64_t start;
+		int64_t end;
+	};
+
+	GpuFrame gpuFrames[frameLatency];
+	GpuFrame* currentGpuFrame;
+	bool gpuSupported;
+	unsigned long frame;
+	int64_t frameStart;
+	unsigned long droppedGpuFrames;
+	std::vector<Summary> summaries;
+	std::map<std::string, size_t> summaryIndices[2];
+	bool capturing;
+	std::vector<TraceEvent> trace;
+
+	void collectGpu(GpuFrame& gpuFrame, bool wait);
+	//start and end in ns since the profiler epoch
+	void record(const char* name, int64_t start, int64_t end, uint32_t thread, unsigned long eventFrame, bool gpu);
+public:
+	Profiler();
+	~Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	//CPU zones are recorded on all threads while enabled
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+	//ns since the profiler epoch
+	static int64_t now();
+
+	//call on the GL thread around every frame, the time between them is the "Frame" zone
+	void beginFrame();
+	void endFrame();
+
+	void startCapture();
+	//writes everything since startCapture() as a Chrome trace, waits for outstanding GPU zones
+	bool stopCapture(const std::string& file);
+	bool isCapturing() const;
+
+	//average and maximum ms per frame of every zone over the last summaryFrames frames
+	std::string getSummary() const;
+};
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(profiler, name) Profiler::GpuZone PROFILER_CONCAT(profileGpuZone, __LINE__)(profiler, name)
@@ -0,0 +1,97 @@
+#include "RenderStatistics.h"
+#include <sstream>
+#include <iomanip>
+
+namespace {
+	const char* names[RenderStatistics::COUNTER_COUNT] = {
+		"draw calls", "triangles", "vertices", "program switches", "vertex array binds",
+		"texture binds", "uniform calls", "uniform bytes", "light uploads"
+	};
+}
+
+RenderStatistics::Counters RenderStatistics::current;
+RenderStatistics::Counters RenderStatistics::frame;
+RenderStatistics::Counters RenderStatistics::total;
+unsigned long RenderStatistics::frames = 0;
+
+RenderStatistics::Counters& RenderStatistics::Counters::operator+=(const Counters& other)
+{
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		values[i] += other.values[i];
+	}
+	return *this;
+}
+
+void RenderStatistics::endFrame()
+{
+	frame = current;
+	total += current;
+	current = Counters();
+	++frames;
+}
+
+void RenderStatistics::reset()
+{
+	current = Counters();
+	frame = Counters();
+	total = Counters();
+	frames = 0;
+}
+
+const RenderStatistics::Counters& RenderStatistics::getFrameCounters()
+{
+	return frame;
+}
+
+const RenderStatistics::Counters& RenderStatistics::getTotalCounters()
+{
+	return total;
+}
+
+unsigned long RenderStatistics::getFrameCount()
+{
+	return frames;
+}
+
+const char* RenderStatistics::getName(Counter counter)
+{
+	return names[counter];
+}
+
+std::string RenderStatistics::format(const Counters& counters, double frames)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(frames == 1.0 ? 0 : 1);
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		out << (i > 0 ? ", " : "") << names[i] << " " << double(counters.values[i]) / frames;
+	}
+	return out.str();
+}
+
+std::string RenderStatistics::getCSVHeader()
+{
+	std::string header;
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		std::string name = names[i];
+		for (char& c : name)
+		{
+			if (c == ' ') c = '_';
+		}
+		header += (i > 0 ? "," : "") + name;
+	}
+	return header;
+}
+
+std::string RenderStatistics::getCSVValues(const Counters& counters, double frames)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(1);
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		out << (i > 0 ? "," : "") << double(counters.values[i]) / frames;
+	}
+	return out.str();
+}
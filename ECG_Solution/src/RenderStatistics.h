@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+
+/*
+ Counters of the work a frame submits, bumped where the GL calls are made (Geometry, Shader,
+ Texture, LightManager, ...). Only the GL thread counts, so the counters are plain integers.
+ endFrame() closes the frame that was counted so far, its counters stay readable until the next one.
+*/
+class RenderStatistics
+{
+public:
+	enum Counter {
+		DRAW_CALLS,
+		TRIANGLES,
+		//vertices the draws submit, one per index
+		VERTICES,
+		PROGRAM_SWITCHES,
+		VERTEX_ARRAY_BINDS,
+		TEXTURE_BINDS,
+		//uniforms actually uploaded, unchanged values are skipped by Shader
+		UNIFORM_CALLS,
+		UNIFORM_BYTES,
+		//lights set on a shader, once per light and shader
+		LIGHT_UPLOADS,
+		COUNTER_COUNT
+	};
+
+	struct Counters {
+		unsigned long long values[COUNTER_COUNT] = {};
+
+		unsigned long long operator[](Counter counter) const { return values[counter]; }
+		Counters& operator+=(const Counters& other);
+	};
+private:
+	static Counters current;
+	static Counters frame;
+	static Counters total;
+	static unsigned long frames;
+public:
+	static void add(Counter counter, unsigned long long amount = 1) { current.values[counter] += amount; }
+
+	static void endFrame();
+	//forgets everything counted so far, e.g. the loading before the first frame
+	static void reset();
+	//the last closed frame
+	static const Counters& getFrameCounters();
+	//sum over all closed frames
+	static const Counters& getTotalCounters();
+	static unsigned long getFrameCount();
+
+	static const char* getName(Counter counter);
+	//"name value, ..." with every value divided by frames
+	static std::string format(const Counters& counters, double frames = 1.0);
+	//comma separated names and values divided by frames, to append to CSV rows
+	static std::string getCSVHeader();
+	static std::string getCSVValues(const Counters& counters, double frames = 1.0);
+};
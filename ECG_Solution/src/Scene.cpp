@@ -0,0 +1,175 @@
+#include "Scene.h"
+#include <chrono>
+#include <iostream>
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TextureMaterial.h"
+#include "PBRMaterial.h"
+
+Scene::Scene(const std::string& file, bool snapshot, std::shared_ptr<Shader> textureShader, std::shared_ptr<Shader> pbrShader, const TextureLoader& loadTexture)
+	: loaded(false), fromSnapshot(false), loadTime(0.0)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	std::string snapshotFile = getSnapshotPath(file);
+	uint64_t key = SceneFile::sourceKey(file);
+	if (key == 0)
+	{
+		std::cout << "Scene " << file << " not found" << std::endl;
+		return;
+	}
+	fromSnapshot = snapshot && SceneFile::load(snapshotFile, key, scene);
+	if (!fromSnapshot)
+	{
+		if (!SceneFile::read(file, data)) return;
+		scene = data.view();
+		if (snapshot && !SceneFile::save(snapshotFile, data))
+		{
+			std::cout << "Could not write scene snapshot " << snapshotFile << std::endl;
+		}
+	}
+
+	for (uint32_t i = 0; i < scene.header.textureCount; ++i)
+	{
+		textures.push_back(loadTexture(scene.getString(scene.textures[i])));
+	}
+	for (uint32_t i = 0; i < scene.header.materialCount; ++i)
+	{
+		const SceneFile::Material& material = scene.materials[i];
+		if (material.type == SceneFile::TEXTURE_MATERIAL && material.texture >= 0)
+		{
+			materials.push_back(std::make_shared<TextureMaterial>(textureShader, material.ambient, material.diffuse, material.specular,
+				material.specularCoefficient, textures[material.texture]));
+		}
+		else
+		{
+			//fixed remaining coefficients, the random ones of the short constructor would render differently every run
+			materials.push_back(std::make_shared<PBRMaterial>(pbrShader, glm::make_vec3(material.color), 0.1f, material.metallic, 0.5f, 0.0f,
+				material.roughness, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+		}
+	}
+	std::shared_ptr<Material> defaultMaterial;
+	for (uint32_t i = 0; i < scene.header.objectCount; ++i)
+	{
+		const SceneFile::Object& object = scene.objects[i];
+		std::shared_ptr<Material> material;
+		if (object.material >= 0)
+		{
+			material = materials[object.material];
+		}
+		else
+		{
+			if (!defaultMaterial) defaultMaterial = std::make_shared<PBRMaterial>(pbrShader, glm::vec3(0.8f), 0.1f, 0.1f, 0.5f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+			material = defaultMaterial;
+		}
+		SceneGraph::Node node = sceneGraph.addNode(glm::make_mat4(object.modelMatrix), object.parent);
+		if (object.spin != 0.0f) spinning.push_back(node);
+		geometries.push_back(std::make_unique<Geometry>(glm::make_mat4(object.modelMatrix), scene.positions + object.vertexOffset,
+			scene.normals + object.vertexOffset, scene.uv + object.vertexOffset, object.vertexCount, scene.indices + object.indexOffset, object.indexCount, material));
+		geometries.back()->setNode(&sceneGraph, node);
+	}
+	sceneGraph.update();
+	loaded = true;
+	loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool Scene::isLoaded() const
+{
+	return loaded;
+}
+
+bool Scene::isFromSnapshot() const
+{
+	return fromSnapshot;
+}
+
+double Scene::getLoadTime() const
+{
+	return loadTime;
+}
+
+void Scene::update(double time, JobSystem* jobs)
+{
+	for (SceneGraph::Node node : spinning)
+	{
+		const SceneFile::Object& object = scene.objects[node];
+		float angle = glm::radians(float(std::fmod(double(object.spin) * time, 360.0)));
+		sceneGraph.setLocalMatrix(node, glm::rotate(glm::make_mat4(object.modelMatrix), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+	sceneGraph.update(jobs);
+}
+
+const SceneGraph& Scene::getSceneGraph() const
+{
+	return sceneGraph;
+}
+
+std::string Scene::getSnapshotPath(const std::string& file)
+{
+	size_t dot = file.find_last_of('.');
+	size_t slash = file.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return file + ".snapshot";
+	return file.substr(0, dot) + ".snapshot";
+}
+
+void Scene::createLights(LightManager& lightManager) const
+{
+	for (uint32_t i = 0; i < scene.header.lightCount; ++i)
+	{
+		const SceneFile::Light& light = scene.lights[i];
+		glm::vec3 color = glm::make_vec3(light.color), position = glm::make_vec3(light.position);
+		glm::vec3 direction = glm::make_vec3(light.direction), attenuation = glm::make_vec3(light.attenuation);
+		switch (light.type)
+		{
+		case SceneFile::DIRECTIONAL_LIGHT:
+			lightManager.createDirectionalLight(color, direction);
+			break;
+		case SceneFile::SPOT_LIGHT:
+			lightManager.createSpotLight(color, position, direction, light.innerAngle, light.outerAngle, attenuation);
+			break;
+		default:
+			lightManager.createPointLight(color, position, attenuation);
+			break;
+		}
+	}
+}
+
+std::vector<Geometry*> Scene::getGeometries() const
+{
+	std::vector<Geometry*> result;
+	for (const std::unique_ptr<Geometry>& geometry : geometries)
+	{
+		result.push_back(geometry.get());
+	}
+	return result;
+}
+
+bool Scene::addToBatch(TexturedBatch& batch, std::vector<Geometry*>& unbatched) const
+{
+	//one batch material per scene material, so shared textures get one layer
+	std::vector<int> batchMaterials(scene.header.materialCount, -1);
+	//spinning objects and their descendants, parents come first
+	std::vector<bool> animated(scene.header.objectCount, false);
+	unbatched.clear();
+	for (uint32_t i = 0; i < scene.header.objectCount; ++i)
+	{
+		const SceneFile::Object& object = scene.objects[i];
+		animated[i] = object.spin != 0.0f || (object.parent >= 0 && animated[object.parent]);
+		const SceneFile::Material* material = object.material >= 0 ? &scene.materials[object.material] : nullptr;
+		//the batch keeps the transform a draw was added with, animated objects stay separate geometries
+		if (animated[i] || material == nullptr || material->type != SceneFile::TEXTURE_MATERIAL || material->texture < 0)
+		{
+			unbatched.push_back(geometries[i].get());
+			continue;
+		}
+		int& batchMaterial = batchMaterials[object.material];
+		if (batchMaterial < 0)
+		{
+			batchMaterial = batch.addMaterial(scene.getString(scene.textures[material->texture]), material->ambient, material->diffuse,
+				material->specular, material->specularCoefficient);
+			if (batchMaterial < 0) return false;
+		}
+		batch.addGeometry(sceneGraph.getWorldMatrix(SceneGraph::Node(i)), scene.getGeometryData(object), batchMaterial, geometries[i]->getBoundingSphere());
+	}
+	return true;
+}
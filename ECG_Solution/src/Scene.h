@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "SceneFile.h"
+#include "Geometry.h"
+#include "Texture.h"
+#include "LightManager.h"
+#include "TexturedBatch.h"
+#include "SceneGraph.h"
+
+/*
+ GL objects of a scene file. The resolved scene is written as a snapshot next to the
+ scene file ('.snapshot' instead of its extension) and mapped instead of resolving it
+ again while the scene file and its models are unchanged.
+*/
+class Scene
+{
+public:
+	typedef std::function<std::shared_ptr<Texture>(const std::string&)> TextureLoader;
+private:
+	SceneFile::Data data;
+	SceneFile::Scene scene;
+	bool loaded;
+	bool fromSnapshot;
+	//milliseconds until all objects were created
+	double loadTime;
+	std::vector<std::shared_ptr<Texture>> textures;
+	std::vector<std::shared_ptr<Material>> materials;
+	std::vector<std::unique_ptr<Geometry>> geometries;
+	//one node per object, in object order
+	SceneGraph sceneGraph;
+	std::vector<SceneGraph::Node> spinning;
+public:
+	Scene(const std::string& file, bool snapshot, std::shared_ptr<Shader> textureShader, std::shared_ptr<Shader> pbrShader, const TextureLoader& loadTexture);
+	//geometries point to the scene graph
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	bool isLoaded() const;
+	bool isFromSnapshot() const;
+	double getLoadTime() const;
+	static std::string getSnapshotPath(const std::string& file);
+
+	//animates spinning objects to the given time in seconds and updates the scene graph, on the jobs if given
+	void update(double time, JobSystem* jobs = nullptr);
+	const SceneGraph& getSceneGraph() const;
+
+	void createLights(LightManager& lightManager) const;
+	std::vector<Geometry*> getGeometries() const;
+	//adds the static textured objects to the batch, the others are returned, false if a texture doesn't fit the batch
+	bool addToBatch(TexturedBatch& batch, std::vector<Geometry*>& unbatched) const;
+};
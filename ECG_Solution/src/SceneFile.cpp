@@ -0,0 +1,372 @@
+#include "SceneFile.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <map>
+#include <functional>
+#include <sys/stat.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "INIReader.h"
+#include "AssetCache.h"
+#include "ModelImporter.h"
+#include "MeshFile.h"
+
+namespace {
+	const char magic[4] = { 'S', 'C', 'N', 'E' };
+
+	static_assert(sizeof(SceneFile::Material) == 56 && sizeof(SceneFile::Object) == 96 && sizeof(SceneFile::Light) == 64,
+		"file structures must not have padding");
+
+	using SectionFile::addSection;
+	using SectionFile::validSection;
+
+	//the sections of one kind, "texture wood" is the texture named "wood"
+	std::vector<std::pair<std::string, std::string>> sectionsOf(INIReader& reader, const std::string& kind)
+	{
+		std::vector<std::pair<std::string, std::string>> sections;
+		for (const std::string& section : reader.Sections())
+		{
+			size_t space = section.find(' ');
+			if (space != std::string::npos && section.compare(0, space, kind) == 0)
+			{
+				sections.emplace_back(section, section.substr(space + 1));
+			}
+		}
+		return sections;
+	}
+
+	//whitespace separated numbers, missing ones are taken from the defaults
+	glm::vec3 readVector(INIReader& reader, const std::string& section, const std::string& name, glm::vec3 defaults)
+	{
+		std::istringstream values(reader.Get(section, name, ""));
+		for (int i = 0; i < 3 && values >> defaults[i]; ++i);
+		return defaults;
+	}
+
+	void copy(const glm::vec3& vector, float* target)
+	{
+		target[0] = vector.x;
+		target[1] = vector.y;
+		target[2] = vector.z;
+	}
+
+	bool readGeometry(INIReader& reader, const std::string& section, GeometryData& geometry)
+	{
+		std::string shape = reader.Get(section, "shape", "");
+		glm::vec3 size = readVector(reader, section, "size", glm::vec3(1.0f));
+		glm::vec3 segments = readVector(reader, section, "segments", glm::vec3(32.0f, 16.0f, 0.0f));
+		if (shape == "cube")
+		{
+			geometry = Geometry::createCubeGeometry(size.x, size.y, size.z);
+		}
+		else if (shape == "sphere")
+		{
+			geometry = Geometry::createSphereGeometry(size.x, (unsigned int)segments.x, (unsigned int)segments.y);
+		}
+		else if (shape == "cylinder")
+		{
+			geometry = Geometry::createCylinderGeometry(size.x, size.y, (unsigned int)segments.x);
+		}
+		else if (shape == "torus")
+		{
+			geometry = Geometry::createTorusGeometry(size.x, size.y, (unsigned int)segments.x, (unsigned int)segments.y);
+		}
+		else if (shape == "model")
+		{
+			std::string file = reader.Get(section, "file", "");
+			if (file.size() > 5 && file.compare(file.size() - 5, 5, ".mesh") == 0)
+			{
+				MeshFile::Mesh mesh;
+				if (!MeshFile::load(file, mesh)) return false;
+				geometry = MeshFile::toGeometryData(mesh);
+			}
+			else
+			{
+				ImportedModel model;
+				if (!importModel(file, model)) return false;
+				geometry = mergeMeshes(model);
+			}
+		}
+		else
+		{
+			return false;
+		}
+		geometry.normals.resize(geometry.positions.size(), glm::vec3(0.0f, 1.0f, 0.0f));
+		geometry.uv.resize(geometry.positions.size(), glm::vec2(0.0f));
+		return true;
+	}
+}
+
+std::string SceneFile::Scene::getString(const String& string) const
+{
+	return std::string(strings + string.offset, string.length);
+}
+
+GeometryData SceneFile::Scene::getGeometryData(const Object& object) const
+{
+	GeometryData geometry;
+	geometry.positions.assign(positions + object.vertexOffset, positions + object.vertexOffset + object.vertexCount);
+	geometry.normals.assign(normals + object.vertexOffset, normals + object.vertexOffset + object.vertexCount);
+	geometry.uv.assign(uv + object.vertexOffset, uv + object.vertexOffset + object.vertexCount);
+	geometry.indices.assign(indices + object.indexOffset, indices + object.indexOffset + object.indexCount);
+	geometry.track();
+	return geometry;
+}
+
+SceneFile::Scene SceneFile::Data::view() const
+{
+	Scene scene;
+	std::memset(&scene.header, 0, sizeof(scene.header));
+	std::memcpy(scene.header.magic, magic, 4);
+	scene.header.version = version;
+	scene.header.sourceKey = sourceKey;
+	scene.header.textureCount = uint32_t(textures.size());
+	scene.header.materialCount = uint32_t(materials.size());
+	scene.header.objectCount = uint32_t(objects.size());
+	scene.header.lightCount = uint32_t(lights.size());
+	scene.header.vertexCount = uint32_t(positions.size());
+	scene.header.indexCount = uint32_t(indices.size());
+	scene.textures = textures.data();
+	scene.materials = materials.data();
+	scene.objects = objects.data();
+	scene.lights = lights.data();
+	scene.strings = strings.data();
+	scene.positions = positions.data();
+	scene.normals = normals.data();
+	scene.uv = uv.data();
+	scene.indices = indices.data();
+	return scene;
+}
+
+uint64_t SceneFile::sourceKey(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in) return 0;
+	std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	uint64_t key = AssetCache::hash(&version, sizeof(version));
+	key = AssetCache::hash(text.data(), text.size(), key);
+
+	//models are only checked for changes, reading them would cost as much as importing them
+	INIReader reader(file);
+	for (const auto& section : sectionsOf(reader, "object"))
+	{
+		if (reader.Get(section.first, "shape", "") != "model") continue;
+		struct stat status;
+		std::string model = reader.Get(section.first, "file", "");
+		int64_t stamp[2] = { 0, 0 };
+		if (stat(model.c_str(), &status) == 0)
+		{
+			stamp[0] = int64_t(status.st_size);
+			stamp[1] = int64_t(status.st_mtime);
+		}
+		key = AssetCache::hash(model.data(), model.size(), key);
+		key = AssetCache::hash(stamp, sizeof(stamp), key);
+	}
+	return key;
+}
+
+bool SceneFile::read(const std::string& file, Data& data)
+{
+	INIReader reader(file);
+	if (reader.ParseError() != 0)
+	{
+		std::cout << "Could not read scene " << file << std::endl;
+		return false;
+	}
+	data = Data();
+	data.sourceKey = sourceKey(file);
+
+	std::map<std::string, int32_t> textures, materials;
+	for (const auto& section : sectionsOf(reader, "texture"))
+	{
+		std::string path = reader.Get(section.first, "file", "");
+		textures[section.second] = int32_t(data.textures.size());
+		data.textures.push_back({ uint32_t(data.strings.size()), uint32_t(path.size()) });
+		data.strings += path;
+	}
+
+	for (const auto& section : sectionsOf(reader, "material"))
+	{
+		Material material;
+		std::memset(&material, 0, sizeof(material));
+		std::string type = reader.Get(section.first, "type", "texture");
+		material.type = type == "pbr" ? PBR_MATERIAL : TEXTURE_MATERIAL;
+		std::string texture = reader.Get(section.first, "texture", "");
+		material.texture = -1;
+		if (!texture.empty())
+		{
+			if (textures.count(texture) == 0)
+			{
+				std::cout << "Scene " << file << ": material " << section.second << " uses unknown texture " << texture << std::endl;
+				return false;
+			}
+			material.texture = textures[texture];
+		}
+		std::istringstream lighting(reader.Get(section.first, "lighting", "0.1 0.7 0.1 2.0"));
+		lighting >> material.ambient >> material.diffuse >> material.specular >> material.specularCoefficient;
+		copy(readVector(reader, section.first, "color", glm::vec3(0.8f)), material.color);
+		material.metallic = float(reader.GetReal(section.first, "metallic", 0.0));
+		material.roughness = float(reader.GetReal(section.first, "roughness", 0.5));
+		materials[section.second] = int32_t(data.materials.size());
+		data.materials.push_back(material);
+	}
+
+	//objects are stored parents first, the order of SceneGraph nodes
+	std::vector<std::pair<std::string, std::string>> objectSections = sectionsOf(reader, "object");
+	std::map<std::string, size_t> sectionIndices;
+	for (size_t i = 0; i < objectSections.size(); ++i)
+	{
+		sectionIndices[objectSections[i].second] = i;
+	}
+	std::vector<int> visited(objectSections.size(), 0);
+	std::vector<size_t> order;
+	std::function<bool(size_t)> visit = [&](size_t i) {
+		//1 while the parents are visited, a cycle if it is seen again
+		if (visited[i] != 0) return visited[i] == 2;
+		visited[i] = 1;
+		std::string parent = reader.Get(objectSections[i].first, "parent", "");
+		if (!parent.empty() && (sectionIndices.count(parent) == 0 || !visit(sectionIndices[parent]))) return false;
+		visited[i] = 2;
+		order.push_back(i);
+		return true;
+	};
+	for (size_t i = 0; i < objectSections.size(); ++i)
+	{
+		if (!visit(i))
+		{
+			std::cout << "Scene " << file << ": object " << objectSections[i].second << " has an unknown or cyclic parent" << std::endl;
+			return false;
+		}
+	}
+
+	std::map<std::string, int32_t> objects;
+	for (size_t i : order)
+	{
+		const std::pair<std::string, std::string>& section = objectSections[i];
+		GeometryData geometry;
+		if (!readGeometry(reader, section.first, geometry))
+		{
+			std::cout << "Scene " << file << ": could not create object " << section.second << std::endl;
+			return false;
+		}
+		Object object;
+		std::memset(&object, 0, sizeof(object));
+		std::string material = reader.Get(section.first, "material", "");
+		object.material = materials.count(material) > 0 ? materials[material] : -1;
+		std::string parent = reader.Get(section.first, "parent", "");
+		object.parent = parent.empty() ? -1 : objects[parent];
+		object.spin = float(reader.GetReal(section.first, "spin", 0.0));
+
+		glm::vec3 rotation = glm::radians(readVector(reader, section.first, "rotation", glm::vec3(0.0f)));
+		glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), readVector(reader, section.first, "position", glm::vec3(0.0f)));
+		modelMatrix = glm::rotate(modelMatrix, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+		modelMatrix = glm::rotate(modelMatrix, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+		modelMatrix = glm::rotate(modelMatrix, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+		modelMatrix = glm::scale(modelMatrix, readVector(reader, section.first, "scale", glm::vec3(1.0f)));
+		std::memcpy(object.modelMatrix, glm::value_ptr(modelMatrix), sizeof(object.modelMatrix));
+
+		object.vertexOffset = uint32_t(data.positions.size());
+		object.vertexCount = uint32_t(geometry.positions.size());
+		object.indexOffset = uint32_t(data.indices.size());
+		object.indexCount = uint32_t(geometry.indices.size());
+		data.positions.insert(data.positions.end(), geometry.positions.begin(), geometry.positions.end());
+		data.normals.insert(data.normals.end(), geometry.normals.begin(), geometry.normals.end());
+		data.uv.insert(data.uv.end(), geometry.uv.begin(), geometry.uv.end());
+		data.indices.insert(data.indices.end(), geometry.indices.begin(), geometry.indices.end());
+		objects[section.second] = int32_t(data.objects.size());
+		data.objects.push_back(object);
+	}
+
+	for (const auto& section : sectionsOf(reader, "light"))
+	{
+		Light light;
+		std::memset(&light, 0, sizeof(light));
+		std::string type = reader.Get(section.first, "type", "point");
+		light.type = type == "directional" ? DIRECTIONAL_LIGHT : type == "spot" ? SPOT_LIGHT : POINT_LIGHT;
+		copy(readVector(reader, section.first, "color", glm::vec3(1.0f)), light.color);
+		copy(readVector(reader, section.first, "position", glm::vec3(0.0f)), light.position);
+		copy(readVector(reader, section.first, "direction", glm::vec3(0.0f, -1.0f, 0.0f)), light.direction);
+		copy(readVector(reader, section.first, "attenuation", glm::vec3(1.0f, 0.4f, 0.1f)), light.attenuation);
+		glm::vec3 angles = readVector(reader, section.first, "angles", glm::vec3(20.0f, 30.0f, 0.0f));
+		light.innerAngle = angles.x;
+		light.outerAngle = angles.y;
+		data.lights.push_back(light);
+	}
+	return true;
+}
+
+bool SceneFile::save(const std::string& file, const Data& data)
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out) return false;
+
+	Header header = data.view().header;
+	std::vector<char> sections;
+	header.textures = addSection(sections, sizeof(Header), data.textures.data(), data.textures.size());
+	header.materials = addSection(sections, sizeof(Header), data.materials.data(), data.materials.size());
+	header.objects = addSection(sections, sizeof(Header), data.objects.data(), data.objects.size());
+	header.lights = addSection(sections, sizeof(Header), data.lights.data(), data.lights.size());
+	header.strings = addSection(sections, sizeof(Header), data.strings.data(), data.strings.size());
+	header.positions = addSection(sections, sizeof(Header), data.positions.data(), data.positions.size());
+	header.normals = addSection(sections, sizeof(Header), data.normals.data(), data.normals.size());
+	header.uv = addSection(sections, sizeof(Header), data.uv.data(), data.uv.size());
+	header.indices = addSection(sections, sizeof(Header), data.indices.data(), data.indices.size());
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(sections.data(), sections.size());
+	return bool(out);
+}
+
+bool SceneFile::load(const std::string& file, uint64_t sourceKey, Scene& scene)
+{
+	std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(file);
+	if (!mapping->isOpen() || mapping->getSize() < sizeof(Header)) return false;
+	const unsigned char* data = mapping->data();
+	size_t size = mapping->getSize();
+	Header& header = scene.header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, magic, 4) != 0 || header.version != version || header.sourceKey != sourceKey) return false;
+	if (!validSection(header.textures, size, sizeof(String), header.textureCount)
+		|| !validSection(header.materials, size, sizeof(Material), header.materialCount)
+		|| !validSection(header.objects, size, sizeof(Object), header.objectCount)
+		|| !validSection(header.lights, size, sizeof(Light), header.lightCount)
+		|| !validSection(header.strings, size, 1, header.strings.size)
+		|| !validSection(header.positions, size, sizeof(glm::vec3), header.vertexCount)
+		|| !validSection(header.normals, size, sizeof(glm::vec3), header.vertexCount)
+		|| !validSection(header.uv, size, sizeof(glm::vec2), header.vertexCount)
+		|| !validSection(header.indices, size, sizeof(uint32_t), header.indexCount))
+	{
+		return false;
+	}
+
+	scene.textures = reinterpret_cast<const String*>(data + header.textures.offset);
+	scene.materials = reinterpret_cast<const Material*>(data + header.materials.offset);
+	scene.objects = reinterpret_cast<const Object*>(data + header.objects.offset);
+	scene.lights = reinterpret_cast<const Light*>(data + header.lights.offset);
+	scene.strings = reinterpret_cast<const char*>(data + header.strings.offset);
+	scene.positions = reinterpret_cast<const glm::vec3*>(data + header.positions.offset);
+	scene.normals = reinterpret_cast<const glm::vec3*>(data + header.normals.offset);
+	scene.uv = reinterpret_cast<const glm::vec2*>(data + header.uv.offset);
+	scene.indices = reinterpret_cast<const uint32_t*>(data + header.indices.offset);
+
+	//references are checked once here, so users can index without checks
+	for (uint32_t i = 0; i < header.textureCount; ++i)
+	{
+		if (uint64_t(scene.textures[i].offset) + scene.textures[i].length > header.strings.size) return false;
+	}
+	for (uint32_t i = 0; i < header.materialCount; ++i)
+	{
+		if (scene.materials[i].texture >= int32_t(header.textureCount)) return false;
+	}
+	for (uint32_t i = 0; i < header.objectCount; ++i)
+	{
+		const Object& object = scene.objects[i];
+		if (object.material >= int32_t(header.materialCount) || object.parent >= int32_t(i)
+			|| uint64_t(object.vertexOffset) + object.vertexCount > header.vertexCount
+			|| uint64_t(object.indexOffset) + object.indexCount > header.indexCount) return false;
+	}
+	scene.file = mapping;
+	return true;
+}
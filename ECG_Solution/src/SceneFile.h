@@ -0,0 +1,178 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Geometry.h"
+#include "MappedFile.h"
+#include "SectionFile.h"
+
+/*
+ Scene description in the style of settings.ini, one section per texture, material, object or light:
+
+	[texture wood]
+	file = ./assets/textures/wood_texture.dds
+
+	[material wood]
+	type = texture          ; texture (diffuseTexture shader) or pbr (PBR_shader_phong shader)
+	texture = wood
+	lighting = 0.1 0.7 0.1 2.0   ; ambient, diffuse, specular, specular coefficient
+	color = 0.8 0.2 0.2     ; pbr: sRGB base color
+	metallic = 0.0
+	roughness = 0.5
+
+	[object cube]
+	shape = cube            ; cube, sphere, cylinder, torus or model
+	size = 1.5 1.5 1.5      ; cube: width height depth, sphere: radius, cylinder: radius height, torus: radius tube radius
+	segments = 32           ; sphere: longitude latitude, cylinder: sides, torus: tube circle
+	file = model.obj        ; model: '.obj', '.gltf', '.glb' or cooked '.mesh'
+	material = wood
+	position = 0 1.5 0
+	rotation = 0 45 0       ; degrees around x, y, z
+	scale = 1 1 1
+	parent = table          ; the transform is relative to this object
+	spin = 45               ; degrees per second around the local y axis, children spin along
+
+	[light sun]
+	type = directional      ; point, directional or spot
+	color = 0.8 0.8 0.8
+	position = 0 0 0
+	direction = 0 -1 -1
+	attenuation = 0.1 0.4 1.0
+	angles = 20 30          ; spot: inner and outer opening angle in degrees
+
+ A resolved scene has all geometry generated or imported and concatenated into shared vertex
+ and index arrays, so it can be written as a snapshot that is memory mapped on later starts.
+ Sections are read in name order, objects are then sorted parents first.
+*/
+namespace SceneFile
+{
+	const uint32_t version = 2;
+	using SectionFile::alignment;
+	using SectionFile::Section;
+
+	enum MaterialType : uint32_t { TEXTURE_MATERIAL, PBR_MATERIAL };
+	enum LightType : uint32_t { POINT_LIGHT, DIRECTIONAL_LIGHT, SPOT_LIGHT };
+
+	//a string in the string section
+	struct String {
+		uint32_t offset;
+		uint32_t length;
+	};
+	struct Material {
+		uint32_t type;
+		//index of the texture, -1 for none
+		int32_t texture;
+		float ambient;
+		float diffuse;
+		float specular;
+		float specularCoefficient;
+		float color[3];
+		float metallic;
+		float roughness;
+		uint32_t padding[3];
+	};
+	struct Object {
+		//relative to the parent
+		float modelMatrix[16];
+		//index of the material, -1 for none
+		int32_t material;
+		uint32_t vertexOffset;
+		uint32_t vertexCount;
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		//index of the parent object, always smaller than the own index, -1 for none
+		int32_t parent;
+		//degrees per second around the local y axis
+		float spin;
+		uint32_t padding;
+	};
+	struct Light {
+		uint32_t type;
+		float color[3];
+		float position[3];
+		float direction[3];
+		float attenuation[3];
+		float innerAngle;
+		float outerAngle;
+		uint32_t padding;
+	};
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		//key of the scene file the snapshot was made from
+		uint64_t sourceKey;
+		uint32_t textureCount;
+		uint32_t materialCount;
+		uint32_t objectCount;
+		uint32_t lightCount;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		Section textures;
+		Section materials;
+		Section objects;
+		Section lights;
+		Section strings;
+		Section positions;
+		Section normals;
+		Section uv;
+		Section indices;
+	};
+
+	//a resolved scene, the pointers point into a Data or a snapshot mapping
+	struct Scene {
+		Header header;
+		const String* textures = nullptr;
+		const Material* materials = nullptr;
+		const Object* objects = nullptr;
+		const Light* lights = nullptr;
+		const char* strings = nullptr;
+		const glm::vec3* positions = nullptr;
+		const glm::vec3* normals = nullptr;
+		const glm::vec2* uv = nullptr;
+		const uint32_t* indices = nullptr;
+		std::shared_ptr<MappedFile> file;
+
+		std::string getString(const String& string) const;
+		//copies the vertices and indices of one object
+		GeometryData getGeometryData(const Object& object) const;
+	};
+
+	//a resolved scene in memory
+	struct Data {
+		uint64_t sourceKey = 0;
+		std::vector<String> textures;
+		std::vector<Material> materials;
+		std::vector<Object> objects;
+		std::vector<Light> lights;
+		std::string strings;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uv;
+		std::vector<uint32_t> indices;
+
+		//points a Scene into this data, valid while the data is unchanged
+		Scene view() const;
+	};
+
+	/*!
+	 * Hashes the scene file together with the size and modification time of the models it uses
+	 * @return 0 if the file is missing
+	 */
+	uint64_t sourceKey(const std::string& file);
+	/*!
+	 * Reads a scene file and generates or imports all geometry
+	 * @return false if the file is missing or references something that doesn't exist
+	 */
+	bool read(const std::string& file, Data& data);
+	/*!
+	 * Writes a resolved scene as a snapshot
+	 * @return false if the file could not be written
+	 */
+	bool save(const std::string& file, const Data& data);
+	/*!
+	 * Memory maps a snapshot
+	 * @return false if the file is missing, invalid or was made from another source key
+	 */
+	bool load(const std::string& file, uint64_t sourceKey, Scene& scene);
+}
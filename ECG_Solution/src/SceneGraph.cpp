@@ -0,0 +1,244 @@
+#include "SceneGraph.h"
+#include "JobSystem.h"
+#include <cassert>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCENE_GRAPH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	//nodes per job of the parallel update
+	const size_t grainSize = 256;
+
+	void normalMatrix(const glm::mat4& m, glm::mat3& normal)
+	{
+		//cofactors divided by the determinant, the same as glm::inverseTranspose
+		glm::mat3 cofactors;
+		cofactors[0][0] = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+		cofactors[0][1] = m[2][0] * m[1][2] - m[1][0] * m[2][2];
+		cofactors[0][2] = m[1][0] * m[2][1] - m[2][0] * m[1][1];
+		cofactors[1][0] = m[2][1] * m[0][2] - m[0][1] * m[2][2];
+		cofactors[1][1] = m[0][0] * m[2][2] - m[2][0] * m[0][2];
+		cofactors[1][2] = m[2][0] * m[0][1] - m[0][0] * m[2][1];
+		cofactors[2][0] = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+		cofactors[2][1] = m[1][0] * m[0][2] - m[0][0] * m[1][2];
+		cofactors[2][2] = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+		float determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+		normal = cofactors * (1.0f / determinant);
+	}
+}
+
+SceneGraph::SceneGraph() : updates(0)
+{
+}
+
+SceneGraph::Node SceneGraph::addNode(const glm::mat4& localMatrix, Node parent)
+{
+	assert(parent < Node(parents.size()));
+	parents.push_back(parent);
+	localMatrices.push_back(localMatrix);
+	worldMatrices.push_back(localMatrix);
+	normalMatrices.push_back(glm::mat3(1.0f));
+	dirty.push_back(1);
+	Node node = Node(parents.size()) - 1;
+	int depth = parent == none ? 0 : depths[parent] + 1;
+	depths.push_back(depth);
+	if (int(levels.size()) <= depth) levels.resize(depth + 1);
+	levels[depth].push_back(node);
+	return node;
+}
+
+void SceneGraph::setLocalMatrix(Node node, const glm::mat4& localMatrix)
+{
+	localMatrices[node] = localMatrix;
+	dirty[node] = 1;
+}
+
+const glm::mat4& SceneGraph::getLocalMatrix(Node node) const
+{
+	return localMatrices[node];
+}
+
+SceneGraph::Node SceneGraph::getParent(Node node) const
+{
+	return parents[node];
+}
+
+size_t SceneGraph::size() const
+{
+	return parents.size();
+}
+
+void SceneGraph::update(JobSystem* jobs)
+{
+	size_t updated = 0;
+	if (jobs && jobs->getThreadCount() > 1)
+	{
+		//a level only reads the world matrices and flags of the level before
+		std::atomic<size_t> levelUpdated(0);
+		for (const std::vector<Node>& level : levels)
+		{
+			jobs->parallelFor(level.size(), grainSize, [&](size_t begin, size_t end) {
+				Node rangeChanged[grainSize];
+				size_t count = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					Node node = level[i];
+					if (updateNode(node)) rangeChanged[count++] = node;
+				}
+				computeNormalMatrices(worldMatrices.data(), normalMatrices.data(), rangeChanged, count);
+				levelUpdated += count;
+			});
+		}
+		std::fill(dirty.begin(), dirty.end(), uint8_t(0));
+		updated = levelUpdated;
+	}
+	else
+	{
+		//parents come first, so a dirty flag reaches the whole subtree in one pass
+		changed.clear();
+		for (size_t i = 0; i < parents.size(); ++i)
+		{
+			if (updateNode(Node(i))) changed.push_back(Node(i));
+		}
+		computeNormalMatrices(worldMatrices.data(), normalMatrices.data(), changed.data(), changed.size());
+		for (Node node : changed)
+		{
+			dirty[node] = 0;
+		}
+		updated = changed.size();
+	}
+
+	counters.updated = updated;
+	counters.total = parents.size();
+	totalCounters.updated += counters.updated;
+	totalCounters.total += counters.total;
+	++updates;
+}
+
+bool SceneGraph::updateNode(Node node)
+{
+	Node parent = parents[node];
+	if (!dirty[node] && (parent == none || !dirty[parent])) return false;
+	dirty[node] = 1;
+	if (parent == none)
+	{
+		worldMatrices[node] = localMatrices[node];
+	}
+	else
+	{
+		multiply(worldMatrices[parent], localMatrices[node], worldMatrices[node]);
+	}
+	return true;
+}
+
+const glm::mat4& SceneGraph::getWorldMatrix(Node node) const
+{
+	return worldMatrices[node];
+}
+
+const glm::mat3& SceneGraph::getNormalMatrix(Node node) const
+{
+	return normalMatrices[node];
+}
+
+SceneGraph::Counters SceneGraph::getCounters() const
+{
+	return counters;
+}
+
+SceneGraph::Counters SceneGraph::getTotalCounters() const
+{
+	return totalCounters;
+}
+
+unsigned long SceneGraph::getUpdateCount() const
+{
+	return updates;
+}
+
+void SceneGraph::multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+{
+#ifdef SCENE_GRAPH_SSE2
+	//each result column is a linear combination of the columns of a
+	__m128 columns[4];
+	for (int k = 0; k < 4; ++k)
+	{
+		columns[k] = _mm_loadu_ps(&a[k][0]);
+	}
+	for (int j = 0; j < 4; ++j)
+	{
+		__m128 column = _mm_mul_ps(columns[0], _mm_set1_ps(b[j][0]));
+		column = _mm_add_ps(column, _mm_mul_ps(columns[1], _mm_set1_ps(b[j][1])));
+		column = _mm_add_ps(column, _mm_mul_ps(columns[2], _mm_set1_ps(b[j][2])));
+		column = _mm_add_ps(column, _mm_mul_ps(columns[3], _mm_set1_ps(b[j][3])));
+		_mm_storeu_ps(&result[j][0], column);
+	}
+#else
+	result = a * b;
+#endif
+}
+
+void SceneGraph::computeNormalMatrices(const glm::mat4* matrices, glm::mat3* normals, const Node* nodes, size_t count)
+{
+	size_t i = 0;
+#ifdef SCENE_GRAPH_SSE2
+	//four matrices at a time, one per lane
+	for (; i + 4 <= count; i += 4)
+	{
+		const glm::mat4& m0 = matrices[nodes[i]];
+		const glm::mat4& m1 = matrices[nodes[i + 1]];
+		const glm::mat4& m2 = matrices[nodes[i + 2]];
+		const glm::mat4& m3 = matrices[nodes[i + 3]];
+		__m128 m[3][3];
+		for (int c = 0; c < 3; ++c)
+		{
+			for (int r = 0; r < 3; ++r)
+			{
+				m[c][r] = _mm_setr_ps(m0[c][r], m1[c][r], m2[c][r], m3[c][r]);
+			}
+		}
+		auto difference = [](__m128 a, __m128 b, __m128 c, __m128 d) { return _mm_sub_ps(_mm_mul_ps(a, b), _mm_mul_ps(c, d)); };
+		__m128 cofactors[3][3];
+		cofactors[0][0] = difference(m[1][1], m[2][2], m[2][1], m[1][2]);
+		cofactors[0][1] = difference(m[2][0], m[1][2], m[1][0], m[2][2]);
+		cofactors[0][2] = difference(m[1][0], m[2][1], m[2][0], m[1][1]);
+		cofactors[1][0] = difference(m[2][1], m[0][2], m[0][1], m[2][2]);
+		cofactors[1][1] = difference(m[0][0], m[2][2], m[2][0], m[0][2]);
+		cofactors[1][2] = difference(m[2][0], m[0][1], m[0][0], m[2][1]);
+		cofactors[2][0] = difference(m[0][1], m[1][2], m[1][1], m[0][2]);
+		cofactors[2][1] = difference(m[1][0], m[0][2], m[0][0], m[1][2]);
+		cofactors[2][2] = difference(m[0][0], m[1][1], m[1][0], m[0][1]);
+		__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], cofactors[0][0]), _mm_mul_ps(m[0][1], cofactors[0][1])),
+			_mm_mul_ps(m[0][2], cofactors[0][2]));
+		__m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+		alignas(16) float lanes[3][3][4];
+		for (int c = 0; c < 3; ++c)
+		{
+			for (int r = 0; r < 3; ++r)
+			{
+				_mm_store_ps(lanes[c][r], _mm_mul_ps(cofactors[c][r], scale));
+			}
+		}
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			glm::mat3& normal = normals[nodes[i + lane]];
+			for (int c = 0; c < 3; ++c)
+			{
+				for (int r = 0; r < 3; ++r)
+				{
+					normal[c][r] = lanes[c][r][lane];
+				}
+			}
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		normalMatrix(matrices[nodes[i]], normals[nodes[i]]);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+/*
+ Transform hierarchy stored as structure of arrays, nodes are indices and a parent always has
+ a smaller index than its children. update() walks the arrays once in order: a node is recomputed
+ if its local transform changed or its parent was recomputed, so static subtrees cost one flag test.
+ World matrices are multiplied with SSE, normal matrices of all changed nodes are then inverted
+ four at a time with one SIMD lane per matrix.
+ With a job system the nodes are updated level by level, the nodes of a level in parallel ranges.
+*/
+class SceneGraph
+{
+public:
+	typedef int Node;
+	static const Node none = -1;
+
+	struct Counters {
+		//nodes recomputed by the last update
+		size_t updated = 0;
+		size_t total = 0;
+	};
+private:
+	std::vector<Node> parents;
+	std::vector<glm::mat4> localMatrices;
+	std::vector<glm::mat4> worldMatrices;
+	//inverse transpose of the upper 3x3 of the world matrix
+	std::vector<glm::mat3> normalMatrices;
+	std::vector<uint8_t> dirty;
+	//nodes by distance to their root, for the parallel update
+	std::vector<std::vector<Node>> levels;
+	std::vector<int> depths;
+	//nodes recomputed by the current update, reused between updates
+	std::vector<Node> changed;
+	Counters counters;
+	Counters totalCounters;
+	unsigned long updates;
+
+	//recomputes the world matrix if the node or its parent is dirty and marks it dirty, false if it was clean
+	bool updateNode(Node node);
+public:
+	SceneGraph();
+
+	//appends a node, the parent has to exist already
+	Node addNode(const glm::mat4& localMatrix, Node parent = none);
+	void setLocalMatrix(Node node, const glm::mat4& localMatrix);
+	const glm::mat4& getLocalMatrix(Node node) const;
+	Node getParent(Node node) const;
+	size_t size() const;
+
+	//recomputes the world and normal matrices of changed nodes and their descendants, on the jobs if given
+	void update(JobSystem* jobs = nullptr);
+	//valid after update()
+	const glm::mat4& getWorldMatrix(Node node) const;
+	const glm::mat3& getNormalMatrix(Node node) const;
+
+	Counters getCounters() const;
+	//updated sums all updates, total sums the sizes at each update
+	Counters getTotalCounters() const;
+	unsigned long getUpdateCount() const;
+
+	//result = a * b, result may be a or b
+	static void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result);
+	//normals[n] = inverse(transpose(mat3(matrices[n]))) for the count nodes n in nodes
+	static void computeNormalMatrices(const glm::mat4* matrices, glm::mat3* normals, const Node* nodes, size_t count);
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+/*
+ Layout shared by the memory mapped file formats (MeshFile, SceneFile): a header followed by
+ sections of tightly packed structures at aligned offsets, addressed by offset and size.
+*/
+namespace SectionFile
+{
+	//alignment of every section in a file
+	const uint64_t alignment = 64;
+
+	struct Section {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	//appends a section at the next aligned offset
+	template<typename T> Section addSection(std::vector<char>& sections, uint64_t headerSize, const T* data, size_t count)
+	{
+		size_t offset = size_t(headerSize) + sections.size();
+		offset = (offset + size_t(alignment) - 1) / size_t(alignment) * size_t(alignment);
+		size_t size = count * sizeof(T);
+		sections.resize(offset - size_t(headerSize) + size, 0);
+		if (size > 0) std::memcpy(sections.data() + offset - size_t(headerSize), data, size);
+		return { offset, size };
+	}
+
+	inline bool validSection(const Section& section, size_t fileSize, size_t elementSize, size_t count)
+	{
+		return section.offset % alignment == 0 && section.size == count * elementSize && section.offset + section.size <= fileSize;
+	}
+}
@@ -1,4 +1,13 @@
 #include "Shader.h"
+#include <cstring>
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "GLTrace.h"
+
+Shader::UniformStatistics Shader::frameStatistics;
+Shader::UniformStatistics Shader::totalStatistics;
+GLuint Shader::usedProgram = 0;
+unsigned long Shader::frame = 0;
 
 void Shader::handleError(GLuint shaderId)
 {
@@ -27,14 +36,18 @@ GLuint Shader::loadShaders()
 	if (!loadShader(this->vertexShader,GL_VERTEX_SHADER,vertexShader)) {
 		handleError(vertexShader);
 		glDeleteShader(vertexShader);
+#ifdef _WIN32
 		system("PAUSE");
+#endif
 		exit(1);
 	}
 	if (!loadShader(this->fragmentShader, GL_FRAGMENT_SHADER, fragmentShader)) {
 		handleError(fragmentShader);
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
+#ifdef _WIN32
 		system("PAUSE");
+#endif
 		exit(1);
 	}
 
@@ -72,13 +85,19 @@ GLuint Shader::loadShaders()
 			std::cout << c;
 		}
 		// In this simple program, we'll just leave
+#ifdef _WIN32
 		system("PAUSE");
+#endif
 		exit(1);
 	}
 	// Always detach shaders after a successful link.
 	glDetachShader(program, vertexShader);
 	glDetachShader(program, fragmentShader);
 
+	//the binary is the closest to the driver memory of a program we can ask for
+	GLint binaryLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	MemoryTracker::allocate(MemoryTracker::PROGRAMS, program, size_t(binaryLength), this->vertexShader + " + " + this->fragmentShader);
 	return program;
 }
 
@@ -86,6 +105,16 @@ GLuint Shader::loadShaders()
 bool Shader::loadShader(std::string filePath, GLenum shaderType, GLuint & shaderHandle)
 {
 	std::string shaderSource = readFile("./assets/shader/" + filePath);
+	if (!defines.empty())
+	{
+		std::string defineLines;
+		for (const std::string& define : defines)
+		{
+			defineLines += "#define " + define + "\n";
+		}
+		size_t versionEnd = shaderSource.find('\n') + 1;
+		shaderSource.insert(versionEnd, defineLines);
+	}
 	shaderHandle = glCreateShader(shaderType);
 	const GLchar *source = (const GLchar *)shaderSource.c_str();
 	glShaderSource(shaderHandle, 1, &source, 0);
@@ -100,9 +129,6 @@ bool Shader::loadShader(std::string filePath, GLenum shaderType, GLuint & shader
 GLint Shader::getUniformLocation(std::string location)
 {
 	auto search = locations.find(location);
-	GLint locationId = glGetUniformLocation(handle, location.c_str());
-	locations.insert(std::make_pair(location, locationId));
-	return locationId;
 	if (search != locations.end()) 
 	{
 		return search->second;
@@ -115,6 +141,41 @@ GLint Shader::getUniformLocation(std::string location)
 	}
 }
 
+/*
+ Compares value against the shadow copy of location and stores it if it differs.
+ Returns true if the value has to be uploaded.
+*/
+bool Shader::updateShadow(GLint location, GLenum type, const void * value, GLsizei size)
+{
+	if (location < 0) return false;
+	auto search = uniformShadow.find(location);
+	if (search != uniformShadow.end() && search->second.type == type && std::memcmp(search->second.data, value, size) == 0)
+	{
+		++frameStatistics.skipped;
+		++totalStatistics.skipped;
+		return false;
+	}
+	UniformValue& shadow = uniformShadow[location];
+	shadow.type = type;
+	shadow.size = size;
+	std::memcpy(shadow.data, value, size);
+	if (dirtyFrame != frame)
+	{
+		dirtyLocations.clear();
+		dirtyFrame = frame;
+	}
+	if (dirtyLocations.insert(location).second)
+	{
+		++frameStatistics.changed;
+		++totalStatistics.changed;
+	}
+	++frameStatistics.uploads;
+	++totalStatistics.uploads;
+	RenderStatistics::add(RenderStatistics::UNIFORM_CALLS);
+	RenderStatistics::add(RenderStatistics::UNIFORM_BYTES, size);
+	return true;
+}
+
 std::string Shader::readFile(std::string filePath)
 {
 	std::ifstream shaderFile;
@@ -122,7 +183,9 @@ std::string Shader::readFile(std::string filePath)
 	shaderFile.open(filePath);
 	if (!shaderFile) {
 		std::cout << "Failed to load shader " << filePath << std::endl;
+#ifdef _WIN32
 		system("PAUSE");
+#endif
 		exit(1);
 	}
 
@@ -147,6 +210,14 @@ Shader::Shader(std::string vertexShader, std::string fragmentShader)
 	this->handle = loadShaders();
 }
 
+Shader::Shader(std::string vertexShader, std::string fragmentShader, std::vector<std::string> defines)
+{
+	this->vertexShader = vertexShader;
+	this->fragmentShader = fragmentShader;
+	this->defines = defines;
+	this->handle = loadShaders();
+}
+
 void Shader::setUniform(std::string uniform, const glm::vec3& value)
 {
 	GLint location = getUniformLocation(uniform);
@@ -155,7 +226,10 @@ void Shader::setUniform(std::string uniform, const glm::vec3& value)
 
 void Shader::setUnifrom(GLint location, const glm::vec3& value)
 {
-	glUniform3f(location, value.x, value.y, value.z);
+	if (updateShadow(location, GL_FLOAT_VEC3, &value[0], sizeof(glm::vec3)))
+	{
+		glProgramUniform3f(handle, location, value.x, value.y, value.z);
+	}
 }
 
 void Shader::setUniform(std::string uniform, const int value)
@@ -166,7 +240,10 @@ void Shader::setUniform(std::string uniform, const int value)
 
 void Shader::setUniform(GLint location, const int value)
 {
-	glUniform1i(location, value);
+	if (updateShadow(location, GL_INT, &value, sizeof(int)))
+	{
+		glProgramUniform1i(handle, location, value);
+	}
 }
 
 void Shader::setUniform(std::string uniform, const float value)
@@ -177,7 +254,10 @@ void Shader::setUniform(std::string uniform, const float value)
 
 void Shader::setUniform(GLint location, const float value)
 {
-	glUniform1f(location, value);
+	if (updateShadow(location, GL_FLOAT, &value, sizeof(float)))
+	{
+		glProgramUniform1f(handle, location, value);
+	}
 }
 
 void Shader::setUniform(std::string uniform, const glm::mat4 & mat)
@@ -188,7 +268,10 @@ void Shader::setUniform(std::string uniform, const glm::mat4 & mat)
 
 void Shader::setUniform(GLint location, const glm::mat4 & mat)
 {
-	glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+	if (updateShadow(location, GL_FLOAT_MAT4, &mat[0][0], sizeof(glm::mat4)))
+	{
+		glProgramUniformMatrix4fv(handle, location, 1, GL_FALSE, &mat[0][0]);
+	}
 }
 
 void Shader::setUniform(std::string uniform, const glm::mat3 & mat)
@@ -199,19 +282,50 @@ void Shader::setUniform(std::string uniform, const glm::mat3 & mat)
 
 void Shader::setUniform(GLint location, const glm::mat3 & mat)
 {
-	glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
+	if (updateShadow(location, GL_FLOAT_MAT3, &mat[0][0], sizeof(glm::mat3)))
+	{
+		glProgramUniformMatrix3fv(handle, location, 1, GL_FALSE, &mat[0][0]);
+	}
 }
 
 void Shader::use()
 {
+	//all programs are bound through use(), so the last one is still bound
+	if (handle == usedProgram) return;
+	RenderStatistics::add(RenderStatistics::PROGRAM_SWITCHES);
+	usedProgram = handle;
 	glUseProgram(handle);
 }
 
 void Shader::unuse()
 {
+	usedProgram = 0;
 	glUseProgram(0);
 }
 
+GLuint Shader::getHandle() const
+{
+	return handle;
+}
+
+/*
+ Resets the per frame upload counters, the dirty sets of the programs are cleared on their next upload
+*/
+void Shader::beginFrame()
+{
+	frameStatistics = UniformStatistics();
+	++frame;
+}
+
+Shader::UniformStatistics Shader::getFrameStatistics()
+{
+	return frameStatistics;
+}
+
+Shader::UniformStatistics Shader::getTotalStatistics()
+{
+	return totalStatistics;
+}
 
 Shader::~Shader()
 {
@@ -219,6 +333,9 @@ Shader::~Shader()
 	GLsizei numberOfShaders;
 	glGetAttachedShaders(handle, 2, &numberOfShaders, attachedShaders);
 	glDeleteProgram(handle);
+	//a new program may get the same name
+	if (usedProgram == handle) usedProgram = 0;
+	MemoryTracker::release(MemoryTracker::PROGRAMS, handle);
 	for (int i = 0; i < numberOfShaders; ++i) 
 	{
 		glDeleteShader(attachedShaders[i]);
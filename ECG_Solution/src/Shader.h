@@ -1,28 +1,63 @@
 #pragma once
-#include <Gl/glew.h>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <memory>
 
 class Shader
 {
+public:
+	//Uniform upload counters, summed over all programs
+	struct UniformStatistics {
+		unsigned long uploads = 0;
+		unsigned long skipped = 0;
+		//distinct locations uploaded, per program and frame
+		unsigned long changed = 0;
+	};
 private:
+	//CPU-side copy of the last value uploaded to a location
+	struct UniformValue {
+		GLenum type;
+		GLsizei size;
+		GLfloat data[16];
+	};
+
 	GLuint handle;
 	std::string vertexShader, fragmentShader;
+	std::vector<std::string> defines;
 	std::unordered_map<std::string, GLint> locations;
+	std::unordered_map<GLint, UniformValue> uniformShadow;
+	//locations uploaded in dirtyFrame, cleared by the first upload of a later frame
+	std::unordered_set<GLint> dirtyLocations;
+	unsigned long dirtyFrame = 0;
+
+	static UniformStatistics frameStatistics;
+	static UniformStatistics totalStatistics;
+	//counted up by beginFrame()
+	static unsigned long frame;
+	//program of the last use(), to count switches
+	static GLuint usedProgram;
 
 	void handleError(GLuint shaderId);
 	GLuint loadShaders();
 	bool loadShader(std::string source, GLenum shaderType, GLuint& shaderHandle);
 
-	GLint getUniformLocation(std::string location);
+	bool updateShadow(GLint location, GLenum type, const void* value, GLsizei size);
 
 	std::string readFile(std::string filePath);
 public:
 	Shader();
 	Shader(std::string vertexShader, std::string fragmentShader);
+	//defines are inserted as "#define NAME" after the #version line of both stages
+	Shader(std::string vertexShader, std::string fragmentShader, std::vector<std::string> defines);
+
+	//cached, uniforms set every frame can be set by location to skip the lookup
+	GLint getUniformLocation(std::string location);
 
 	void setUniform(std::string uniform, const glm::vec3& value);
 	void setUnifrom(GLint location, const glm::vec3& value);
@@ -36,7 +71,12 @@ public:
 	void setUniform(GLint location, const glm::mat3& mat);
 	void use();
 	void unuse();
+	GLuint getHandle() const;
 	~Shader();
 
+	static void beginFrame();
+	static UniformStatistics getFrameStatistics();
+	static UniformStatistics getTotalStatistics();
+
 };
 
@@ -0,0 +1,84 @@
+#include "Simulation.h"
+#include "Profiler.h"
+#include <algorithm>
+
+Simulation::Simulation(const Camera& camera, double timestep)
+	: camera(camera), timestep(timestep), stopping(false), steps(0), dropped(0)
+{
+	thread = std::thread(&Simulation::run, this);
+}
+
+Simulation::~Simulation()
+{
+	stopping = true;
+	thread.join();
+}
+
+void Simulation::setInput(const Input& input)
+{
+	inputs.getBack() = input;
+	inputs.publish();
+}
+
+void Simulation::run()
+{
+	Input input;
+	State current;
+	current.cameraPosition = camera.getPosition();
+	current.cameraDirection = camera.getDirection();
+	Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timestep));
+	Clock::time_point next = Clock::now();
+	while (!stopping)
+	{
+		if (inputs.update()) input = inputs.getFront();
+		State previous = current;
+		{
+			PROFILE_ZONE("Simulation step");
+			camera.update(input.mouseX, input.mouseY, input.zoom, input.dragging, input.strafing);
+			current.time += timestep;
+			current.cameraPosition = camera.getPosition();
+			current.cameraDirection = camera.getDirection();
+		}
+		Snapshot& snapshot = snapshots.getBack();
+		snapshot.previous = previous;
+		snapshot.current = current;
+		snapshot.published = Clock::now();
+		snapshot.step = ++steps;
+		snapshots.publish();
+
+		next += step;
+		Clock::time_point now = Clock::now();
+		//far behind, e.g. after a breakpoint: skip ahead instead of running the missed steps back to back
+		if (now - next > std::chrono::milliseconds(250))
+		{
+			dropped += (unsigned long)((now - next) / step);
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+bool Simulation::getState(State& state)
+{
+	snapshots.update();
+	const Snapshot& snapshot = snapshots.getFront();
+	if (snapshot.step == 0) return false;
+	//one step behind the simulation, from the state before the newest step to the one after it
+	double alpha = std::chrono::duration<double>(Clock::now() - snapshot.published).count() / timestep;
+	alpha = std::min(1.0, std::max(0.0, alpha));
+	float weight = float(alpha);
+	state.time = snapshot.previous.time + (snapshot.current.time - snapshot.previous.time) * alpha;
+	state.cameraPosition = glm::mix(snapshot.previous.cameraPosition, snapshot.current.cameraPosition, weight);
+	state.cameraDirection = glm::normalize(glm::mix(snapshot.previous.cameraDirection, snapshot.current.cameraDirection, weight));
+	return true;
+}
+
+unsigned long Simulation::getStepCount() const
+{
+	return steps;
+}
+
+unsigned long Simulation::getDroppedCount() const
+{
+	return dropped;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "TripleBuffer.h"
+
+/*
+ Camera and scene clock stepped on their own thread with a fixed timestep. Every step publishes a
+ snapshot of the state before and after it through a triple buffer, the render thread takes the newest
+ one and interpolates between the two by the time passed since it was published. A slow frame then
+ doesn't slow the simulation down and a slow step doesn't stall presentation.
+ The scene's animation is a function of the time, the render thread evaluates the scene graph at the
+ interpolated time instead of blending matrices.
+*/
+class Simulation
+{
+public:
+	//latest input from the window, posted by the thread that polls the events
+	struct Input {
+		int mouseX = 0;
+		int mouseY = 0;
+		float zoom = 8.0f;
+		bool dragging = false;
+		bool strafing = false;
+	};
+
+	struct State {
+		//seconds since the simulation started
+		double time = 0.0;
+		glm::vec3 cameraPosition = glm::vec3(0.0f);
+		glm::vec3 cameraDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	};
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Snapshot {
+		State previous;
+		State current;
+		Clock::time_point published;
+		unsigned long step = 0;
+	};
+
+	Camera camera;
+	double timestep;
+	TripleBuffer<Input> inputs;
+	TripleBuffer<Snapshot> snapshots;
+	std::atomic<bool> stopping;
+	std::atomic<unsigned long> steps;
+	//steps skipped because the simulation fell too far behind
+	std::atomic<unsigned long> dropped;
+	std::thread thread;
+
+	void run();
+public:
+	//steps a copy of camera every timestep seconds
+	Simulation(const Camera& camera, double timestep);
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+	~Simulation();
+
+	void setInput(const Input& input);
+	/*!
+	 * State of the newest snapshot interpolated to now, for the render thread
+	 * @return false until the first step was published
+	 */
+	bool getState(State& state);
+
+	unsigned long getStepCount() const;
+	unsigned long getDroppedCount() const;
+};
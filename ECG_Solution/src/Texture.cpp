@@ -1,36 +1,217 @@
 #include "Texture.h"
 #include "Utils.h"
+#include "DDSFile.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include <chrono>
+#include <algorithm>
+#include "GLTrace.h"
 
 
-Texture::Texture(std::string path)
+/*
+ sRGB variant of a compressed DDS format
+*/
+static GLenum srgbFormat(GLenum format)
 {
-	DDSImage img = loadDDS(path.c_str());
-	if (img.size == 0) {
+	switch (format)
+	{
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	default: return format;
+	}
+}
+
+Texture::Texture(std::string path, bool srgb) : Texture(0)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	DDSTexture img;
+	if (!loadDDSFile(path, img)) {
 		std::cout << "Couldn't loade image file " << path << std::endl;
 	}else {
-		glGenTextures(1, &handle);
-		glBindTexture(GL_TEXTURE_2D, handle);
-		glCompressedTexImage2D(GL_TEXTURE_2D, 0, img.format, img.width, img.height, 0, img.size, img.image);
+		upload(img, srgb);
+
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - start;
+		std::cout << "Loaded " << path << ": " << img.width << "x" << img.height << ", " << levels << " levels"
+			<< (img.levels.size() == 1 ? " (generated)" : "") << ", " << memorySize / 1024 << " KB, " << loadTime.count() << "ms" << std::endl;
+	}
+}
+
+Texture::Texture(const DDSTexture& img, bool srgb) : Texture(0)
+{
+	upload(img, srgb);
+}
+
+Texture::Texture(GLuint placeholder) : handle(0), loading(0), placeholder(placeholder), resident(false), used(false),
+	levels(0), internalFormat(GL_NONE), width(0), height(0), droppedLevels(0), memorySize(0)
+{
+}
+
+void Texture::upload(const DDSTexture& img, bool srgb)
+{
+	allocate(img, srgb);
+	for (GLint level = 0; level < GLint(img.levels.size()); ++level)
+	{
+		//straight from the file mapping, no copy on the heap
+		uploadLevel(img, level, img.levels[level].data);
+	}
+	finishUpload(img);
+}
+
+void Texture::allocate(const DDSTexture& img, bool srgb)
+{
+	//mips are only generated if the file has none, the driver can't do it well for compressed formats
+	GLsizei levelCount = img.levels.size() == 1 ? fullMipCount(img.width, img.height) : GLsizei(img.levels.size());
+	internalFormat = srgb ? srgbFormat(img.format) : img.format;
+
+	glGenTextures(1, &loading);
+	glBindTexture(GL_TEXTURE_2D, loading);
+	glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, img.width, img.height);
+	MemoryTracker::allocate(MemoryTracker::TEXTURES, loading, MemoryTracker::getTextureSize(internalFormat, img.width, img.height, levelCount), "Texture");
+	// set the texture wrapping/filtering options (on the currently bound texture object)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::uploadLevel(const DDSTexture& img, GLint level, const void* data)
+{
+	const DDSTexture::Level& size = img.levels[level];
+	glBindTexture(GL_TEXTURE_2D, loading);
+	glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, size.width, size.height, internalFormat, GLsizei(size.size), data);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::finishUpload(const DDSTexture& img)
+{
+	if (img.levels.size() == 1)
+	{
+		glBindTexture(GL_TEXTURE_2D, loading);
 		glGenerateMipmap(GL_TEXTURE_2D);
-		// set the texture wrapping/filtering options (on the currently bound texture object)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glBindTexture(GL_TEXTURE_2D, 0);
 	}
+	glDeleteTextures(1, &handle);
+	MemoryTracker::release(MemoryTracker::TEXTURES, handle);
+	handle = loading;
+	loading = 0;
+
+	levels = img.levels.size() == 1 ? fullMipCount(img.width, img.height) : GLsizei(img.levels.size());
+	width = img.width;
+	height = img.height;
+	droppedLevels = 0;
+	levelSizes.clear();
+	memorySize = 0;
+	for (GLsizei level = 0; level < levels; ++level)
+	{
+		unsigned int levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+		levelSizes.push_back(size_t((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * (img.format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16));
+		memorySize += levelSizes.back();
+	}
+	resident = true;
 }
 
 Texture::~Texture()
 {
 	glDeleteTextures(1, &handle);
+	glDeleteTextures(1, &loading);
+	MemoryTracker::release(MemoryTracker::TEXTURES, handle);
+	MemoryTracker::release(MemoryTracker::TEXTURES, loading);
 	std::cout << "Texture deleted" << std::endl;
 }
 
 void Texture::activateTexture(int unit)
 {
-	glBindTexture(GL_TEXTURE_2D, handle);
 	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, resident ? handle : placeholder);
+	RenderStatistics::add(RenderStatistics::TEXTURE_BINDS);
 
 }
 
+size_t Texture::getMemorySize() const
+{
+	return memorySize;
+}
+
+bool Texture::isResident() const
+{
+	return resident;
+}
+
+void Texture::markUsed()
+{
+	used = true;
+}
+
+bool Texture::consumeUsed()
+{
+	bool wasUsed = used;
+	used = false;
+	return wasUsed;
+}
+
+GLsizei Texture::getDroppedLevels() const
+{
+	return droppedLevels;
+}
+
+GLsizei Texture::getLevelCount() const
+{
+	return levels;
+}
+
+unsigned int Texture::getWidth() const
+{
+	return width;
+}
+
+void Texture::dropTopLevel()
+{
+	if (!resident) return;
+	if (levels <= 1)
+	{
+		evict();
+		return;
+	}
+
+	//copied on the GPU, the file isn't needed until the full resolution is requested again
+	GLuint reduced;
+	glGenTextures(1, &reduced);
+	glBindTexture(GL_TEXTURE_2D, reduced);
+	glTexStorage2D(GL_TEXTURE_2D, levels - 1, internalFormat, std::max(1u, width / 2), std::max(1u, height / 2));
+	MemoryTracker::allocate(MemoryTracker::TEXTURES, reduced, memorySize - levelSizes.front(), "Texture");
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	for (GLsizei level = 1; level < levels; ++level)
+	{
+		GLsizei levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+		glCopyImageSubData(handle, GL_TEXTURE_2D, level, 0, 0, 0, reduced, GL_TEXTURE_2D, level - 1, 0, 0, 0, levelWidth, levelHeight, 1);
+	}
+	glDeleteTextures(1, &handle);
+	MemoryTracker::release(MemoryTracker::TEXTURES, handle);
+	handle = reduced;
+
+	--levels;
+	++droppedLevels;
+	width = std::max(1u, width / 2);
+	height = std::max(1u, height / 2);
+	memorySize -= levelSizes.front();
+	levelSizes.erase(levelSizes.begin());
+}
+
+void Texture::evict()
+{
+	glDeleteTextures(1, &handle);
+	MemoryTracker::release(MemoryTracker::TEXTURES, handle);
+	handle = 0;
+	resident = false;
+	droppedLevels += levels;
+	levels = 0;
+	width = height = 0;
+	levelSizes.clear();
+	memorySize = 0;
+}
@@ -1,14 +1,59 @@
 #pragma once
 #include <string>
-#include <Gl/glew.h>
+#include <vector>
+#include <GL/glew.h>
+
+struct DDSTexture;
+
 class Texture
 {
+	friend class TextureStreamer;
+	friend class TextureArray;
 private:
 	GLuint handle;
+	//storage that is being uploaded, replaces handle when complete
+	GLuint loading;
+	//bound instead of handle until all levels are uploaded
+	GLuint placeholder;
+	bool resident;
+	//set when bound for drawing, cleared by the TextureManager every frame
+	bool used;
+	GLsizei levels;
+	GLenum internalFormat;
+	unsigned int width;
+	unsigned int height;
+	//top levels that were dropped to save memory
+	GLsizei droppedLevels;
+	//bytes of each resident level and of all of them in video memory
+	std::vector<size_t> levelSizes;
+	size_t memorySize;
+
+	Texture(GLuint placeholder);
+	void upload(const DDSTexture& img, bool srgb);
+	void allocate(const DDSTexture& img, bool srgb);
+	//data is a client pointer or an offset into the bound pixel unpack buffer
+	void uploadLevel(const DDSTexture& img, GLint level, const void* data);
+	void finishUpload(const DDSTexture& img);
 public:
-	Texture(std::string path);
+	//color textures are sampled as sRGB, pass srgb = false for data like specular maps
+	Texture(std::string path, bool srgb = true);
+	//uploads an already parsed image, which can be released afterwards
+	Texture(const DDSTexture& img, bool srgb = true);
 	~Texture();
 
 	void activateTexture(int unit);
+	size_t getMemorySize() const;
+	bool isResident() const;
+
+	void markUsed();
+	//returns if the texture was used since the last call and clears the flag
+	bool consumeUsed();
+	GLsizei getDroppedLevels() const;
+	GLsizei getLevelCount() const;
+	unsigned int getWidth() const;
+	//replaces the storage with a copy of all levels but the largest one
+	void dropTopLevel();
+	//frees the storage, the placeholder is bound until it is uploaded again
+	void evict();
 };
 
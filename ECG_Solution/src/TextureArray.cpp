@@ -0,0 +1,80 @@
+#include "TextureArray.h"
+#include "Texture.h"
+#include "DDSFile.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include <iostream>
+#include <algorithm>
+#include "GLTrace.h"
+
+TextureArray::TextureArray(GLsizei capacity)
+	: handle(0), internalFormat(GL_NONE), width(0), height(0), levels(0), capacity(capacity)
+{
+}
+
+TextureArray::~TextureArray()
+{
+	glDeleteTextures(1, &handle);
+	MemoryTracker::release(MemoryTracker::TEXTURES, handle);
+}
+
+int TextureArray::addTexture(const std::string& path, bool srgb)
+{
+	auto found = std::find(paths.begin(), paths.end(), path);
+	if (found != paths.end())
+	{
+		return int(found - paths.begin());
+	}
+
+	DDSTexture img;
+	if (!loadDDSFile(path, img))
+	{
+		std::cout << "Couldn't loade image file " << path << std::endl;
+		return -1;
+	}
+	//uploaded as a 2D texture first so missing mips are generated for this layer only
+	Texture texture(img, srgb);
+	if (handle == 0)
+	{
+		internalFormat = texture.internalFormat;
+		width = texture.width;
+		height = texture.height;
+		levels = texture.levels;
+		glGenTextures(1, &handle);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, capacity);
+		MemoryTracker::allocate(MemoryTracker::TEXTURES, handle, MemoryTracker::getTextureSize(internalFormat, width, height, levels, capacity), "Texture array");
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	if (texture.internalFormat != internalFormat || texture.width != width || texture.height != height
+		|| texture.levels != levels || GLsizei(paths.size()) == capacity)
+	{
+		std::cout << "Texture " << path << " doesn't fit the texture array" << std::endl;
+		return -1;
+	}
+
+	GLint layer = GLint(paths.size());
+	for (GLsizei level = 0; level < levels; ++level)
+	{
+		GLsizei levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+		glCopyImageSubData(texture.handle, GL_TEXTURE_2D, level, 0, 0, 0, handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelWidth, levelHeight, 1);
+	}
+	paths.push_back(path);
+	return layer;
+}
+
+void TextureArray::bind(int unit)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
+	RenderStatistics::add(RenderStatistics::TEXTURE_BINDS);
+}
+
+GLsizei TextureArray::getLayerCount() const
+{
+	return GLsizei(paths.size());
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+/*
+ Same sized, same format '.dds' textures packed into the layers of one GL_TEXTURE_2D_ARRAY,
+ so materials can select their texture by layer index instead of a binding.
+*/
+class TextureArray
+{
+private:
+	GLuint handle;
+	GLenum internalFormat;
+	unsigned int width;
+	unsigned int height;
+	GLsizei levels;
+	GLsizei capacity;
+	std::vector<std::string> paths;
+public:
+	TextureArray(GLsizei capacity);
+	~TextureArray();
+
+	//returns the layer of the file, the same layer for a path that was added before, -1 if it doesn't fit the array
+	int addTexture(const std::string& path, bool srgb = true);
+	void bind(int unit);
+	GLsizei getLayerCount() const;
+};
@@ -0,0 +1,96 @@
+#include "TextureManager.h"
+#include <vector>
+#include <algorithm>
+
+TextureManager::TextureManager(TextureStreamer& streamer, size_t budget)
+	: streamer(streamer), budget(budget), frame(0)
+{
+}
+
+std::shared_ptr<Texture> TextureManager::get(const std::string& path, bool srgb)
+{
+	auto found = textures.find(path);
+	if (found != textures.end())
+	{
+		return found->second.texture;
+	}
+	Entry entry = { streamer.load(path, srgb), srgb, frame, true, 0 };
+	textures.emplace(path, entry);
+	return entry.texture;
+}
+
+void TextureManager::update()
+{
+	++frame;
+	frameCounters = Counters();
+
+	size_t residentBytes = 0;
+	size_t requestedBytes = 0;
+	std::vector<std::pair<const std::string, Entry>*> candidates;
+	for (auto& texture : textures)
+	{
+		Entry& entry = texture.second;
+		if (entry.texture->consumeUsed())
+		{
+			entry.lastUse = frame - 1;
+		}
+		if (entry.reloading && entry.texture->isResident() && entry.texture->getDroppedLevels() == 0)
+		{
+			entry.reloading = false;
+			entry.fullSize = entry.texture->getMemorySize();
+		}
+		residentBytes += entry.texture->getMemorySize();
+		candidates.push_back(&texture);
+		if (entry.lastUse + 1 >= frame && !entry.reloading && entry.texture->getDroppedLevels() > 0)
+		{
+			requestedBytes += entry.fullSize - entry.texture->getMemorySize();
+		}
+	}
+	//room for the used textures that wait for their full resolution
+	size_t target = budget > requestedBytes ? budget - requestedBytes : 0;
+
+	//evict least recently used first, never what was drawn in the last frame
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<const std::string, Entry>* a, const std::pair<const std::string, Entry>* b) {
+		return a->second.lastUse < b->second.lastUse;
+	});
+	for (auto* candidate : candidates)
+	{
+		Entry& entry = candidate->second;
+		if (residentBytes <= target || entry.lastUse + 1 >= frame) break;
+		while (residentBytes > target && entry.texture->isResident() && !entry.reloading)
+		{
+			residentBytes -= entry.texture->getMemorySize();
+			if (entry.texture->getWidth() > minimumSize) entry.texture->dropTopLevel();
+			else entry.texture->evict();
+			residentBytes += entry.texture->getMemorySize();
+			++frameCounters.evictions;
+		}
+	}
+
+	//bring back what was used, if the full resolution fits
+	for (auto& texture : textures)
+	{
+		Entry& entry = texture.second;
+		if (entry.reloading || entry.texture->getDroppedLevels() == 0 || entry.lastUse + 1 < frame) continue;
+		if (residentBytes - entry.texture->getMemorySize() + entry.fullSize > budget) continue;
+		residentBytes += entry.fullSize - entry.texture->getMemorySize();
+		streamer.reload(entry.texture, texture.first, entry.srgb);
+		entry.reloading = true;
+		++frameCounters.reuploads;
+	}
+
+	frameCounters.residentBytes = residentBytes;
+	totalCounters.residentBytes = residentBytes;
+	totalCounters.evictions += frameCounters.evictions;
+	totalCounters.reuploads += frameCounters.reuploads;
+}
+
+TextureManager::Counters TextureManager::getFrameCounters() const
+{
+	return frameCounters;
+}
+
+TextureManager::Counters TextureManager::getTotalCounters() const
+{
+	return totalCounters;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Texture.h"
+#include "TextureStreamer.h"
+
+/*
+ Shares textures by path and keeps their video memory below a budget.
+ Over budget the least recently used textures lose their largest level
+ (down to minimumSize, then they are evicted), used textures are streamed
+ back to full resolution once they fit again.
+*/
+class TextureManager
+{
+public:
+	static const unsigned int minimumSize = 64;
+
+	struct Counters {
+		size_t residentBytes = 0;
+		unsigned long evictions = 0;
+		unsigned long reuploads = 0;
+	};
+private:
+	struct Entry {
+		std::shared_ptr<Texture> texture;
+		bool srgb;
+		unsigned long lastUse;
+		//full resolution was requested from the streamer and isn't resident yet
+		bool reloading;
+		//memory of the full resolution, known after the first upload
+		size_t fullSize;
+	};
+
+	TextureStreamer& streamer;
+	size_t budget;
+	unsigned long frame;
+	std::unordered_map<std::string, Entry> textures;
+	Counters frameCounters;
+	Counters totalCounters;
+public:
+	TextureManager(TextureStreamer& streamer, size_t budget);
+
+	//the same texture for every request of a path, the srgb flag of the first request is used
+	std::shared_ptr<Texture> get(const std::string& path, bool srgb = true);
+	//records usage of the last frame, evicts and requests reloads, call once per frame
+	void update();
+
+	Counters getFrameCounters() const;
+	Counters getTotalCounters() const;
+};
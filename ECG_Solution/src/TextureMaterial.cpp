@@ -26,6 +26,7 @@ void TextureMaterial::setUniforms(int textureUnit)
 {
 	shader->use();
 	texture->activateTexture(textureUnit);
+	texture->markUsed();
 	shader->setUniform("materialCoefficients.diffuseTexture", textureUnit);
 	shader->setUniform("materialCoefficients.ambient", ambient);
 	shader->setUniform("materialCoefficients.diffuse", diffuse);
@@ -0,0 +1,167 @@
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include <iostream>
+#include <cstring>
+
+TextureStreamer::TextureStreamer(double uploadBudget, unsigned int threadCount)
+	: uploadBudget(uploadBudget), pending(0), stopping(false), nextLevel(0)
+{
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_SRGB8_ALPHA8, 1, 1);
+	MemoryTracker::allocate(MemoryTracker::TEXTURES, placeholder, MemoryTracker::getTextureSize(GL_SRGB8_ALPHA8, 1, 1, 1), "Streaming placeholder");
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenBuffers(1, &pixelBuffer);
+
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		workers.emplace_back(&TextureStreamer::work, this);
+	}
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	glDeleteBuffers(1, &pixelBuffer);
+	glDeleteTextures(1, &placeholder);
+	MemoryTracker::release(MemoryTracker::STAGING_BUFFERS, pixelBuffer);
+	MemoryTracker::release(MemoryTracker::TEXTURES, placeholder);
+}
+
+std::shared_ptr<Texture> TextureStreamer::load(std::string path, bool srgb)
+{
+	std::shared_ptr<Texture> texture(new Texture(placeholder));
+	reload(texture, path, srgb);
+	return texture;
+}
+
+void TextureStreamer::reload(const std::shared_ptr<Texture>& texture, std::string path, bool srgb)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.push_back({ texture, path, srgb, std::chrono::high_resolution_clock::now() });
+	}
+	condition.notify_one();
+	++pending;
+}
+
+void TextureStreamer::work()
+{
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !requests.empty(); });
+			if (stopping) return;
+			request = requests.front();
+			requests.pop_front();
+		}
+		std::unique_ptr<Loaded> result = std::make_unique<Loaded>();
+		{
+			PROFILE_ZONE("Load texture");
+			result->request = request;
+			result->valid = !request.texture.expired() && loadDDSFile(request.path, result->image);
+			if (result->valid)
+			{
+				result->image.file->prefetch();
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		loaded.push_back(std::move(result));
+	}
+}
+
+void TextureStreamer::uploadLevel(Texture& texture)
+{
+	const DDSTexture& image = current->image;
+	GLsizeiptr size = GLsizeiptr(image.levels[nextLevel].size);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	//orphan the previous storage so the driver doesn't wait for the last upload
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	MemoryTracker::allocate(MemoryTracker::STAGING_BUFFERS, pixelBuffer, size_t(size), "Texture upload");
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	bool staged = mapped != nullptr;
+	if (staged)
+	{
+		std::memcpy(mapped, image.levels[nextLevel].data, size);
+		//false if the storage was lost while mapped, e.g. on a mode switch
+		staged = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+	}
+	if (staged)
+	{
+		texture.uploadLevel(image, nextLevel, nullptr);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		//mapping failed, upload straight from the decoded file instead
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		texture.uploadLevel(image, nextLevel, image.levels[nextLevel].data);
+	}
+	++nextLevel;
+}
+
+void TextureStreamer::update()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> elapsed(0);
+	while (elapsed.count() < uploadBudget)
+	{
+		if (!current)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (loaded.empty()) break;
+			current = std::move(loaded.front());
+			loaded.pop_front();
+			nextLevel = 0;
+		}
+
+		std::shared_ptr<Texture> texture = current->request.texture.lock();
+		if (!texture || !current->valid)
+		{
+			if (texture)
+			{
+				std::cout << "Couldn't loade image file " << current->request.path << std::endl;
+			}
+			current.reset();
+			--pending;
+			continue;
+		}
+
+		if (nextLevel == 0 && texture->loading == 0)
+		{
+			texture->allocate(current->image, current->request.srgb);
+		}
+		if (nextLevel < GLint(current->image.levels.size()))
+		{
+			uploadLevel(*texture);
+		}
+		else
+		{
+			texture->finishUpload(current->image);
+			std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - current->request.requestTime;
+			std::cout << "Streamed " << current->request.path << ": " << current->image.width << "x" << current->image.height << ", "
+				<< texture->levels << " levels, " << texture->memorySize / 1024 << " KB, resident after " << loadTime.count() << "ms" << std::endl;
+			current.reset();
+			--pending;
+		}
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+	}
+}
+
+size_t TextureStreamer::getPendingCount() const
+{
+	return pending;
+}
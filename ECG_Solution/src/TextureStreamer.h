@@ -0,0 +1,66 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <GL/glew.h>
+
+#include "Texture.h"
+#include "DDSFile.h"
+
+/*
+ Loads textures in the background. Worker threads map the '.dds' files and fault their pages in,
+ the GL thread uploads them level by level through a pixel unpack buffer in update(),
+ stopping once the per frame budget is used up. Until then a texture samples a 1x1 placeholder.
+*/
+class TextureStreamer
+{
+private:
+	struct Request {
+		std::weak_ptr<Texture> texture;
+		std::string path;
+		bool srgb;
+		std::chrono::high_resolution_clock::time_point requestTime;
+	};
+	struct Loaded {
+		Request request;
+		DDSTexture image;
+		bool valid;
+	};
+
+	GLuint placeholder;
+	GLuint pixelBuffer;
+	//ms of uploads per update
+	double uploadBudget;
+	size_t pending;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping;
+	std::deque<Request> requests;
+	std::deque<std::unique_ptr<Loaded>> loaded;
+
+	//texture that is currently uploaded and its next level
+	std::unique_ptr<Loaded> current;
+	GLint nextLevel;
+
+	void work();
+	void uploadLevel(Texture& texture);
+public:
+	TextureStreamer(double uploadBudget, unsigned int threadCount = 2);
+	~TextureStreamer();
+
+	//the texture is usable right away and shows the placeholder until it is resident
+	std::shared_ptr<Texture> load(std::string path, bool srgb = true);
+	//uploads all levels of the file again, the texture keeps its current storage until then
+	void reload(const std::shared_ptr<Texture>& texture, std::string path, bool srgb = true);
+	//uploads loaded textures, call once per frame on the GL thread
+	void update();
+	//number of requested textures that are not resident yet
+	size_t getPendingCount() const;
+};
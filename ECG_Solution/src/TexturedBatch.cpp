@@ -0,0 +1,186 @@
+#include "TexturedBatch.h"
+#include "RenderStatistics.h"
+#include "MemoryTracker.h"
+#include "DrawList.h"
+#include "GLTrace.h"
+
+TexturedBatch::TexturedBatch(std::shared_ptr<Shader> shader, GLsizei maxTextures)
+	: shader(shader), textures(maxTextures), culled(0), vao(0), vboPositions(0), vboNormals(0), vboUV(0), vboDrawIndices(0),
+	vboIndices(0), drawBuffer(0), materialBuffer(0), commandBuffer(0), uploaded(false)
+{
+}
+
+TexturedBatch::~TexturedBatch()
+{
+	GLuint buffers[] = { vboPositions, vboNormals, vboUV, vboDrawIndices, vboIndices, drawBuffer, materialBuffer, commandBuffer };
+	glDeleteBuffers(8, buffers);
+	glDeleteVertexArrays(1, &vao);
+	const MemoryTracker::Category categories[] = { MemoryTracker::VERTEX_BUFFERS, MemoryTracker::VERTEX_BUFFERS, MemoryTracker::VERTEX_BUFFERS,
+		MemoryTracker::VERTEX_BUFFERS, MemoryTracker::INDEX_BUFFERS, MemoryTracker::UNIFORM_BUFFERS, MemoryTracker::UNIFORM_BUFFERS, MemoryTracker::UNIFORM_BUFFERS };
+	for (int i = 0; i < 8; ++i)
+	{
+		MemoryTracker::release(categories[i], buffers[i]);
+	}
+}
+
+int TexturedBatch::addMaterial(const std::string& texturePath, float ambient, float diffuse, float specular, float specularCoefficient)
+{
+	int layer = textures.addTexture(texturePath);
+	if (layer < 0) return -1;
+	materials.push_back({ ambient, diffuse, specular, specularCoefficient, GLuint(layer) });
+	return int(materials.size()) - 1;
+}
+
+void TexturedBatch::addGeometry(glm::mat4 modelMatrix, const GeometryData& geometryData, int material, const glm::vec4& boundingSphere)
+{
+	DrawCommand command;
+	command.count = GLuint(geometryData.indices.size());
+	command.instanceCount = 1;
+	command.firstIndex = GLuint(indices.size());
+	command.baseVertex = GLint(positions.size());
+	command.baseInstance = GLuint(draws.size());
+	commands.push_back(command);
+
+	DrawData draw;
+	draw.modelMatrix = modelMatrix;
+	draw.normalMatrix = glm::mat4(glm::mat3(glm::inverse(glm::transpose(modelMatrix))));
+	draw.material = GLuint(material);
+	draws.push_back(draw);
+	spheres.push_back(boundingSphere);
+
+	positions.insert(positions.end(), geometryData.positions.begin(), geometryData.positions.end());
+	normals.insert(normals.end(), geometryData.normals.begin(), geometryData.normals.end());
+	uvs.insert(uvs.end(), geometryData.uv.begin(), geometryData.uv.end());
+	indices.insert(indices.end(), geometryData.indices.begin(), geometryData.indices.end());
+}
+
+void TexturedBatch::upload()
+{
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vboPositions);
+	glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+	glGenBuffers(1, &vboNormals);
+	glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
+	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+	glGenBuffers(1, &vboUV);
+	glBindBuffer(GL_ARRAY_BUFFER, vboUV);
+	glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+	//draw index at location 3, one per instance, the base instance of a command selects its entry
+	std::vector<GLuint> drawIndices(draws.size());
+	for (size_t i = 0; i < drawIndices.size(); ++i)
+	{
+		drawIndices[i] = GLuint(i);
+	}
+	glGenBuffers(1, &vboDrawIndices);
+	glBindBuffer(GL_ARRAY_BUFFER, vboDrawIndices);
+	glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, 0, 0);
+	glVertexAttribDivisor(3, 1);
+
+	glGenBuffers(1, &vboIndices);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &drawBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, draws.size() * sizeof(DrawData), draws.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &materialBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, materialBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(MaterialData), materials.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glGenBuffers(1, &commandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboPositions, positions.size() * sizeof(glm::vec3), "Batch positions");
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboNormals, normals.size() * sizeof(glm::vec3), "Batch normals");
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboUV, uvs.size() * sizeof(glm::vec2), "Batch uvs");
+	MemoryTracker::allocate(MemoryTracker::VERTEX_BUFFERS, vboDrawIndices, drawIndices.size() * sizeof(GLuint), "Batch draw indices");
+	MemoryTracker::allocate(MemoryTracker::INDEX_BUFFERS, vboIndices, indices.size() * sizeof(unsigned int), "Batch indices");
+	MemoryTracker::allocate(MemoryTracker::UNIFORM_BUFFERS, drawBuffer, draws.size() * sizeof(DrawData), "Batch draws");
+	MemoryTracker::allocate(MemoryTracker::UNIFORM_BUFFERS, materialBuffer, materials.size() * sizeof(MaterialData), "Batch materials");
+	MemoryTracker::allocate(MemoryTracker::UNIFORM_BUFFERS, commandBuffer, commands.size() * sizeof(DrawCommand), "Batch commands");
+
+	//the CPU copies aren't needed anymore
+	positions = std::vector<glm::vec3>();
+	normals = std::vector<glm::vec3>();
+	uvs = std::vector<glm::vec2>();
+	indices = std::vector<unsigned int>();
+	uploaded = true;
+}
+
+void TexturedBatch::cull(const glm::mat4& viewProjectionMatrix)
+{
+	if (!uploaded) return;
+	DrawList::Frustum frustum = DrawList::getFrustum(viewProjectionMatrix);
+	bool changed = false;
+	culled = 0;
+	for (size_t i = 0; i < commands.size(); ++i)
+	{
+		GLuint instanceCount = DrawList::intersects(frustum, spheres[i]) ? 1 : 0;
+		changed |= commands[i].instanceCount != instanceCount;
+		commands[i].instanceCount = instanceCount;
+		culled += 1 - instanceCount;
+	}
+	//the command buffer is only written when the visible set changed
+	if (changed)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawCommand), commands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
+void TexturedBatch::draw()
+{
+	if (!uploaded || commands.size() == culled) return;
+	shader->use();
+	textures.bind(textureUnit);
+	shader->setUniform("diffuseTextures", textureUnit);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, drawBinding, drawBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, materialBinding, materialBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBindVertexArray(vao);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GLsizei(commands.size()), 0);
+	glBindVertexArray(0);
+	unsigned long long indexCount = 0;
+	for (const DrawCommand& command : commands)
+	{
+		indexCount += command.count * command.instanceCount;
+	}
+	RenderStatistics::add(RenderStatistics::VERTEX_ARRAY_BINDS);
+	RenderStatistics::add(RenderStatistics::DRAW_CALLS);
+	RenderStatistics::add(RenderStatistics::TRIANGLES, indexCount / 3);
+	RenderStatistics::add(RenderStatistics::VERTICES, indexCount);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	shader->unuse();
+}
+
+size_t TexturedBatch::getCulledCount() const
+{
+	return culled;
+}
+
+std::shared_ptr<Shader> TexturedBatch::getShader()
+{
+	return shader;
+}
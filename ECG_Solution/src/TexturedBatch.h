@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Geometry.h"
+#include "TextureArray.h"
+
+/*
+ Textured geometry that is drawn with one program and one glMultiDrawElementsIndirect.
+ Meshes share one vertex and index buffer, textures are layers of a TextureArray and
+ materials and model matrices live in shader storage buffers. The shader is
+ diffuseTexture compiled with BATCHED, it finds its draw through the instanced
+ drawIndex attribute which is offset by the base instance of each command.
+ Culled draws stay in the command buffer with an instance count of 0.
+*/
+class TexturedBatch
+{
+public:
+	static const GLuint drawBinding = 0;
+	static const GLuint materialBinding = 1;
+	static const int textureUnit = 0;
+private:
+	//std430 layouts of the shader storage blocks
+	struct DrawData {
+		glm::mat4 modelMatrix;
+		glm::mat4 normalMatrix;
+		GLuint material;
+		GLuint padding[3];
+	};
+	struct MaterialData {
+		float ambient;
+		float diffuse;
+		float specular;
+		float specularCoefficient;
+		GLuint layer;
+	};
+	struct DrawCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	std::shared_ptr<Shader> shader;
+	TextureArray textures;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<unsigned int> indices;
+	std::vector<DrawData> draws;
+	std::vector<MaterialData> materials;
+	std::vector<DrawCommand> commands;
+	//world space bounding sphere of each draw, for culling
+	std::vector<glm::vec4> spheres;
+	size_t culled;
+
+	GLuint vao;
+	GLuint vboPositions;
+	GLuint vboNormals;
+	GLuint vboUV;
+	GLuint vboDrawIndices;
+	GLuint vboIndices;
+	GLuint drawBuffer;
+	GLuint materialBuffer;
+	GLuint commandBuffer;
+	bool uploaded;
+public:
+	TexturedBatch(std::shared_ptr<Shader> shader, GLsizei maxTextures = 16);
+	~TexturedBatch();
+
+	//returns the material index, -1 if the texture doesn't fit the texture array
+	int addMaterial(const std::string& texturePath, float ambient, float diffuse, float specular, float specularCoefficient);
+	//the model matrix is fixed once added, boundingSphere is in world space
+	void addGeometry(glm::mat4 modelMatrix, const GeometryData& geometryData, int material, const glm::vec4& boundingSphere);
+	//creates the GL buffers, call after everything is added
+	void upload();
+	//skips the draws outside the view frustum by setting their instance count to 0
+	void cull(const glm::mat4& viewProjectionMatrix);
+	void draw();
+	size_t getCulledCount() const;
+
+	std::shared_ptr<Shader> getShader();
+};
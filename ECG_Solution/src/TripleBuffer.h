@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+
+/*
+ Lock-free hand over of the newest value from one writer thread to one reader thread.
+ The writer fills the back slot and publishes it by swapping it with the middle slot, the reader
+ swaps its front slot with the middle one when that holds a newer value. Neither side ever waits,
+ values published twice before the reader looks are dropped, the reader always gets the newest.
+*/
+template<typename T> class TripleBuffer
+{
+private:
+	static const unsigned int indexMask = 3;
+	//set on the middle index while it holds a value the reader hasn't taken
+	static const unsigned int fresh = 4;
+
+	T slots[3];
+	std::atomic<unsigned int> middle;
+	//only used by their thread
+	unsigned int back;
+	unsigned int front;
+public:
+	TripleBuffer() : middle(1), back(0), front(2) {}
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	//writer: the slot to fill, keeps its contents from two publishes ago
+	T& getBack() { return slots[back]; }
+	//writer: makes the back slot the newest value
+	void publish()
+	{
+		back = middle.exchange(back | fresh, std::memory_order_acq_rel) & indexMask;
+	}
+
+	//reader: takes the newest value if there is one, false if the front slot is still the newest
+	bool update()
+	{
+		if (!(middle.load(std::memory_order_acquire) & fresh)) return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	//reader: valid until the next update
+	const T& getFront() const { return slots[front]; }
+};
@@ -7,21 +7,32 @@
 
 #include "INIReader.h"
 #include <iostream>
-#include <Windows.h>
+#include <cstdlib>
 #include <memory>
-#include <GL\glew.h>
-#include <GLFW\glfw3.h>
-#include <glm\gtc\matrix_transform.hpp>
-#include <glm\glm.hpp>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/glm.hpp>
 
+//the console stays open on Windows
+#ifdef _WIN32
 #define EXIT_WITH_ERROR(err) \
 	std::cout << "ERROR: " << err << std::endl; \
 	system("PAUSE"); \
 	return EXIT_FAILURE;
+#else
+#define EXIT_WITH_ERROR(err) \
+	std::cout << "ERROR: " << err << std::endl; \
+	return EXIT_FAILURE;
+#endif
+
+#define ECG_FOURCC(a, b, c, d) \
+	((unsigned int)(unsigned char)(a) | ((unsigned int)(unsigned char)(b) << 8) | \
+	((unsigned int)(unsigned char)(c) << 16) | ((unsigned int)(unsigned char)(d) << 24))
 
-#define FOURCC_DXT1	MAKEFOURCC('D', 'X', 'T', '1')
-#define FOURCC_DXT3	MAKEFOURCC('D', 'X', 'T', '3')
-#define FOURCC_DXT5	MAKEFOURCC('D', 'X', 'T', '5')
+#define FOURCC_DXT1	ECG_FOURCC('D', 'X', 'T', '1')
+#define FOURCC_DXT3	ECG_FOURCC('D', 'X', 'T', '3')
+#define FOURCC_DXT5	ECG_FOURCC('D', 'X', 'T', '5')
 
 /*!
  * A loaded '.dss' image
@@ -47,6 +58,7 @@ public:
 		height = img.height;
 		size = img.size;
 		format = img.format;
+		return *this;
 	};
 
 	~DDSImage() { if (image != nullptr) { delete[] image; image = nullptr; } }
@@ -0,0 +1,280 @@
+#version 430 core
+
+#define _DIRECTIONAL_LIGHTS_COUNT 64
+#define _POINT_LIGHTS_COUNT 64
+#define _SPOT_LIGHT_COUNT 64
+
+const float PI = 3.1415926535;
+
+struct PointLight {
+	vec3 color;
+	vec3 position;
+	vec3 attenuation;
+};
+
+struct DirectionalLight {
+	vec3 color;
+	vec3 direction;
+};
+
+struct SpotLight {
+	vec3 color;
+	vec3 position;
+	vec3 direction;
+	float innerOpeningAngle;
+	float outerOpeningAngle;
+	vec3 attenuation;
+};
+
+struct Material {
+	vec3 baseColor;
+	float ambient;
+	float metallic;
+	float specular;
+	float specularTint;
+	float roughness;
+	float sheen;
+	float sheenTint;
+	float clearcoat;
+	float clearcoatGloss;
+};
+
+//Camera stuff
+uniform vec3 cameraPosition;
+uniform mat4 inverseViewProjectionMatrix;
+
+//G-buffer, see GBuffer.h
+uniform sampler2D gNormal;
+uniform sampler2D gBaseColor;
+uniform sampler2D gMaterial;
+uniform sampler2D gSheenClearcoat;
+uniform sampler2D gDepth;
+
+//Material of the current pixel, read from the G-buffer
+Material materialCoefficients;
+
+//Lights
+uniform PointLight pointLights[_POINT_LIGHTS_COUNT];
+uniform DirectionalLight directionalLights[_DIRECTIONAL_LIGHTS_COUNT];
+uniform SpotLight spotLights[_SPOT_LIGHT_COUNT];
+uniform int nrPointLight;
+uniform int nrDirLight;
+uniform int nrSpotLight;
+
+//Image based lighting, precomputed by ImageBasedLighting
+uniform samplerCube irradianceMap;
+uniform samplerCube prefilteredMap;
+uniform sampler2D brdfLUT;
+uniform float prefilteredMaxLod;
+
+out vec4 fragmentColor;
+
+vec3 decodeNormal(vec2 e){
+	e = e * 2.0f - 1.0f;
+	vec3 n = vec3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+	float t = clamp(-n.z, 0.0f, 1.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+float SchlickFresnel(float u){
+	float r = clamp(1.0f-u,0.0f,1.0f);
+	float r2 = r * r;
+	return r2*r2*r; //(1-u)^5
+	
+}
+
+//for clearcoat
+float GTR1(float NdotH, float alpha){
+	float alpha2 = alpha * alpha;
+	float denumUnnorm = 1 + (alpha2 - 1) * NdotH * NdotH;
+	return (alpha2-1)/(PI*log(alpha2)*denumUnnorm);
+
+}
+
+//for normal
+float GTR2(float NdotH, float alpha){
+	float alpha2 = alpha * alpha;
+	float denum = 1+(alpha2-1)*NdotH*NdotH;
+	return alpha2/(PI * denum * denum);
+}
+
+float smithG(float NdotV, float alpha){
+	float a = alpha*alpha;
+	float b = NdotV*NdotV;
+	return 1.0f/(NdotV+sqrt(a+b-a*b));
+}
+
+vec3 diffuse(float LdotH,float LdotN, float VdotN, vec3 linearBaseColor){
+	float FD90 = 0.5f + 2.0f * LdotH*LdotH*materialCoefficients.roughness;   
+	float Fl = SchlickFresnel(LdotN);
+	float Fv = SchlickFresnel(VdotN);
+	return linearBaseColor/PI * mix(1.0f,FD90,Fl)*mix(1.0f,FD90,Fv)*LdotN;
+}
+
+vec3 specular(float NdotH, float LdotH, float NdotV, float NdotL, vec3 specColor, vec3 cSheen){
+	//Normal
+	float alpha = max(0.001,materialCoefficients.roughness * materialCoefficients.roughness);
+	//Specular D from microfacet distribution
+	float DH = GTR2(NdotH,alpha);
+	//Specular Fresnel Term
+	float FH = SchlickFresnel(LdotH); //(1-cos(Omega_d))^5
+	vec3 Fs = mix(specColor,vec3(1.0f),FH);
+	//G term: Geometric attenuation / shadowing
+	alpha = (0.5 + 0,5 * materialCoefficients.roughness);
+	alpha*=alpha;
+	float G = smithG(NdotV,alpha);
+
+	G *= smithG(NdotL,alpha);
+	
+	//Clearcoat F0 = 0.04
+	float Dc = GTR1(NdotH,mix(0.1,0.001,materialCoefficients.clearcoatGloss));
+	vec3 Fc = mix(vec3(0.04f),vec3(1.0f),FH);
+	float Gc = smithG(NdotV,0.25f)*smithG(NdotL,0.25f);
+	
+	//sheen
+	vec3 sheen = FH * materialCoefficients.sheen * cSheen;
+	
+	return G*Fs*DH + 0.25 * materialCoefficients.clearcoat*Dc*Fc*Gc + (1-materialCoefficients.metallic)*sheen;
+	
+}
+
+vec3 addPointLight(vec3 normal, vec3 viewingDir, vec3 lightDir, vec3 cSheen, vec3 cLinear, vec3 specColor){
+	vec3 color = vec3(0.0f);
+	vec3 h = normalize(lightDir+viewingDir);
+	float NdotH = dot(normal,h);
+	float NdotV = dot(normal,viewingDir);
+	float NdotL = dot(normal,lightDir);
+	float LdotH = dot(lightDir,h);
+	if (NdotL < 0 || NdotV < 0) return vec3(0.0f);
+	//diffuse
+	color +=(1.0f-materialCoefficients.metallic)*diffuse(LdotH,NdotL,NdotV,cLinear);
+	
+	color += specular(NdotH, LdotH, NdotV, NdotL, specColor, cSheen);
+	
+	return color;
+}
+
+vec3 addDirectionalLight(vec3 normal, vec3 viewingDir,  DirectionalLight light, vec3 cSheen, vec3 cLinear, vec3 specColor){
+	vec3 color = vec3(0.0f);
+	vec3 h = normalize(-light.direction+viewingDir);
+	float NdotH = dot(normal,h);
+	float NdotV = dot(normal,viewingDir);
+	float NdotL = dot(normal,-light.direction);
+	float LdotH = dot(-light.direction,h);
+	if (NdotL < 0 || NdotV < 0) return vec3(0.0f);
+	color+=(1.0f-materialCoefficients.metallic)*diffuse(LdotH,NdotL,NdotV,cLinear);
+	
+	color += specular(NdotH, LdotH, NdotV, NdotL, specColor, cSheen);
+	
+	return color;
+}
+
+vec3 gammaCorrection(vec3 color){
+	return pow(color,vec3(1.0f/2.2f));
+}
+
+vec3 addSpotLight(vec3 normal, vec3 viewingDir, vec3 lightDir, SpotLight light, vec3 cSheen, vec3 cLinear, vec3 specColor){
+	vec3 color = vec3(0.0f);
+	float outerCos = cos(light.outerOpeningAngle);
+	float innerCos = cos(light.innerOpeningAngle);
+	float directionCos = dot(lightDir,-light.direction);
+	float interpolationT = 1.0f-smoothstep(innerCos,outerCos,directionCos);
+	
+	vec3 h = normalize(lightDir+viewingDir);
+	float NdotH = dot(normal,h);
+	float NdotV = dot(normal,viewingDir);
+	float NdotL = dot(normal,lightDir);
+	float LdotH = dot(lightDir,h);
+	if (NdotL < 0 || NdotV < 0) return vec3(0);
+	color += (1.0f-materialCoefficients.metallic)*diffuse(LdotH,NdotL,NdotV,cLinear);
+	
+	color += specular(NdotH, LdotH, NdotV, NdotL, specColor, cSheen);
+	
+	color *= interpolationT;
+
+	return color;
+}
+
+//split-sum approximation: diffuse irradiance + prefiltered radiance * (F0 * scale + bias)
+vec3 ambientLight(vec3 normal, vec3 viewingDir, vec3 cLinear, vec3 specColor){
+	float NdotV = clamp(dot(normal,viewingDir),0.0f,1.0f);
+	vec3 r = reflect(-viewingDir,normal);
+	vec3 irradiance = texture(irradianceMap,normal).rgb;
+	vec3 prefiltered = textureLod(prefilteredMap,r,materialCoefficients.roughness*prefilteredMaxLod).rgb;
+	vec2 brdf = texture(brdfLUT,vec2(NdotV,materialCoefficients.roughness)).rg;
+	return (1.0f-materialCoefficients.metallic)*irradiance*cLinear + prefiltered*(specColor*brdf.x+brdf.y);
+}
+
+void main() {
+	
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	if (depth == 1.0f) discard; //background
+	
+	vec4 baseColorMetallic = texelFetch(gBaseColor, pixel, 0);
+	vec4 material = texelFetch(gMaterial, pixel, 0);
+	vec4 sheenClearcoat = texelFetch(gSheenClearcoat, pixel, 0);
+	materialCoefficients.baseColor = baseColorMetallic.rgb;
+	materialCoefficients.metallic = baseColorMetallic.a;
+	materialCoefficients.roughness = material.r;
+	materialCoefficients.specular = material.g;
+	materialCoefficients.specularTint = material.b;
+	materialCoefficients.ambient = material.a;
+	materialCoefficients.sheen = sheenClearcoat.r;
+	materialCoefficients.sheenTint = sheenClearcoat.g;
+	materialCoefficients.clearcoat = sheenClearcoat.b;
+	materialCoefficients.clearcoatGloss = sheenClearcoat.a;
+	
+	//reconstruct world position from depth
+	vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0f - 1.0f;
+	vec4 world = inverseViewProjectionMatrix * vec4(ndc, depth * 2.0f - 1.0f, 1.0f);
+	vec3 worldPosition = world.xyz / world.w;
+	
+	vec3 v = normalize(cameraPosition - worldPosition);
+	
+	vec3 normalWorld = decodeNormal(texelFetch(gNormal, pixel, 0).rg);
+	
+	//Interpolation of Colors
+	vec3 linearBaseColor = materialCoefficients.baseColor; //linearized by PBRMaterial
+	float luminance = 0.2*linearBaseColor.r + 0.7*linearBaseColor.g + 0.1 * linearBaseColor.b;
+	
+	vec3 lumNormColor = luminance>0?linearBaseColor/luminance:vec3(1.0f); //only hue and sat
+	vec3 specColor = mix(materialCoefficients.specular*0.08*mix(vec3(1.0f),lumNormColor,materialCoefficients.specularTint), 
+							linearBaseColor,
+							materialCoefficients.metallic);
+	vec3 sheenColor = mix(vec3(1.0f),lumNormColor,materialCoefficients.sheenTint);
+	
+	//Ambient Lights, image based, ambient coefficient scales the environment
+	vec3 color = materialCoefficients.ambient*ambientLight(normalWorld, v, linearBaseColor, specColor);
+	
+	for(int i = 0; i<nrPointLight; ++i){
+		PointLight light = pointLights[i];
+		vec3 l = light.position - worldPosition.xyz;
+		float d = length(l);
+		l = normalize(l);
+		float attenuation = 1/(light.attenuation.x*d*d+light.attenuation.y*d+light.attenuation.z);
+		color+=addPointLight(normalWorld, v, l, sheenColor, linearBaseColor, specColor)*attenuation*light.color;
+	}
+	
+	for(int i = 0; i< nrDirLight; ++i){
+		DirectionalLight light = directionalLights[i];
+		color += addDirectionalLight(normalWorld,v,light, sheenColor, linearBaseColor, specColor)*light.color;
+	}
+	for(int i = 0; i < nrSpotLight; ++i){
+		SpotLight light = spotLights[i];
+		vec3 l = light.position - worldPosition.xyz;
+		float d = length(l);
+		l = normalize(l);
+		float attenuation = 1/(light.attenuation.x*d*d+light.attenuation.y*d+light.attenuation.z);
+		color+=addSpotLight(normalWorld, v, l, light, sheenColor, linearBaseColor,specColor)*attenuation*light.color;
+	}
+	
+#ifdef SOFTWARE_SRGB
+	//per fragment encoding, only compiled to measure its cost against the hardware sRGB path
+	fragmentColor = vec4(gammaCorrection(color),1);
+#else
+	fragmentColor = vec4(color,1); //encoded by GL_FRAMEBUFFER_SRGB
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 430 core
+
+//Full screen triangle, no vertex buffers needed
+void main() {
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,46 @@
+#version 430 core
+
+struct Material {
+	vec3 baseColor;
+	float ambient;
+	float metallic;
+	float specular;
+	float specularTint;
+	float roughness;
+	float sheen;
+	float sheenTint;
+	float clearcoat;
+	float clearcoatGloss;
+};
+
+in struct VertexData {
+	vec3 worldPosition;
+	vec3 normal;
+} vert;
+
+//Material
+uniform Material materialCoefficients;
+
+//G-buffer targets, see GBuffer.h
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gBaseColor;
+layout(location = 2) out vec4 gMaterial;
+layout(location = 3) out vec4 gSheenClearcoat;
+
+vec2 signNotZero(vec2 v){
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+//octahedral normal encoding, mapped to [0,1] for the unorm target
+vec2 encodeNormal(vec3 n){
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.z >= 0.0f ? n.xy : (1.0f - abs(n.yx)) * signNotZero(n.xy);
+	return e * 0.5f + 0.5f;
+}
+
+void main() {
+	gNormal = encodeNormal(normalize(vert.normal));
+	gBaseColor = vec4(materialCoefficients.baseColor, materialCoefficients.metallic);
+	gMaterial = vec4(materialCoefficients.roughness, materialCoefficients.specular, materialCoefficients.specularTint, materialCoefficients.ambient);
+	gSheenClearcoat = vec4(materialCoefficients.sheen, materialCoefficients.sheenTint, materialCoefficients.clearcoat, materialCoefficients.clearcoatGloss);
+}
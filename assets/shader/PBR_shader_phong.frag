@@ -58,6 +58,12 @@ uniform int nrPointLight;
 uniform int nrDirLight;
 uniform int nrSpotLight;
 
+//Image based lighting, precomputed by ImageBasedLighting
+uniform samplerCube irradianceMap;
+uniform samplerCube prefilteredMap;
+uniform sampler2D brdfLUT;
+uniform float prefilteredMaxLod;
+
 out vec4 fragmentColor;
 
 float SchlickFresnel(float u){
@@ -157,10 +163,6 @@ vec3 gammaCorrection(vec3 color){
 	return pow(color,vec3(1.0f/2.2f));
 }
 
-vec3 toLinearColorspace(vec3 color){
-	return pow(color,vec3(2.2f));
-}
-
 vec3 addSpotLight(vec3 normal, vec3 viewingDir, vec3 lightDir, SpotLight light, vec3 cSheen, vec3 cLinear, vec3 specColor){
 	vec3 color = vec3(0.0f);
 	float outerCos = cos(light.outerOpeningAngle);
@@ -183,6 +185,16 @@ vec3 addSpotLight(vec3 normal, vec3 viewingDir, vec3 lightDir, SpotLight light,
 	return color;
 }
 
+//split-sum approximation: diffuse irradiance + prefiltered radiance * (F0 * scale + bias)
+vec3 ambientLight(vec3 normal, vec3 viewingDir, vec3 cLinear, vec3 specColor){
+	float NdotV = clamp(dot(normal,viewingDir),0.0f,1.0f);
+	vec3 r = reflect(-viewingDir,normal);
+	vec3 irradiance = texture(irradianceMap,normal).rgb;
+	vec3 prefiltered = textureLod(prefilteredMap,r,materialCoefficients.roughness*prefilteredMaxLod).rgb;
+	vec2 brdf = texture(brdfLUT,vec2(NdotV,materialCoefficients.roughness)).rg;
+	return (1.0f-materialCoefficients.metallic)*irradiance*cLinear + prefiltered*(specColor*brdf.x+brdf.y);
+}
+
 void main() {
 	
 	vec3 worldPosition = vert.worldPosition;
@@ -192,7 +204,7 @@ void main() {
 	vec3 normalWorld = normalize(vert.normal);
 	
 	//Interpolation of Colors
-	vec3 linearBaseColor = toLinearColorspace(materialCoefficients.baseColor);
+	vec3 linearBaseColor = materialCoefficients.baseColor; //linearized by PBRMaterial
 	float luminance = 0.2*linearBaseColor.r + 0.7*linearBaseColor.g + 0.1 * linearBaseColor.b;
 	
 	vec3 lumNormColor = luminance>0?linearBaseColor/luminance:vec3(1.0f); //only hue and sat
@@ -201,8 +213,8 @@ void main() {
 							materialCoefficients.metallic);
 	vec3 sheenColor = mix(vec3(1.0f),lumNormColor,materialCoefficients.sheenTint);
 	
-	//Ambient Lights	
-	vec3 color = vec3(pow(materialCoefficients.ambient,2.2)*linearBaseColor); // to make it consistant with base models
+	//Ambient Lights, image based, ambient coefficient scales the environment
+	vec3 color = materialCoefficients.ambient*ambientLight(normalWorld, v, linearBaseColor, specColor);
 	
 	for(int i = 0; i<nrPointLight; ++i){
 		PointLight light = pointLights[i];
@@ -226,5 +238,10 @@ void main() {
 		color+=addSpotLight(normalWorld, v, l, light, sheenColor, linearBaseColor,specColor)*attenuation*light.color;
 	}
 	
+#ifdef SOFTWARE_SRGB
+	//per fragment encoding, only compiled to measure its cost against the hardware sRGB path
 	fragmentColor = vec4(gammaCorrection(color),1);
+#else
+	fragmentColor = vec4(color,1); //encoded by GL_FRAMEBUFFER_SRGB
+#endif
 }
\ No newline at end of file
@@ -13,6 +13,9 @@ out struct VertexData {
 	vec3 normal;
 } vert;
 
+//drawn with GL_LEQUAL against the depth pre-pass, the depth has to match depthOnly.vert exactly
+invariant gl_Position;
+
 void main() {
 	
 	vert.normal = normalize(normalMatrix*normal);
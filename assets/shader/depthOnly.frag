@@ -0,0 +1,5 @@
+#version 430 core
+
+//Depth pre-pass, only the depth buffer is written
+void main(){
+}
\ No newline at end of file
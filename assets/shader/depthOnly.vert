@@ -0,0 +1,15 @@
+#version 430 core
+
+layout(location = 0) in vec3 position;
+
+uniform mat4 viewProjectionMatrix;
+uniform mat4 modelMatrix;
+
+//declared invariant in the shading passes too, so their depth matches the pre-pass exactly
+invariant gl_Position;
+
+void main() {
+	//same operation order as the shading passes, so depth values match
+	vec4 position_world = modelMatrix * vec4(position,1.0f);
+	gl_Position = viewProjectionMatrix * position_world;
+}
\ No newline at end of file
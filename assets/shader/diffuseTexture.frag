@@ -25,6 +25,22 @@ struct SpotLight {
 };
 
 
+#ifdef BATCHED
+struct Material {
+	float ambient;
+	float diffuse;
+	float specular;
+	float specularCoefficient;
+	uint layer;
+};
+
+layout(std430, binding = 1) readonly buffer Materials {
+	Material materials[];
+};
+
+uniform sampler2DArray diffuseTextures;
+flat in uint materialIndex;
+#else
 struct Material {
 	float ambient;
 	float diffuse;
@@ -32,6 +48,7 @@ struct Material {
 	float specularCoefficient;
 	sampler2D diffuseTexture;
 };
+#endif
 
 in struct VertexData {
 	vec3 worldPosition;
@@ -43,7 +60,11 @@ in struct VertexData {
 uniform vec3 cameraPosition;
 
 //Material
+#ifdef BATCHED
+Material materialCoefficients;
+#else
 uniform Material materialCoefficients;
+#endif
 
 //Lights
 uniform PointLight pointLights[_POINT_LIGHTS_COUNT];
@@ -101,7 +122,12 @@ void main() {
 	
 	vec3 normalWorld = normalize(vert.normal);
 	
+#ifdef BATCHED
+	materialCoefficients = materials[materialIndex];
+	vec3 diffuseColor = texture(diffuseTextures, vec3(vert.uvs, materialCoefficients.layer)).rgb;
+#else
 	vec3 diffuseColor = texture(materialCoefficients.diffuseTexture,vert.uvs).rgb;
+#endif
 	color = vec4(materialCoefficients.ambient*diffuseColor,1);
 	
 	for(int i = 0; i<nrPointLight; ++i){
@@ -5,8 +5,25 @@ layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uv;
 
 uniform mat4 viewProjectionMatrix;
+#ifdef BATCHED
+//per draw data of a multi-draw, selected by the base instance of the draw command
+layout(location = 3) in uint drawIndex;
+
+struct DrawData {
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	uint material;
+};
+
+layout(std430, binding = 0) readonly buffer Draws {
+	DrawData draws[];
+};
+
+flat out uint materialIndex;
+#else
 uniform mat4 modelMatrix;
 uniform mat3 normalMatrix;
+#endif
 
 out struct VertexData {
 	vec3 worldPosition;
@@ -14,7 +31,15 @@ out struct VertexData {
 	vec2 uvs;
 } vert;
 
+//drawn with GL_LEQUAL against the depth pre-pass, the depth has to match depthOnly.vert exactly
+invariant gl_Position;
+
 void main() {
+#ifdef BATCHED
+	mat4 modelMatrix = draws[drawIndex].modelMatrix;
+	mat3 normalMatrix = mat3(draws[drawIndex].normalMatrix);
+	materialIndex = draws[drawIndex].material;
+#endif
 	
 	vert.normal = normalize(normalMatrix*normal);
 
@@ -0,0 +1,28 @@
+# Generates a stand-in for the GLEW library that loads every entry point declared in GL/glew.h
+# with eglGetProcAddress. Used by the headless build, a system GLEW needs a GLX or WGL context in glewInit.
+
+set(GLEW_LOADER_TEMPLATE "${CMAKE_CURRENT_LIST_DIR}/glew_egl_loader.c.in")
+
+function(generate_glew_egl_loader header output)
+	file(STRINGS "${header}" functions REGEX "^GLEW_FUN_EXPORT PFN[A-Z0-9_]+PROC __glew[A-Za-z0-9_]+;")
+	file(STRINGS "${header}" variables REGEX "^GLEW_VAR_EXPORT GLboolean __GLEW_[A-Za-z0-9_]+;")
+	set(GLEW_DEFINITIONS "")
+	set(GLEW_LOADS "")
+	set(GLEW_FLAGS "")
+	foreach(line IN LISTS functions)
+		string(REGEX MATCH "(PFN[A-Z0-9_]+PROC) __glew([A-Za-z0-9_]+)" match "${line}")
+		string(APPEND GLEW_DEFINITIONS "${CMAKE_MATCH_1} __glew${CMAKE_MATCH_2} = NULL;\n")
+		string(APPEND GLEW_LOADS "\t__glew${CMAKE_MATCH_2} = (${CMAKE_MATCH_1})eglGetProcAddress(\"gl${CMAKE_MATCH_2}\");\n")
+	endforeach()
+	foreach(line IN LISTS variables)
+		string(REGEX MATCH "__GLEW_([A-Za-z0-9_]+)" match "${line}")
+		set(name "${CMAKE_MATCH_1}")
+		string(APPEND GLEW_DEFINITIONS "GLboolean __GLEW_${name} = GL_FALSE;\n")
+		if(name MATCHES "^VERSION_([0-9])_([0-9])")
+			string(APPEND GLEW_FLAGS "\t__GLEW_${name} = hasVersion(${CMAKE_MATCH_1}, ${CMAKE_MATCH_2});\n")
+		else()
+			string(APPEND GLEW_FLAGS "\t__GLEW_${name} = glewGetExtension(\"GL_${name}\");\n")
+		endif()
+	endforeach()
+	configure_file("${GLEW_LOADER_TEMPLATE}" "${output}" @ONLY)
+endfunction()